@@ -0,0 +1,59 @@
+#ifndef CPU_DISPATCH_HPP
+#define CPU_DISPATCH_HPP
+
+// Instruction sets of the hot kernels. The build targets the baseline of the
+// architecture (SSE2 on x86-64): the wider variants are compiled with function
+// target attributes and picked at run time from CPUID. Dispatched: the genome
+// kernels and the quantized and sparse forward passes, all bit-identical
+// across variants. The roulette prefix sum is not: a SIMD scan would reorder
+// its additions and make the selection depend on the CPU.
+enum class Isa
+{
+    Generic, // SSE2 on x86-64, scalar elsewhere
+    Avx2,
+    Avx512   // AVX-512 F and BW
+};
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NEURO_CAR_DISPATCH 1
+#define NEURO_CAR_TARGET_AVX2 __attribute__((target("avx2")))
+#define NEURO_CAR_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#define NEURO_CAR_DISPATCH 0
+#endif
+
+char const * isaName(Isa isa);
+
+// Widest instruction set supported by the CPU and the OS
+Isa detectIsa();
+
+// Instruction set of the kernels, selected on first call: the detected one,
+// unless the NEURO_CAR_ISA environment variable (generic, avx2 or avx512)
+// asks for another one. Variants the CPU lacks are never selected: an
+// unsupported or unknown value is ignored with a warning.
+Isa activeIsa();
+
+// True when NEURO_CAR_ISA changed the selection
+bool isaOverridden();
+
+// Variant of a kernel for the active instruction set
+template <typename Kernel>
+Kernel selectKernel(Kernel generic, Kernel avx2, Kernel avx512)
+{
+    switch(activeIsa())
+    {
+        case Isa::Avx512: return avx512;
+        case Isa::Avx2:   return avx2;
+        default:          return generic;
+    }
+}
+
+// Variant of the kernel family name##Generic, name##Avx2, name##Avx512
+#if NEURO_CAR_DISPATCH
+#define NEURO_CAR_SELECT_KERNEL(name) \
+    selectKernel(name##Generic, name##Avx2, name##Avx512)
+#else
+#define NEURO_CAR_SELECT_KERNEL(name) name##Generic
+#endif
+
+#endif //CPU_DISPATCH_HPP
@@ -0,0 +1,93 @@
+#ifndef NEURO_CAR_CURRICULUM_HPP
+#define NEURO_CAR_CURRICULUM_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace NeuroCar {
+
+struct CurriculumParams
+{
+    enum class Type
+    {
+        Linear,   // Grow linearly up to the full length over rampGenerations
+        Step,     // Grow by nlevels equal steps over rampGenerations
+        Adaptive  // Grow by growthFactor when the best fitness plateaus
+    };
+
+    Type type = Type::Linear;
+
+    // Length of the first episodes, as a fraction of the full length
+    double startFraction = 0.2;
+
+    // Linear and Step: generations to reach the full length
+    std::size_t rampGenerations = 50;
+
+    // Step: number of increases
+    uint32_t nlevels = 4;
+
+    // Adaptive: the best fitness plateaus when it did not improve by more
+    // than plateauTolerance for plateauGenerations generations
+    double plateauTolerance = 1e-3;
+    std::size_t plateauGenerations = 5;
+    double growthFactor = 1.5;
+};
+
+// Simulation spent by the evolution, compared with fixed-length episodes
+struct CurriculumStats
+{
+    uint64_t episodes = 0;
+    uint64_t budgetSteps = 0;     // Sum of the scheduled episode lengths
+    uint64_t fixedSteps = 0;      // Same sum with the full episode length
+    uint64_t simulatedSteps = 0;  // Steps actually simulated (crashes end early)
+};
+
+// Episode-length schedule of the evolution.
+// The length only changes when the world changes (every worldSeedChangeInterval
+// generations): individuals evaluated in the same world always get the same
+// budget, so that their fitnesses stay comparable, elites included.
+class EpisodeCurriculum
+{
+    public:
+        EpisodeCurriculum(
+            CurriculumParams const & params,
+            uint32_t fullLength,
+            uint32_t worldSeedChangeInterval
+        );
+
+        uint32_t getEpisodeLength(std::size_t ngen) const;
+
+        CurriculumParams const & getParams() const;
+
+        // Adaptive schedule: feed the best fitness at the end of each generation
+        void update(std::size_t ngen, double bestFitness);
+
+        // Thread-safe, called after each episode
+        void recordEpisode(uint32_t budget, uint32_t fixedBudget, uint32_t steps);
+
+        CurriculumStats getStats() const;
+
+    private:
+        std::size_t worldStart(std::size_t ngen) const;
+
+    private:
+        CurriculumParams m_params;
+        uint32_t m_fullLength;
+        uint32_t m_worldInterval;
+
+        // Adaptive state, only written by update() between generations
+        std::atomic<uint32_t> m_adaptiveLength;
+        bool m_growthPending;
+        double m_plateauFitness;
+        std::size_t m_plateauLength;
+
+        std::atomic<uint64_t> m_episodes;
+        std::atomic<uint64_t> m_budgetSteps;
+        std::atomic<uint64_t> m_fixedSteps;
+        std::atomic<uint64_t> m_simulatedSteps;
+};
+
+}
+
+#endif //NEURO_CAR_CURRICULUM_HPP
@@ -1,7 +1,9 @@
 #ifndef DNA_HPP
 #define DNA_HPP
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 template <typename T>
 using Individual = std::shared_ptr<T>;
@@ -39,9 +41,42 @@ class DNA
         virtual void init(Params const & params) = 0;
         virtual void randomize(std::size_t seed) = 0;
         virtual Fitness computeFitness(std::size_t ngen = 0) = 0;
+        // Evaluation with a fraction of the full budget (in ]0, 1]), used by
+        // racing to rank individuals early. Defaults to a full evaluation.
+        virtual Fitness computePartialFitness(std::size_t ngen, double budget);
+        // Cheaper, less accurate evaluation of the full episode, used by
+        // multi-fidelity evaluation to pick the individuals worth a full one.
+        // Defaults to a full evaluation.
+        virtual Fitness computeCoarseFitness(std::size_t ngen);
         virtual void reset() = 0;
         virtual Subject crossover(DNAType const & partner) const = 0;
+        // Crossover into child, recycling its previous subject when possible.
+        // Defaults to crossover().
+        virtual void crossoverInto(DNAType const & partner, DNAType & child) const;
         virtual void mutate(MutationRate mutationRate) = 0;
+        // Flat description of the individual for surrogate models, valid until
+        // the next change of the dna. Defaults to none (nullptr).
+        virtual float const * getFeatures(std::size_t & size) const;
+        // Replace the features, for optimizers working on them directly.
+        // Returns false if unsupported (default) or of the wrong size.
+        virtual bool setFeatures(float const * features, std::size_t size);
+        // Behavior descriptor of the last evaluation, for novelty search, valid
+        // until the next evaluation. Defaults to none (nullptr).
+        virtual float const * getBehavior(std::size_t & size) const;
+        // Objectives of the last evaluation, all maximized, for multi-objective
+        // selection. Defaults to none (nullptr).
+        virtual double const * getObjectives(std::size_t & size) const;
+        // Results of the last evaluation, to evaluate the dna in another
+        // process: the fitness (a double) first, then whatever else the dna
+        // keeps of the evaluation. Defaults to the fitness only.
+        virtual void encodeEvaluation(std::vector<char> & data) const;
+        // Restore the results of encodeEvaluation, false if malformed. The
+        // fitness alone must be accepted (evaluation given up).
+        virtual bool decodeEvaluation(char const * data, std::size_t size);
+        // Work speeding up the evaluations of generation ngen (e.g. building
+        // its world), run on another thread while the dnas change: it must
+        // not refer to the dna. Defaults to none (empty function).
+        virtual std::function<void ()> prepareEvaluation(std::size_t ngen) const;
 
     protected:
         Subject m_subject;
@@ -3,6 +3,8 @@
 
 #include "dna.hpp"
 
+#include <cstring>
+
 template <typename T, typename DNAType>
 DNA<T, DNAType>::DNA(Subject subject):
     m_subject(subject), m_fitness(0)
@@ -34,4 +36,74 @@ typename DNA<T, DNAType>::Fitness DNA<T, DNAType>::getFitness() const
     return m_fitness;
 }
 
+template <typename T, typename DNAType>
+typename DNA<T, DNAType>::Fitness DNA<T, DNAType>::computePartialFitness(
+    std::size_t ngen, double
+)
+{
+    return this->computeFitness(ngen);
+}
+
+template <typename T, typename DNAType>
+typename DNA<T, DNAType>::Fitness DNA<T, DNAType>::computeCoarseFitness(std::size_t ngen)
+{
+    return this->computeFitness(ngen);
+}
+
+template <typename T, typename DNAType>
+void DNA<T, DNAType>::crossoverInto(DNAType const & partner, DNAType & child) const
+{
+    child.setSubject(this->crossover(partner));
+}
+
+template <typename T, typename DNAType>
+float const * DNA<T, DNAType>::getFeatures(std::size_t & size) const
+{
+    size = 0;
+    return nullptr;
+}
+
+template <typename T, typename DNAType>
+bool DNA<T, DNAType>::setFeatures(float const *, std::size_t)
+{
+    return false;
+}
+
+template <typename T, typename DNAType>
+float const * DNA<T, DNAType>::getBehavior(std::size_t & size) const
+{
+    size = 0;
+    return nullptr;
+}
+
+template <typename T, typename DNAType>
+double const * DNA<T, DNAType>::getObjectives(std::size_t & size) const
+{
+    size = 0;
+    return nullptr;
+}
+
+template <typename T, typename DNAType>
+void DNA<T, DNAType>::encodeEvaluation(std::vector<char> & data) const
+{
+    char bytes[sizeof(Fitness)];
+    std::memcpy(bytes, &m_fitness, sizeof(Fitness));
+    data.insert(data.end(), bytes, bytes + sizeof(Fitness));
+}
+
+template <typename T, typename DNAType>
+bool DNA<T, DNAType>::decodeEvaluation(char const * data, std::size_t size)
+{
+    if(size < sizeof(Fitness)) return false;
+
+    std::memcpy(&m_fitness, data, sizeof(Fitness));
+    return true;
+}
+
+template <typename T, typename DNAType>
+std::function<void ()> DNA<T, DNAType>::prepareEvaluation(std::size_t) const
+{
+    return std::function<void ()>();
+}
+
 #endif //DNA_INL
@@ -3,9 +3,14 @@
 
 #include <cstddef>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <vector>
 
 #include <dna.hpp>
+#include <population_history.hpp>
+#include <thread_placement.hpp>
+#include <worker_pool.hpp>
 
 template <typename T>
 using Population = std::vector<Individual<T>>;
@@ -14,24 +19,389 @@ template <typename DNAType>
 using DNAs = std::vector<DNAType>;
 
 
+// Successive-halving racing: every individual is first evaluated with a short
+// budget, the worst ones are frozen with their partial fitness and the
+// survivors are re-evaluated with longer budgets. The last round always uses
+// the full budget, so the elites are ranked on full evaluations. The elites
+// carried over from the last generation are never frozen.
+struct RacingParams
+{
+    bool enabled = false;
+
+    // Budget of each round, as a fraction of the full evaluation
+    std::vector<double> budgets = { 0.1, 0.3, 1.0 };
+
+    // Fraction of the remaining individuals frozen after each round
+    double cullFraction = 0.5;
+
+    // Compare the racing ranking with a full evaluation every N generations
+    // (0: never). Audited generations cost a full extra evaluation.
+    std::size_t auditInterval = 0;
+};
+
+struct RacingReport
+{
+    // Fraction of the full evaluation budget saved by the racing
+    double budgetSaved = 0.0;
+
+    // Number of individuals that did not reach the last round
+    std::size_t frozen = 0;
+
+    // Set on audited generations only
+    bool audited = false;
+
+    // Spearman correlation between racing and full evaluation rankings
+    double rankCorrelation = 1.0;
+
+    // Mean absolute displacement of an individual between both rankings
+    double meanRankDisplacement = 0.0;
+};
+
+// Surrogate-assisted evaluation: a k-NN model of the fitness over the dna
+// features (DNA::getFeatures), trained on the full evaluations, predicts the
+// fitness of each child. The children predicted in the bottom quantile only
+// get a short screening run, except a random audited fraction that is fully
+// evaluated to measure the model. The elites carried over from the last
+// generation are always fully evaluated. Ignored with racing, and until the
+// model has minSamples samples.
+struct SurrogateParams
+{
+    bool enabled = false;
+
+    // Fraction of each generation, by predicted fitness, that is screened
+    double screenQuantile = 0.5;
+
+    // Fraction of the screened children fully evaluated anyway
+    double auditFraction = 0.1;
+
+    // Budget of a screening run, as a fraction of the full evaluation
+    double screenBudget = 0.1;
+
+    std::size_t neighbours = 8;
+    std::size_t capacity = 2048;  // Most recent full evaluations kept
+    std::size_t minSamples = 128;
+};
+
+struct SurrogateReport
+{
+    // False while the model lacks samples: everybody was fully evaluated
+    bool active = false;
+
+    std::size_t samples = 0;
+    std::size_t screened = 0; // Predicted in the bottom quantile
+    std::size_t audited = 0;  // Screened but fully evaluated
+
+    // Fraction of the full evaluation budget saved
+    double budgetSaved = 0.0;
+
+    // Spearman correlation between predicted and simulated fitnesses of the
+    // fully evaluated children
+    double rankCorrelation = 0.0;
+
+    // Fraction of the audited children whose simulated fitness is above the
+    // median of the fully evaluated ones
+    double auditMissRate = 0.0;
+};
+
+// Multi-fidelity evaluation: every individual is first evaluated at a coarse
+// fidelity (DNA::computeCoarseFitness), then the best contenderFraction of
+// them by coarse fitness, the elites carried over and a random audited
+// fraction of the others are evaluated again at full fidelity. When the rank
+// agreement of both tiers over the individuals evaluated twice falls below
+// minAgreement, the next fallbackGenerations generations are evaluated at
+// full fidelity only (0: the rest of the run). The last generation is always
+// fully evaluated. Ignored with racing and the surrogate.
+struct MultiFidelityParams
+{
+    bool enabled = false;
+
+    double contenderFraction = 0.2;
+    double auditFraction = 0.1;
+    double minAgreement = 0.6;
+    std::size_t fallbackGenerations = 10;
+};
+
+struct MultiFidelityReport
+{
+    // False while falling back: everybody was evaluated at full fidelity
+    bool coarse = false;
+
+    std::size_t contenders = 0; // Best coarse fitnesses and elites
+    std::size_t audited = 0;    // Others evaluated at full fidelity anyway
+
+    // Spearman correlation between the coarse and full fitnesses of the
+    // individuals evaluated at both fidelities
+    double rankCorrelation = 1.0;
+
+    // The agreement fell below minAgreement: full fidelity from the next
+    // generation on
+    bool fallback = false;
+};
+
+// Novelty search: the novelty of an individual is the mean distance of its
+// behavior (DNA::getBehavior) to the k nearest behaviors of its generation
+// and of an archive of past ones. Selection then uses
+// (1 - weight) * fitness + weight * novelty / max novelty of the generation,
+// so the fitness is expected in [0, 1]; getFitness() keeps the fitness.
+struct NoveltyParams
+{
+    bool enabled = false;
+
+    std::size_t neighbours = 15;
+
+    // Weight of the novelty in the selection score (1: pure novelty search)
+    double weight = 0.5;
+
+    // Fraction of each generation, the most novel, added to the archive
+    double archiveFraction = 0.01;
+};
+
+struct NoveltyReport
+{
+    std::size_t behaviors = 0;   // Individuals with a behavior descriptor
+    std::size_t archived = 0;    // Added to the archive this generation
+    std::size_t archiveSize = 0;
+
+    double meanNovelty = 0.0;
+    double maxNovelty = 0.0;
+};
+
+// Multi-objective selection, NSGA-II style: the dnas are ranked by
+// non-dominated sorting of their objectives (DNA::getObjectives), then by
+// crowding distance within their front. Parents are drawn by binary
+// tournament on this order instead of the roulette wheel, and the elites are
+// the first in it. Dnas without objectives rank last. Replaces the novelty
+// scores; getFitness() is unchanged.
+struct MultiObjectiveParams
+{
+    bool enabled = false;
+};
+
+struct MultiObjectiveReport
+{
+    std::size_t objectives = 0;
+    std::size_t fronts = 0;
+    std::size_t paretoSize = 0;  // Size of the first front
+};
+
+// Full evaluations in worker processes (WorkerPool) instead of the OpenMP
+// threads, so that a crash in computeFitness only loses one evaluation (its
+// dna gets a fitness of 0). A worker evaluates a copy of the first dna of the
+// population, given the features of each dna (DNA::getFeatures, setFeatures)
+// and sending back DNA::encodeEvaluation. Dnas without features are still
+// evaluated in the process. Racing and surrogate screening run in the process;
+// the full-fidelity runs of multi-fidelity evaluation go to the workers, the
+// coarse ones stay in the process. A worker stuck in a job for longer than
+// the job timeout is killed and replaced like a crashed one.
+// The workers are forked when the evolution starts: DNA parameters changed
+// afterwards (e.g. in a hook) do not reach them.
+
+// Stop criteria besides the number of generations, checked once each
+// generation is evaluated, on the best fitness of its full evaluations
+// (screened, coarse and raced out estimates do not count). A generation the
+// run stops on after racing, screening or a coarse evaluation is evaluated
+// again in full before the hooks see it.
+struct StopParams
+{
+    // Wall time budget in seconds (0: none). The next generation is not
+    // started if it would end past the deadline, lasting as long as the last.
+    double deadline = 0.0;
+
+    // Best fitness to reach
+    double targetFitness = std::numeric_limits<double>::infinity();
+
+    // Generations in a row without a better best fitness (0: none)
+    std::size_t plateau = 0;
+};
+
+enum class StopReason
+{
+    Generations,
+    Deadline,
+    TargetFitness,
+    Plateau
+};
+
+inline char const * stopReasonName(StopReason reason)
+{
+    switch(reason)
+    {
+        case StopReason::Deadline:      return "deadline";
+        case StopReason::TargetFitness: return "target fitness";
+        case StopReason::Plateau:       return "plateau";
+        default:                        return "generations";
+    }
+}
+
+// Population size controller: between two generations, the size shrinks by
+// factor every stall generations without a better best fitness, else grows
+// by factor (unless stalled) while the threads are busy less than
+// targetUtilization of the last generation (CPU time of the process over wall
+// time and threads; the small populations leave threads idle at the end of
+// the evaluation).
+struct PopulationControlParams
+{
+    bool enabled = false;
+
+    std::size_t minSize = 0;  // 0: a quarter of the initial size
+    std::size_t maxSize = 0;  // 0: 4 times the initial size
+    double factor = 1.25;
+    double targetUtilization = 0.9;
+    std::size_t stall = 5;
+};
+
+// Pipelined generations: the threads left without evaluation to run at the
+// end of a generation breed the first children of the next one, drawn from
+// the individuals already evaluated (at most speculativeFraction of the
+// children, once minRanked of the generation is evaluated); the postGenHook
+// runs on its own thread while the other children are bred; the work of
+// DNA::prepareEvaluation for the next generation runs in the background.
+// Plain evaluations and fitness-proportionate selection only: ignored with
+// racing, the surrogate, multi-fidelity, novelty, multi-objective selection,
+// worker processes and population control. Compatible with placement: the
+// evaluations stay in the shard of their node. The postGenHook must then only
+// read the dnas.
+struct PipelineParams
+{
+    bool enabled = false;
+
+    double minRanked = 0.75;
+    double speculativeFraction = 0.25;
+};
+
+struct PipelineReport
+{
+    std::size_t ranked = 0;       // Evaluated when the early breeding started
+    std::size_t speculative = 0;  // Children bred from them
+    double tailSeconds = 0.0;     // From the first idle thread to the last evaluation
+};
+
+struct PopulationReport
+{
+    std::size_t size = 0;          // Of the generation evaluated
+    std::size_t nextSize = 0;
+    double utilization = 0.0;      // Of the threads, during the generation
+    double evaluationsPerSecond = 0.0;
+};
+
+// Warm start: the initial population begins with copies of the seeds, then
+// mutated copies of them (round-robin) for mutatedFraction of the rest, the
+// others being random. The seeds must be compatible with the crossover of
+// the population (same genome size).
+template <typename Subject>
+struct WarmStartParams
+{
+    std::vector<Subject> seeds = { };  // None: cold start
+
+    double mutatedFraction = 0.5;
+    double mutationRate = 0.05;
+};
+
 template <typename DNAType>
 struct EvolutionParams
 {
     using MutationRate = double;
     using Elitism = uint32_t;
     using GenerationHook = std::function<void (std::size_t, DNAs<DNAType> const &)>;
+    using RacingHook = std::function<void (std::size_t, RacingReport const &)>;
+    using SurrogateHook = std::function<void (std::size_t, SurrogateReport const &)>;
+    using MultiFidelityHook = std::function<void (std::size_t, MultiFidelityReport const &)>;
+    using NoveltyHook = std::function<void (std::size_t, NoveltyReport const &)>;
+    using MultiObjectiveHook = std::function<void (std::size_t, MultiObjectiveReport const &)>;
+    using WorkersHook = std::function<void (std::size_t, WorkerPoolReport const &)>;
+    using StopHook = std::function<void (std::size_t, StopReason)>;
+    using PopulationHook = std::function<void (std::size_t, PopulationReport const &)>;
+    using PipelineHook = std::function<void (std::size_t, PipelineReport const &)>;
 
     MutationRate mutationRate = 0.01;
     Elitism elitism = 1;
     GenerationHook preGenHook  = GenerationHook(defaultPreGenHook);
     GenerationHook postGenHook = GenerationHook(defaultPostGenHook);
     DNAParams<DNAType> dnaParams = { };
+    RacingParams racing = { };
+    RacingHook racingHook = RacingHook(defaultRacingHook);
+    SurrogateParams surrogate = { };
+    SurrogateHook surrogateHook = SurrogateHook(defaultSurrogateHook);
+    MultiFidelityParams multiFidelity = { };
+    MultiFidelityHook multiFidelityHook = MultiFidelityHook(defaultMultiFidelityHook);
+    NoveltyParams novelty = { };
+    NoveltyHook noveltyHook = NoveltyHook(defaultNoveltyHook);
+    MultiObjectiveParams multiObjective = { };
+    MultiObjectiveHook multiObjectiveHook = MultiObjectiveHook(defaultMultiObjectiveHook);
+    WarmStartParams<typename DNAType::Subject> warmStart = { };
+    WorkerPoolParams workers = { };
+    WorkersHook workersHook = WorkersHook(defaultWorkersHook);
+    // Log of the features, fitness and parents of every individual of every
+    // generation, once evaluated (none: no log)
+    std::shared_ptr<PopulationHistory> history = nullptr;
+    StopParams stop = { };
+    // Called once, with the last generation and the reason to stop there
+    StopHook stopHook = StopHook(defaultStopHook);
+    PopulationControlParams populationControl = { };
+    PopulationHook populationHook = PopulationHook(defaultPopulationHook);
+    // Pin the threads and shard the initialization, full evaluations and
+    // breeding per NUMA node
+    ThreadPlacementParams placement = { };
+    PipelineParams pipeline = { };
+    PipelineHook pipelineHook = PipelineHook(defaultPipelineHook);
 
     private:
         static void defaultPreGenHook(std::size_t, DNAs<DNAType> const &) { }
         static void defaultPostGenHook(std::size_t, DNAs<DNAType> const &) { }
+        static void defaultRacingHook(std::size_t, RacingReport const &) { }
+        static void defaultSurrogateHook(std::size_t, SurrogateReport const &) { }
+        static void defaultMultiFidelityHook(std::size_t, MultiFidelityReport const &) { }
+        static void defaultNoveltyHook(std::size_t, NoveltyReport const &) { }
+        static void defaultMultiObjectiveHook(std::size_t, MultiObjectiveReport const &) { }
+        static void defaultWorkersHook(std::size_t, WorkerPoolReport const &) { }
+        static void defaultStopHook(std::size_t, StopReason) { }
+        static void defaultPopulationHook(std::size_t, PopulationReport const &) { }
+        static void defaultPipelineHook(std::size_t, PipelineReport const &) { }
 };
 
+// Evolve the population for at most ngenerations generations (params.stop):
+// each one is evaluated, then bred into the next one except the last. The
+// first generation is random, or warm started from params.warmStart. Its size
+// is the size of the population, then params.populationControl may change it.
+// Returns the last generation, sorted from lowest to greatest fitness.
+//
+// Cost of a generation of n individuals on p threads, elitism k, besides the
+// DNA methods (computeFitness, crossoverInto, init, mutate: once per child):
+// - roulette wheel: parallel prefix sum of the fitnesses, 2 passes over n
+//   doubles, plus an index of n/16 doubles
+// - elites: O(n/p) per thread (nth_element), then O(pk log k) serial merge
+// - selection: 2 draws per child, each a binary search of the cached index
+//   then of 16 contiguous doubles: O(log n), about 2 cache misses
+// - breeding: in place into the slots of the generation before; no DNA slot
+//   or subject is allocated once the DNA recycles its subjects
+//   (crossoverInto), besides what the subject copy allocates itself
+// - novelty search: k-d tree of the behaviors, O(n log n), then n k-nearest
+//   searches of the tree and of the archive, O(log^2 a) each
+// - multi-objective: non-dominated sorting O(m n^2 / p), with n^2 / 8 bytes
+//   of domination bits, and crowding distances O(m n log n)
+// - multi-fidelity: n coarse evaluations, then the contenders and the
+//   audited ones again at full fidelity; rank correlation O(m log m) over
+//   the m individuals evaluated twice
+// - worker processes: the features of the n dnas are copied into the
+//   requests, n results come back, both over sockets
+// - history: the features of the n dnas are copied into a buffer, written
+//   by a background thread
+// - pipeline: a shared counter per individual evaluated and per early child,
+//   a serial O(n) wheel of the evaluated individuals, a thread per generation
+//   for the postGenHook and one for DNA::prepareEvaluation
+// - placement: the individuals of a NUMA node are created, evaluated and
+//   bred by its threads; a shared counter per node and chunk of individuals
+// Every phase runs in parallel except the elite merge and the exchanges with
+// the workers.
+//
+// Memory per individual, besides the subjects: 2 DNA slots (current and next
+// generations), 8 bytes of roulette wheel, 8 bytes of selection score, 4 bytes
+// of racing round and 4 bytes of elite selection scratch, plus 8 bytes of
+// prediction with the surrogate (whose samples are bounded by its capacity)
+// or of coarse fitness with multi-fidelity evaluation, 8 bytes plus a copy of
+// the behavior with novelty search, 12 bytes plus a copy of the objectives
+// with multi-objective selection, 16 bytes of parents plus 2 generations of
+// records in flight with the history.
 template <typename DNAType, typename T>
 DNAs<DNAType> evolve(
     Population<T> const & population,
@@ -8,143 +8,1526 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include <genome_kernels.hpp>
+#include <novelty.hpp>
+#include <pareto.hpp>
+#include <surrogate.hpp>
+#include <thread_placement.hpp>
 
 namespace {
 
+// Last racing round reached by each individual
+using RacingRounds = std::vector<uint32_t>;
+
+// Per-individual buffers of a run, allocated once by evolve()
+struct EvolutionWorkspace
+{
+    std::vector<double> cumulativeFitness; // Roulette wheel: prefix sum of the fitnesses
+    std::vector<double> wheelIndex;        // Last prefix sum of each block of the wheel
+    RacingRounds rounds;
+    std::vector<uint32_t> candidates;      // Elite selection scratch
+    std::vector<uint32_t> elites;
+    SurrogateModel surrogate;
+    std::vector<double> predictions;       // Of the surrogate, or coarse fitnesses
+    std::size_t fullFidelityUntil = 0;     // Multi-fidelity fallback: first coarse generation
+    std::vector<double> scores;            // Selection score: fitness, or blended with novelty
+    NoveltyArchive archive;
+    KdTree behaviors;                      // Behaviors of the current generation
+    std::vector<double> novelties;
+    std::vector<double> objectives;        // Row major, one row per individual
+    std::vector<uint32_t> fronts;          // Non-domination rank
+    std::vector<double> crowding;
+    std::unique_ptr<WorkerPool> workers;
+    std::vector<uint32_t> parents;         // Of the current generation, 2 per individual
+    std::vector<uint32_t> nextParents;
+};
+
+inline std::size_t threadCount()
+{
+    #ifdef _OPENMP
+    return static_cast<std::size_t>(omp_get_max_threads());
+    #else
+    return 1;
+    #endif
+}
+
+// Chunk of the dynamic schedules: one individual at a time for small
+// populations (expensive evaluations), large chunks for huge ones
+inline int dynamicChunk(std::size_t n)
+{
+    return static_cast<int>(std::max<std::size_t>(1, n / (64 * threadCount())));
+}
+
+// Range of the calling thread when [0, n[ is split in nthreads contiguous chunks
+inline std::pair<std::size_t, std::size_t> threadRange(
+    std::size_t n, std::size_t thread, std::size_t nthreads
+)
+{
+    return std::make_pair(n * thread / nthreads, n * (thread + 1) / nthreads);
+}
+
+// Roulette wheel blocks: a draw searches the small block index, then one
+// block of cumulative fitnesses (two cache lines)
+std::size_t const WheelBlock = 16;
+
+// In-place inclusive prefix sum, in two parallel passes. Returns the total.
+// Serial within a thread on purpose: reordered additions would change the
+// wheel, so no SIMD variant.
+inline double prefixSum(std::vector<double> & values)
+{
+    std::size_t const n = values.size();
+    std::vector<double> offsets;
+
+    #pragma omp parallel
+    {
+        #ifdef _OPENMP
+        std::size_t const thread = omp_get_thread_num();
+        std::size_t const nthreads = omp_get_num_threads();
+        #else
+        std::size_t const thread = 0;
+        std::size_t const nthreads = 1;
+        #endif
+
+        #pragma omp single
+        offsets.assign(nthreads + 1, 0.0);
+
+        auto const range = threadRange(n, thread, nthreads);
+
+        double sum = 0.0;
+        for(auto i = range.first; i < range.second; ++i)
+        {
+            sum += values[i];
+            values[i] = sum;
+        }
+        offsets[thread + 1] = sum;
+
+        #pragma omp barrier
+
+        #pragma omp single
+        for(auto t = 1u; t <= nthreads; ++t)
+        {
+            offsets[t] += offsets[t - 1];
+        }
+
+        double const offset = offsets[thread];
+        for(auto i = range.first; i < range.second; ++i)
+        {
+            values[i] += offset;
+        }
+    }
+
+    return n > 0 ? values[n - 1] : 0.0;
+}
+
+// The dnas from lowest to greatest fitness, sorted through their keys so that
+// every dna is only moved once
+template <typename DNAType>
+DNAs<DNAType> sortByFitness(DNAs<DNAType> & dnas)
+{
+    std::size_t const popSize = dnas.size();
+
+    using Key = std::pair<typename DNAType::Fitness, uint32_t>;
+    std::vector<Key> keys(popSize);
+
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        keys[i] = Key(dnas[i].getFitness(), static_cast<uint32_t>(i));
+    }
+
+    std::sort(std::begin(keys), std::end(keys));
+
+    DNAs<DNAType> sorted;
+    sorted.reserve(popSize);
+    for(auto const & key : keys)
+    {
+        sorted.emplace_back(std::move(dnas[key.second]));
+    }
+
+    return sorted;
+}
+
+// Sharded schedule of a loop over n individuals, one shard per NUMA node,
+// none without placement
+inline std::unique_ptr<ShardedSchedule> shardIndividuals(std::size_t n, bool placement)
+{
+    std::unique_ptr<ShardedSchedule> shards;
+    if(placement)
+    {
+        shards.reset(new ShardedSchedule(
+            n, numaTopology().nodes.size(), static_cast<std::size_t>(dynamicChunk(n))
+        ));
+    }
+    return shards;
+}
+
+// Loop over the individuals [begin, end[ in a parallel region, shared by the
+// whole team: a dynamic schedule, or each thread in the shard of its node
+// when sharded. The shards split [0, end[, whatever begin, so that an index
+// always belongs to the same node. Ends with a barrier, as an omp for.
+template <typename Body>
+void forEachIndividual(
+    std::size_t begin, std::size_t end, ShardedSchedule * shards, Body const & body
+)
+{
+    if(!shards)
+    {
+        #pragma omp for schedule(dynamic, dynamicChunk(end - begin))
+        for(auto i = begin; i < end; ++i)
+        {
+            body(i);
+        }
+        return;
+    }
+
+    #ifdef _OPENMP
+    std::size_t const shard = threadNode(
+        omp_get_thread_num(), omp_get_num_threads(), shards->getShardCount()
+    );
+    #else
+    std::size_t const shard = 0;
+    #endif
+
+    std::size_t first = 0;
+    std::size_t last = 0;
+    while(shards->next(shard, first, last))
+    {
+        for(auto i = std::max(begin, first); i < last; ++i)
+        {
+            body(i);
+        }
+    }
+
+    #pragma omp barrier
+}
+
+template <typename DNAType>
+void computeFitnesses(std::size_t ngen, DNAs<DNAType> & dnas, bool placement = false)
+{
+    std::size_t const popSize = dnas.size();
+    std::unique_ptr<ShardedSchedule> const shards = shardIndividuals(popSize, placement);
+
+    #pragma omp parallel
+    forEachIndividual(0, popSize, shards.get(), [&](std::size_t i)
+    {
+        dnas[i].computeFitness(ngen);
+    });
+}
+
+// Worker processes evaluating copies of prototype, none if disabled. A
+// request is the generation (uint64) then the features of a dna.
+template <typename DNAType>
+std::unique_ptr<WorkerPool> startWorkers(
+    DNAType const & prototype, EvolutionParams<DNAType> const & params
+)
+{
+    std::unique_ptr<WorkerPool> workers;
+    if(!params.workers.enabled) return workers;
+
+    auto evaluator = std::make_shared<DNAType>();
+    prototype.crossoverInto(prototype, *evaluator);
+    evaluator->init(params.dnaParams);
+
+    auto const handler = [evaluator](
+        char const * request, std::size_t size, std::vector<char> & result
+    )
+    {
+        if(size < sizeof(uint64_t)) return false;
+
+        uint64_t ngen = 0;
+        std::memcpy(&ngen, request, sizeof(ngen));
+
+        std::vector<float> features((size - sizeof(ngen)) / sizeof(float));
+        std::memcpy(features.data(), request + sizeof(ngen), features.size() * sizeof(float));
+
+        evaluator->reset();
+        if(!evaluator->setFeatures(features.data(), features.size())) return false;
+
+        evaluator->computeFitness(static_cast<std::size_t>(ngen));
+        evaluator->encodeEvaluation(result);
+        return true;
+    };
+
+    workers.reset(new WorkerPool(params.workers, handler));
+    return workers;
+}
+
+// Full evaluation of the dnas by the workers, the ones without features in
+// the process
+template <typename DNAType>
+WorkerPoolReport evaluateInWorkers(std::size_t ngen, DNAs<DNAType> & dnas, WorkerPool & workers)
+{
+    std::size_t const popSize = dnas.size();
+
+    std::vector<char> requests;
+    std::vector<std::size_t> offsets(1, 0);
+    std::vector<uint32_t> jobs;
+    std::vector<uint32_t> local;
+
+    uint64_t const generation = ngen;
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        std::size_t size = 0;
+        float const * features = dnas[i].getFeatures(size);
+        if(!features)
+        {
+            local.push_back(static_cast<uint32_t>(i));
+            continue;
+        }
+
+        char const * header = reinterpret_cast<char const *>(&generation);
+        char const * bytes = reinterpret_cast<char const *>(features);
+        requests.insert(requests.end(), header, header + sizeof(generation));
+        requests.insert(requests.end(), bytes, bytes + size * sizeof(float));
+        offsets.push_back(requests.size());
+        jobs.push_back(static_cast<uint32_t>(i));
+    }
+
+    WorkerPoolReport const report = workers.run(requests, offsets, [&](
+        std::size_t job, char const * result, std::size_t size
+    )
+    {
+        DNAType & dna = dnas[jobs[job]];
+        if(result && dna.decodeEvaluation(result, size)) return;
+
+        // Given up, or malformed: the worst fitness
+        typename DNAType::Fitness const worst = 0.0;
+        dna.decodeEvaluation(reinterpret_cast<char const *>(&worst), sizeof(worst));
+    });
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(auto l = 0u; l < local.size(); ++l)
+    {
+        dnas[local[l]].computeFitness(ngen);
+    }
+
+    return report;
+}
+
+// Full evaluation of the dnas, by the workers if any
+template <typename DNAType>
+void computeFitnesses(
+    std::size_t ngen, DNAs<DNAType> & dnas,
+    WorkerPool * workers, EvolutionParams<DNAType> const & params
+)
+{
+    if(workers) params.workersHook(ngen, evaluateInWorkers(ngen, dnas, *workers));
+    else computeFitnesses(ngen, dnas, params.placement.enabled);
+}
+
+// Append the generation to the history
+template <typename DNAType>
+void recordGeneration(
+    PopulationHistory & history, std::size_t ngen,
+    DNAs<DNAType> const & dnas, std::vector<uint32_t> const & parents
+)
+{
+    std::size_t const popSize = dnas.size();
+
+    std::size_t genomeSize = 0;
+    dnas.front().getFeatures(genomeSize);
+    if(!history.begin(ngen, popSize, genomeSize)) return;
+
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        std::size_t size = 0;
+        float const * features = dnas[i].getFeatures(size);
+        history.setRecord(
+            i, dnas[i].getFitness(),
+            parents.empty() ? HistoryNoParent : parents[2 * i],
+            parents.empty() ? HistoryNoParent : parents[2 * i + 1],
+            features, features ? size : 0
+        );
+    }
+
+    history.commit();
+}
+
+// Indices of the nelites best individuals by selection score, best first.
+// Individuals frozen early by the racing rank after the ones evaluated
+// further, so that the elites always come from full evaluations.
+inline void selectElites(std::size_t nelites, EvolutionWorkspace & ws)
+{
+    std::size_t const popSize = ws.scores.size();
+    RacingRounds const & rounds = ws.rounds;
+    std::vector<double> const & scores = ws.scores;
+
+    auto const better = [&scores, &rounds](uint32_t lhs, uint32_t rhs)
+    {
+        if(rounds[lhs] != rounds[rhs]) return rounds[lhs] > rounds[rhs];
+        return scores[lhs] > scores[rhs];
+    };
+
+    ws.elites.clear();
+    if(nelites == 0) return;
+
+    // Each thread moves the best individuals of its chunk to the chunk front
+    std::vector<uint32_t> & candidates = ws.candidates;
+    std::vector<std::pair<std::size_t, std::size_t>> bests;
+
+    #pragma omp parallel
+    {
+        #ifdef _OPENMP
+        std::size_t const thread = omp_get_thread_num();
+        std::size_t const nthreads = omp_get_num_threads();
+        #else
+        std::size_t const thread = 0;
+        std::size_t const nthreads = 1;
+        #endif
+
+        #pragma omp single
+        bests.resize(nthreads);
+
+        auto const range = threadRange(popSize, thread, nthreads);
+        for(auto i = range.first; i < range.second; ++i)
+        {
+            candidates[i] = static_cast<uint32_t>(i);
+        }
+
+        std::size_t const k = std::min(nelites, range.second - range.first);
+        if(k > 0)
+        {
+            std::nth_element(
+                candidates.begin() + range.first,
+                candidates.begin() + (range.first + k - 1),
+                candidates.begin() + range.second,
+                better
+            );
+        }
+        bests[thread] = std::make_pair(range.first, k);
+    }
+
+    // Merge the nthreads * nelites candidates
+    for(auto const & b : bests)
+    {
+        ws.elites.insert(
+            ws.elites.end(),
+            candidates.begin() + b.first, candidates.begin() + (b.first + b.second)
+        );
+    }
+
+    std::size_t const n = std::min(nelites, ws.elites.size());
+    std::partial_sort(ws.elites.begin(), ws.elites.begin() + n, ws.elites.end(), better);
+    ws.elites.resize(n);
+}
+
+// Position of each individual in the given ranking (0: best)
+inline std::vector<std::size_t> positions(std::vector<std::size_t> const & ranking)
+{
+    std::vector<std::size_t> pos(ranking.size());
+    for(auto i = 0u; i < ranking.size(); ++i)
+    {
+        pos[ranking[i]] = i;
+    }
+    return pos;
+}
+
+// Successive-halving evaluation of the dnas. The first nelites (the elites
+// carried over) run every round: they always get the full budget.
+template <typename DNAType>
+RacingReport race(
+    std::size_t ngen,
+    DNAs<DNAType> & dnas,
+    std::size_t nelites,
+    RacingRounds & rounds,
+    EvolutionParams<DNAType> const & params
+)
+{
+    RacingParams const & racing = params.racing;
+
+    assert(racing.budgets.size() > 0);
+    assert(racing.cullFraction >= 0.0 && racing.cullFraction < 1.0);
+
+    std::size_t const popSize = dnas.size();
+    std::size_t const nrounds = racing.budgets.size();
+    std::size_t const nprotected = std::min(nelites, popSize);
+
+    // The protected individuals stay at the front of alive
+    std::vector<std::size_t> alive(popSize);
+    std::iota(std::begin(alive), std::end(alive), 0u);
+    rounds.assign(popSize, 0);
+
+    double budgetUsed = 0.0;
+
+    for(auto r = 0u; r < nrounds; ++r)
+    {
+        bool const lastRound = r + 1 == nrounds;
+        double const budget = lastRound ? 1.0 : racing.budgets[r];
+        std::size_t const nalive = alive.size();
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(auto k = 0u; k < nalive; ++k)
+        {
+            DNAType & dna = dnas[alive[k]];
+
+            // Each round restarts the evaluation from scratch
+            if(r > 0) dna.reset();
+
+            if(lastRound) dna.computeFitness(ngen);
+            else dna.computePartialFitness(ngen, budget);
+
+            rounds[alive[k]] = r;
+        }
+
+        budgetUsed += budget * static_cast<double>(nalive);
+
+        if(lastRound) break;
+
+        // Freeze the worst individuals, always keeping enough for the elites
+        std::size_t const ncull = static_cast<std::size_t>(
+            racing.cullFraction * static_cast<double>(nalive)
+        );
+        std::size_t nkeep = std::max<std::size_t>(nalive - ncull, params.elitism);
+        nkeep = std::min(std::max<std::size_t>({nkeep, nprotected + 1, 1u}), nalive);
+
+        // Cull among the others only
+        if(nkeep > nprotected)
+        {
+            std::nth_element(
+                std::begin(alive) + nprotected, std::begin(alive) + (nkeep - 1), std::end(alive),
+                [&dnas](std::size_t lhs, std::size_t rhs)
+                {
+                    return dnas[lhs].getFitness() > dnas[rhs].getFitness();
+                }
+            );
+        }
+        alive.resize(nkeep);
+    }
+
+    RacingReport report;
+    report.budgetSaved = 1.0 - budgetUsed / static_cast<double>(popSize);
+    report.frozen = popSize - alive.size();
+
+    // Audit: compare the racing ranking with a full evaluation
+    if(racing.auditInterval > 0 && ngen % racing.auditInterval == 0)
+    {
+        std::vector<std::size_t> racingRanking(popSize);
+        std::iota(std::begin(racingRanking), std::end(racingRanking), 0u);
+
+        std::vector<typename DNAType::Fitness> racingFitness(popSize);
+        for(auto i = 0u; i < popSize; ++i)
+        {
+            racingFitness[i] = dnas[i].getFitness();
+        }
+
+        std::sort(std::begin(racingRanking), std::end(racingRanking),
+            [&rounds, &racingFitness](std::size_t lhs, std::size_t rhs)
+            {
+                if(rounds[lhs] != rounds[rhs]) return rounds[lhs] > rounds[rhs];
+                return racingFitness[lhs] > racingFitness[rhs];
+            }
+        );
+
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(auto i = 0u; i < popSize; ++i)
+        {
+            dnas[i].reset();
+            dnas[i].computeFitness(ngen);
+        }
+
+        std::vector<std::size_t> fullRanking(popSize);
+        std::iota(std::begin(fullRanking), std::end(fullRanking), 0u);
+        std::sort(std::begin(fullRanking), std::end(fullRanking),
+            [&dnas](std::size_t lhs, std::size_t rhs)
+            {
+                return dnas[lhs].getFitness() > dnas[rhs].getFitness();
+            }
+        );
+
+        auto const racingPos = positions(racingRanking);
+        auto const fullPos = positions(fullRanking);
+
+        double sumSquares = 0.0;
+        double sumAbs = 0.0;
+        for(auto i = 0u; i < popSize; ++i)
+        {
+            double const d = static_cast<double>(racingPos[i]) -
+                             static_cast<double>(fullPos[i]);
+            sumSquares += d * d;
+            sumAbs += std::abs(d);
+        }
+
+        double const n = static_cast<double>(popSize);
+        report.audited = true;
+        report.rankCorrelation = popSize > 1 ?
+            1.0 - 6.0 * sumSquares / (n * (n * n - 1.0)) : 1.0;
+        report.meanRankDisplacement = sumAbs / n;
+
+        // Everybody now has a full evaluation
+        rounds.assign(popSize, nrounds - 1);
+        report.budgetSaved -= 1.0;
+    }
+
+    return report;
+}
+
+
+// Spearman correlation of two series of the same length (ties broken by index)
+inline double rankCorrelation(std::vector<double> const & a, std::vector<double> const & b)
+{
+    std::size_t const n = a.size();
+    if(n < 2) return 1.0;
+
+    auto const ranking = [n](std::vector<double> const & values)
+    {
+        std::vector<std::size_t> order(n);
+        std::iota(std::begin(order), std::end(order), 0u);
+        std::sort(std::begin(order), std::end(order),
+            [&values](std::size_t lhs, std::size_t rhs) { return values[lhs] > values[rhs]; }
+        );
+        return positions(order);
+    };
+
+    auto const posA = ranking(a);
+    auto const posB = ranking(b);
+
+    double sumSquares = 0.0;
+    for(auto i = 0u; i < n; ++i)
+    {
+        double const d = static_cast<double>(posA[i]) - static_cast<double>(posB[i]);
+        sumSquares += d * d;
+    }
+
+    double const dn = static_cast<double>(n);
+    return 1.0 - 6.0 * sumSquares / (dn * (dn * dn - 1.0));
+}
+
+// Surrogate-assisted evaluation of the dnas, whose nelites first ones are the
+// elites carried over and never screened. Screened individuals end in round 0,
+// the fully evaluated ones in round 1.
+template <typename DNAType>
+SurrogateReport screen(
+    std::size_t ngen,
+    DNAs<DNAType> & dnas,
+    std::size_t nelites,
+    EvolutionWorkspace & ws,
+    EvolutionParams<DNAType> const & params
+)
+{
+    SurrogateParams const & surrogate = params.surrogate;
+    SurrogateModel & model = ws.surrogate;
+    RacingRounds & rounds = ws.rounds;
+    std::vector<double> & predictions = ws.predictions;
+
+    std::size_t const popSize = dnas.size();
+    double const unknown = std::numeric_limits<double>::infinity();
+
+    SurrogateReport report;
+    report.samples = model.getSampleCount();
+    report.active = report.samples > 0 && report.samples >= surrogate.minSamples;
+
+    // Individuals without usable features are never screened
+    predictions.assign(popSize, unknown);
+    if(report.active)
+    {
+        #pragma omp parallel for schedule(dynamic, dynamicChunk(popSize))
+        for(auto i = 0u; i < popSize; ++i)
+        {
+            std::size_t size = 0;
+            float const * features = dnas[i].getFeatures(size);
+            if(features && model.accepts(size))
+            {
+                predictions[i] = model.predict(features, size);
+            }
+        }
+    }
+
+    // Screen the bottom quantile of the predictions, but a random audited part
+    rounds.assign(popSize, 1);
+    std::vector<std::size_t> audited;
+    if(report.active && popSize > 0)
+    {
+        std::vector<double> sorted(predictions);
+        std::size_t const q = std::min(
+            static_cast<std::size_t>(surrogate.screenQuantile * static_cast<double>(popSize)),
+            popSize - 1
+        );
+        std::nth_element(sorted.begin(), sorted.begin() + q, sorted.end());
+        double const cut = sorted[q];
+
+        RandomStream & rng = RandomStream::local();
+        double const auditThreshold = surrogate.auditFraction * 4294967296.0;
+
+        for(auto i = std::min(nelites, popSize); i < popSize; ++i)
+        {
+            if(!(predictions[i] < cut)) continue;
+
+            ++report.screened;
+
+            uint32_t r = 0;
+            rng.fill(&r, 1);
+            if(static_cast<double>(r) < auditThreshold) audited.push_back(i);
+            else rounds[i] = 0;
+        }
+        report.audited = audited.size();
+    }
+
+    double const screenBudget = std::max(0.0, std::min(1.0, surrogate.screenBudget));
+
+    #pragma omp parallel for schedule(dynamic, dynamicChunk(popSize))
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        if(rounds[i] == 0) dnas[i].computePartialFitness(ngen, screenBudget);
+        else dnas[i].computeFitness(ngen);
+    }
+
+    std::size_t const nscreened = report.screened - report.audited;
+    report.budgetSaved = popSize > 0 ?
+        nscreened * (1.0 - screenBudget) / static_cast<double>(popSize) : 0.0;
+
+    // Telemetry on the fully evaluated individuals that had a prediction
+    if(report.active)
+    {
+        std::vector<double> predicted;
+        std::vector<double> simulated;
+        for(auto i = 0u; i < popSize; ++i)
+        {
+            if(rounds[i] == 1 && predictions[i] < unknown)
+            {
+                predicted.push_back(predictions[i]);
+                simulated.push_back(dnas[i].getFitness());
+            }
+        }
+        report.rankCorrelation = rankCorrelation(predicted, simulated);
+
+        if(!audited.empty() && !simulated.empty())
+        {
+            std::size_t const mid = simulated.size() / 2;
+            std::nth_element(simulated.begin(), simulated.begin() + mid, simulated.end());
+            double const median = simulated[mid];
+
+            std::size_t misses = 0;
+            for(auto i : audited) misses += dnas[i].getFitness() > median ? 1 : 0;
+            report.auditMissRate = static_cast<double>(misses) / audited.size();
+        }
+    }
+
+    // Train on the full evaluations only: screening runs use another scale
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        if(rounds[i] != 1) continue;
+
+        std::size_t size = 0;
+        float const * features = dnas[i].getFeatures(size);
+        if(features) model.add(features, size, dnas[i].getFitness());
+    }
+
+    return report;
+}
+
+// Multi-fidelity evaluation of the dnas, whose nelites first ones are the
+// elites carried over. The individuals evaluated at full fidelity end in
+// round 1, the others in round 0.
+template <typename DNAType>
+MultiFidelityReport refine(
+    std::size_t ngen,
+    DNAs<DNAType> & dnas,
+    std::size_t nelites,
+    EvolutionWorkspace & ws,
+    EvolutionParams<DNAType> const & params
+)
+{
+    MultiFidelityParams const & fidelity = params.multiFidelity;
+    RacingRounds & rounds = ws.rounds;
+    std::vector<double> & coarse = ws.predictions;
+
+    std::size_t const popSize = dnas.size();
+
+    MultiFidelityReport report;
+
+    // Falling back: full fidelity for everybody
+    if(ngen < ws.fullFidelityUntil)
+    {
+        computeFitnesses(ngen, dnas, ws.workers.get(), params);
+        rounds.assign(popSize, 1);
+        return report;
+    }
+
+    report.coarse = true;
+
+    coarse.resize(popSize);
+    std::unique_ptr<ShardedSchedule> const shards = shardIndividuals(
+        popSize, params.placement.enabled
+    );
+
+    #pragma omp parallel
+    forEachIndividual(0, popSize, shards.get(), [&](std::size_t i)
+    {
+        coarse[i] = dnas[i].computeCoarseFitness(ngen);
+    });
+
+    // Contenders: the best coarse fitnesses, and the elites
+    rounds.assign(popSize, 0);
+
+    std::size_t const ncontenders = std::min(popSize, static_cast<std::size_t>(
+        std::ceil(fidelity.contenderFraction * static_cast<double>(popSize))
+    ));
+    if(ncontenders > 0)
+    {
+        std::vector<uint32_t> order(popSize);
+        std::iota(std::begin(order), std::end(order), 0u);
+        std::nth_element(
+            std::begin(order), std::begin(order) + (ncontenders - 1), std::end(order),
+            [&coarse](uint32_t lhs, uint32_t rhs) { return coarse[lhs] > coarse[rhs]; }
+        );
+        for(auto k = 0u; k < ncontenders; ++k) rounds[order[k]] = 1;
+    }
+    for(auto i = 0u; i < std::min(nelites, popSize); ++i) rounds[i] = 1;
+
+    std::vector<uint32_t> full;
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        if(rounds[i] == 1) full.push_back(static_cast<uint32_t>(i));
+    }
+    report.contenders = full.size();
+
+    // Audit: a random part of the others, so that the agreement is not only
+    // measured at the top of the ranking
+    RandomStream & rng = RandomStream::local();
+    double const auditThreshold = fidelity.auditFraction * 4294967296.0;
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        if(rounds[i] == 1) continue;
+
+        uint32_t r = 0;
+        rng.fill(&r, 1);
+        if(static_cast<double>(r) < auditThreshold)
+        {
+            rounds[i] = 1;
+            full.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    report.audited = full.size() - report.contenders;
+
+    // Full fidelity, from scratch, by the workers if any
+    if(ws.workers)
+    {
+        DNAs<DNAType> rerun;
+        rerun.reserve(full.size());
+        for(auto i : full) rerun.push_back(dnas[i]);
+
+        computeFitnesses(ngen, rerun, ws.workers.get(), params);
+        for(auto k = 0u; k < full.size(); ++k) dnas[full[k]] = rerun[k];
+    }
+    else
+    {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for(auto k = 0u; k < full.size(); ++k)
+        {
+            DNAType & dna = dnas[full[k]];
+            dna.reset();
+            dna.computeFitness(ngen);
+        }
+    }
+
+    std::vector<double> coarseFitnesses(full.size());
+    std::vector<double> fullFitnesses(full.size());
+    for(auto k = 0u; k < full.size(); ++k)
+    {
+        coarseFitnesses[k] = coarse[full[k]];
+        fullFitnesses[k] = dnas[full[k]].getFitness();
+    }
+    report.rankCorrelation = rankCorrelation(coarseFitnesses, fullFitnesses);
+
+    if(report.rankCorrelation < fidelity.minAgreement)
+    {
+        report.fallback = true;
+        ws.fullFidelityUntil = fidelity.fallbackGenerations > 0 ?
+            ngen + 1 + fidelity.fallbackGenerations : std::numeric_limits<std::size_t>::max();
+    }
+
+    return report;
+}
+
+// Novelty of each individual with a behavior, then selection scores blending
+// it with the fitness. The most novel behaviors are archived.
+template <typename DNAType>
+NoveltyReport assessNovelty(
+    DNAs<DNAType> const & dnas,
+    EvolutionWorkspace & ws,
+    NoveltyParams const & novelty
+)
+{
+    std::size_t const popSize = dnas.size();
+    NoveltyArchive & archive = ws.archive;
+    std::vector<double> & novelties = ws.novelties;
+
+    // Individuals whose behavior has the dimension of the archive
+    std::size_t dimension = 0;
+    std::vector<uint32_t> ids;
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        std::size_t size = 0;
+        float const * behavior = dnas[i].getBehavior(size);
+        if(!behavior || !archive.accepts(size)) continue;
+        if(dimension == 0) dimension = size;
+        if(size == dimension) ids.push_back(static_cast<uint32_t>(i));
+    }
+
+    std::size_t const nbehaviors = ids.size();
+    std::vector<float> points(nbehaviors * dimension);
+
+    #pragma omp parallel for schedule(static)
+    for(auto r = 0u; r < nbehaviors; ++r)
+    {
+        std::size_t size = 0;
+        float const * behavior = dnas[ids[r]].getBehavior(size);
+
+        // Never null here, but GCC cannot tell for DNAs without behaviors
+        if(behavior) std::copy(behavior, behavior + dimension, points.begin() + r * dimension);
+    }
+
+    novelties.assign(popSize, 0.0);
+    if(nbehaviors > 0)
+    {
+        ws.behaviors.build(std::move(points), ids, dimension);
+
+        #pragma omp parallel
+        {
+            NearestDistances nearest;
+
+            #pragma omp for schedule(dynamic, dynamicChunk(nbehaviors))
+            for(auto r = 0u; r < nbehaviors; ++r)
+            {
+                std::size_t size = 0;
+                float const * behavior = dnas[ids[r]].getBehavior(size);
+
+                nearest.reset(novelty.neighbours);
+                ws.behaviors.nearest(behavior, nearest, ids[r]);
+                archive.nearest(behavior, nearest);
+                novelties[ids[r]] = nearest.meanDistance();
+            }
+        }
+    }
+
+    NoveltyReport report;
+    report.behaviors = nbehaviors;
+    for(auto i : ids)
+    {
+        report.meanNovelty += novelties[i];
+        report.maxNovelty = std::max(report.maxNovelty, novelties[i]);
+    }
+    if(nbehaviors > 0) report.meanNovelty /= static_cast<double>(nbehaviors);
+
+    double const weight = std::max(0.0, std::min(1.0, novelty.weight));
+    double const scale = report.maxNovelty > 0.0 ? weight / report.maxNovelty : 0.0;
+
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        ws.scores[i] = (1.0 - weight) * dnas[i].getFitness() + scale * novelties[i];
+    }
+
+    // Archive the most novel behaviors of the generation
+    std::size_t narchived = static_cast<std::size_t>(novelty.archiveFraction * nbehaviors);
+    if(novelty.archiveFraction > 0.0 && nbehaviors > 0) narchived = std::max<std::size_t>(narchived, 1);
+    narchived = std::min(narchived, nbehaviors);
+
+    if(narchived > 0)
+    {
+        std::nth_element(ids.begin(), ids.begin() + (narchived - 1), ids.end(),
+            [&novelties](uint32_t lhs, uint32_t rhs) { return novelties[lhs] > novelties[rhs]; }
+        );
+        for(auto r = 0u; r < narchived; ++r)
+        {
+            std::size_t size = 0;
+            float const * behavior = dnas[ids[r]].getBehavior(size);
+            archive.add(behavior, size);
+        }
+    }
+    report.archived = narchived;
+    report.archiveSize = archive.size();
+
+    return report;
+}
+
+// Selection scores ordering the dnas by front, then by crowding distance
 template <typename DNAType>
-struct RankedDNA
+MultiObjectiveReport rankObjectives(DNAs<DNAType> const & dnas, EvolutionWorkspace & ws)
+{
+    std::size_t const popSize = dnas.size();
+
+    MultiObjectiveReport report;
+    for(auto i = 0u; i < popSize && report.objectives == 0; ++i)
+    {
+        std::size_t size = 0;
+        if(dnas[i].getObjectives(size)) report.objectives = size;
+    }
+    std::size_t const m = report.objectives;
+
+    // Dnas without objectives are dominated by all the others
+    std::vector<double> & objectives = ws.objectives;
+    objectives.resize(popSize * m);
+
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        std::size_t size = 0;
+        double const * values = dnas[i].getObjectives(size);
+        for(auto k = 0u; k < m; ++k)
+        {
+            objectives[i * m + k] = values && size == m ?
+                values[k] : -std::numeric_limits<double>::infinity();
+        }
+    }
+
+    report.fronts = nondominatedSort(objectives.data(), popSize, m, ws.fronts);
+    crowdingDistances(objectives.data(), popSize, m, ws.fronts, report.fronts, ws.crowding);
+
+    // Crowding maps to [0, 0.5]: never enough to pass a better front
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        double const c = ws.crowding[i];
+        double const spread = std::isinf(c) ? 0.5 : 0.5 * c / (1.0 + c);
+        ws.scores[i] = spread - static_cast<double>(ws.fronts[i]);
+    }
+
+    report.paretoSize = static_cast<std::size_t>(
+        std::count(ws.fronts.begin(), ws.fronts.end(), 0u)
+    );
+    return report;
+}
+
+// Stop criteria of a run, checked after each generation
+class StopCondition
+{
+    public:
+        StopCondition(StopParams const & params, std::size_t ngenerations):
+            m_params(params),
+            m_ngenerations(ngenerations),
+            m_start(Clock::now()),
+            m_last(m_start),
+            m_best(-std::numeric_limits<double>::infinity()),
+            m_stalled(0)
+        {
+
+        }
+
+        // True if the run stops after generation ngen, of best fitness best
+        bool check(std::size_t ngen, double best, StopReason & reason)
+        {
+            Clock::time_point const now = Clock::now();
+            double const elapsed = std::chrono::duration<double>(now - m_start).count();
+            double const generation = std::chrono::duration<double>(now - m_last).count();
+            m_last = now;
+
+            if(best > m_best)
+            {
+                m_best = best;
+                m_stalled = 0;
+            }
+            else ++m_stalled;
+
+            if(best >= m_params.targetFitness) reason = StopReason::TargetFitness;
+            else if(m_params.plateau > 0 && m_stalled >= m_params.plateau) reason = StopReason::Plateau;
+            else if(m_params.deadline > 0.0 && elapsed + generation > m_params.deadline) reason = StopReason::Deadline;
+            else if(ngen + 1 >= m_ngenerations) reason = StopReason::Generations;
+            else return false;
+
+            return true;
+        }
+
+        // Generations in a row without a better best fitness
+        std::size_t stalled() const
+        {
+            return m_stalled;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        StopParams m_params;
+        std::size_t m_ngenerations;
+        Clock::time_point m_start;
+        Clock::time_point m_last;
+        double m_best;
+        std::size_t m_stalled;
+};
+
+// Size of each generation, from the use of the threads and the progress
+class PopulationController
 {
-    using DNARef = std::reference_wrapper<const DNAType>;
-    using Score  = typename DNAType::Fitness;
+    public:
+        PopulationController(
+            PopulationControlParams const & params, std::size_t initialSize, std::size_t elitism
+        ):
+            m_params(params),
+            m_minSize(std::max<std::size_t>(params.minSize > 0 ? params.minSize : initialSize / 4, elitism + 2)),
+            m_maxSize(std::max(params.maxSize > 0 ? params.maxSize : 4 * initialSize, m_minSize)),
+            m_wallStart(Clock::now()),
+            m_cpuStart(std::clock())
+        {
+
+        }
+
+        // Size of the generation after the one of size individuals
+        std::size_t next(std::size_t size, std::size_t stalled, PopulationReport & report)
+        {
+            Clock::time_point const wall = Clock::now();
+            std::clock_t const cpu = std::clock();
+            double const seconds = std::chrono::duration<double>(wall - m_wallStart).count();
+            double const cpuSeconds = static_cast<double>(cpu - m_cpuStart) / CLOCKS_PER_SEC;
+            m_wallStart = wall;
+            m_cpuStart = cpu;
+
+            report.size = size;
+            report.utilization = seconds > 0.0 ?
+                cpuSeconds / (seconds * static_cast<double>(threadCount())) : 1.0;
+            report.evaluationsPerSecond = static_cast<double>(size) / std::max(seconds, 1e-9);
+
+            double target = static_cast<double>(size);
+            if(m_params.stall > 0 && stalled > 0 && stalled % m_params.stall == 0)
+            {
+                target /= m_params.factor;
+            }
+            else if((m_params.stall == 0 || stalled < m_params.stall)
+                && report.utilization < m_params.targetUtilization)
+            {
+                // Idle threads, as long as the fitness improves
+                target *= m_params.factor;
+            }
 
-    DNARef dna;
-    Score score;
+            report.nextSize = std::min(
+                m_maxSize, std::max(m_minSize, static_cast<std::size_t>(std::lround(target)))
+            );
+            return report.nextSize;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
 
-    RankedDNA(DNARef d, Score s): dna(d), score(s) { }
+        PopulationControlParams m_params;
+        std::size_t m_minSize;
+        std::size_t m_maxSize;
+        Clock::time_point m_wallStart;
+        std::clock_t m_cpuStart;
 };
 
+// Size the per-individual buffers for a generation of popSize individuals
+inline void resizeWorkspace(EvolutionWorkspace & ws, std::size_t popSize, bool lineage)
+{
+    ws.cumulativeFitness.resize(popSize);
+    ws.wheelIndex.resize((popSize + WheelBlock - 1) / WheelBlock);
+    ws.rounds.resize(popSize);
+    ws.candidates.resize(popSize);
+    ws.scores.resize(popSize);
+    if(lineage) ws.parents.resize(2 * popSize, HistoryNoParent);
+}
+
+// Compute the fitness of the dnas. The last generation is neither screened by
+// the surrogate nor coarsely evaluated: its fitnesses are returned.
+template <typename DNAType>
+void evaluate(
+    std::size_t ngen,
+    DNAs<DNAType> & dnas,
+    EvolutionWorkspace & ws,
+    EvolutionParams<DNAType> const & params,
+    bool last
+)
+{
+    assert(dnas.size() > 0);
+
+    // The elites carried over, at the front of the generation
+    std::size_t const nelites = ngen > 0 ? ws.elites.size() : 0;
+
+    if(params.racing.enabled)
+    {
+        params.racingHook(ngen, race(ngen, dnas, nelites, ws.rounds, params));
+    }
+    else if(params.surrogate.enabled && !last)
+    {
+        params.surrogateHook(ngen, screen(ngen, dnas, nelites, ws, params));
+    }
+    else if(params.multiFidelity.enabled && !last)
+    {
+        params.multiFidelityHook(ngen, refine(ngen, dnas, nelites, ws, params));
+    }
+    else
+    {
+        computeFitnesses(ngen, dnas, ws.workers.get(), params);
+        ws.rounds.assign(dnas.size(), 0);
+    }
+}
+
+// Best fitness of the individuals evaluated furthest: the last racing round,
+// or the full evaluations besides screening and coarse ones
+template <typename DNAType>
+double bestEvaluatedFitness(DNAs<DNAType> const & dnas, RacingRounds const & rounds)
+{
+    uint32_t const top = rounds.empty() ? 0 : *std::max_element(rounds.begin(), rounds.end());
+
+    double best = -std::numeric_limits<double>::infinity();
+    for(auto i = 0u; i < dnas.size(); ++i)
+    {
+        if(i < rounds.size() && rounds[i] != top) continue;
+        best = std::max(best, dnas[i].getFitness());
+    }
+    return best;
+}
+
+// True if every individual went through the same, full, evaluation
+inline bool fullyEvaluated(RacingRounds const & rounds)
+{
+    return std::adjacent_find(rounds.begin(), rounds.end(), std::not_equal_to<uint32_t>()) ==
+        rounds.end();
+}
+
+// Full evaluation of the whole generation, from scratch
 template <typename DNAType>
-using MatingPool = std::vector<RankedDNA<DNAType>>;
+void evaluateAgain(
+    std::size_t ngen,
+    DNAs<DNAType> & dnas,
+    EvolutionWorkspace & ws,
+    EvolutionParams<DNAType> const & params
+)
+{
+    #pragma omp parallel for schedule(dynamic, dynamicChunk(dnas.size()))
+    for(auto i = 0u; i < dnas.size(); ++i) dnas[i].reset();
 
+    computeFitnesses(ngen, dnas, ws.workers.get(), params);
+    ws.rounds.assign(dnas.size(), 0);
+}
 
+// Full evaluation of the dnas in the threads. The threads left without
+// evaluation to run breed the first children of nextGen (after the slots of
+// the elites) from the individuals already evaluated, until the last
+// evaluation ends. With placement, the threads evaluate the shard of their
+// node first; the early children are bred by whichever thread is idle.
 template <typename DNAType>
-void evolution(
+PipelineReport evaluateAhead(
     std::size_t ngen,
     DNAs<DNAType> & dnas,
     DNAs<DNAType> & nextGen,
-    MatingPool<DNAType> & matingPool,
+    EvolutionWorkspace & ws,
     EvolutionParams<DNAType> const & params
 )
+{
+    using Clock = std::chrono::steady_clock;
+
+    PipelineParams const & pipeline = params.pipeline;
+    std::size_t const popSize = dnas.size();
+    std::size_t const nextSize = nextGen.size();
+    std::size_t const nelites = std::min<std::size_t>({params.elitism, nextSize, popSize});
+    std::size_t const maxChildren = static_cast<std::size_t>(
+        std::max(0.0, pipeline.speculativeFraction) * static_cast<double>(nextSize - nelites)
+    );
+    std::size_t const minRanked = static_cast<std::size_t>(
+        std::ceil(pipeline.minRanked * static_cast<double>(popSize))
+    );
+    std::size_t const chunk = static_cast<std::size_t>(dynamicChunk(popSize));
+
+    std::unique_ptr<std::atomic<bool>[]> evaluated(new std::atomic<bool>[popSize]);
+    for(auto i = 0u; i < popSize; ++i) evaluated[i].store(false, std::memory_order_relaxed);
+
+    std::unique_ptr<ShardedSchedule> const shards = shardIndividuals(
+        popSize, params.placement.enabled
+    );
+    std::atomic<std::size_t> nextIndividual(0);
+    std::atomic<std::size_t> nranked(0);
+    std::atomic<std::size_t> nextChild(0);
+
+    // Wheel of the evaluated individuals, built once by the first idle thread
+    std::atomic<int> wheelState(0); // 0: none, 1: building, 2: built
+    std::vector<uint32_t> ranked;
+    std::vector<double> wheel;
+    std::atomic<bool> tailStarted(false);
+    Clock::time_point tailStart = Clock::now();
+
+    std::vector<uint32_t> & nextParents = ws.nextParents;
+    bool const lineage = params.history != nullptr;
+    if(lineage) nextParents.resize(2 * nextSize);
+
+    #pragma omp parallel
+    {
+        #ifdef _OPENMP
+        std::size_t const shard = shards ? threadNode(
+            omp_get_thread_num(), omp_get_num_threads(), shards->getShardCount()
+        ) : 0;
+        #else
+        std::size_t const shard = 0;
+        #endif
+
+        for(;;)
+        {
+            std::size_t first = 0;
+            std::size_t last = 0;
+            if(shards)
+            {
+                if(!shards->next(shard, first, last)) break;
+            }
+            else
+            {
+                first = nextIndividual.fetch_add(chunk, std::memory_order_relaxed);
+                if(first >= popSize) break;
+                last = std::min(first + chunk, popSize);
+            }
+
+            for(auto i = first; i < last; ++i)
+            {
+                dnas[i].computeFitness(ngen);
+                evaluated[i].store(true, std::memory_order_release);
+            }
+            nranked.fetch_add(last - first, std::memory_order_release);
+        }
+
+        bool expected = false;
+        if(tailStarted.compare_exchange_strong(expected, true)) tailStart = Clock::now();
+
+        if(maxChildren > 0 && nranked.load(std::memory_order_acquire) >= minRanked)
+        {
+            int idle = 0;
+            if(wheelState.compare_exchange_strong(idle, 1))
+            {
+                double total = 0.0;
+                for(auto i = 0u; i < popSize; ++i)
+                {
+                    if(!evaluated[i].load(std::memory_order_acquire)) continue;
+
+                    total += std::max(0.0, dnas[i].getFitness());
+                    ranked.push_back(static_cast<uint32_t>(i));
+                    wheel.push_back(total);
+                }
+                wheelState.store(2, std::memory_order_release);
+            }
+            while(wheelState.load(std::memory_order_acquire) != 2) std::this_thread::yield();
+
+            RandomStream & rng = RandomStream::local();
+            uint32_t r[2];
+
+            double const total = wheel.back();
+            auto const selectParent = [&](uint32_t random) -> uint32_t
+            {
+                std::size_t k = 0;
+                if(total > 0.0)
+                {
+                    double const x = random * (total / 4294967296.0);
+                    k = static_cast<std::size_t>(
+                        std::upper_bound(wheel.begin(), wheel.end(), x) - wheel.begin()
+                    );
+                }
+                else
+                {
+                    k = static_cast<std::size_t>(
+                        random * (static_cast<double>(ranked.size()) / 4294967296.0)
+                    );
+                }
+                return ranked[std::min(k, ranked.size() - 1)];
+            };
+
+            // Only while the tail runs: the others are bred from the whole generation
+            while(nranked.load(std::memory_order_acquire) < popSize)
+            {
+                std::size_t const c = nextChild.fetch_add(1, std::memory_order_relaxed);
+                if(c >= maxChildren) break;
+
+                std::size_t const i = nelites + c;
+
+                rng.fill(r, 2);
+                uint32_t const a = selectParent(r[0]);
+                uint32_t const b = selectParent(r[1]);
+
+                if(lineage)
+                {
+                    nextParents[2 * i] = a;
+                    nextParents[2 * i + 1] = b;
+                }
+
+                DNAType & childDNA = nextGen[i];
+                dnas[a].crossoverInto(dnas[b], childDNA);
+                childDNA.init(params.dnaParams);
+                childDNA.mutate(params.mutationRate);
+            }
+        }
+    }
+
+    ws.rounds.assign(popSize, 0);
+
+    // Every claimed child below maxChildren was bred
+    PipelineReport report;
+    report.ranked = ranked.size();
+    report.speculative = std::min(nextChild.load(), maxChildren);
+    report.tailSeconds = std::chrono::duration<double>(Clock::now() - tailStart).count();
+    return report;
+}
+
+// Breed the evaluated dnas into nextGen, whose size may differ. The
+// nspeculative children following the elites are already bred. The elites
+// are copied once the children are bred and the hook (if any) is done: they
+// share their subject with the dnas, that the hook may still read.
+template <typename DNAType>
+void breed(
+    std::size_t ngen,
+    DNAs<DNAType> const & dnas,
+    DNAs<DNAType> & nextGen,
+    EvolutionWorkspace & ws,
+    EvolutionParams<DNAType> const & params,
+    std::size_t nspeculative = 0,
+    std::future<void> * hook = nullptr
+)
 {
     assert(dnas.size() > 0);
-    assert(nextGen.size() == dnas.size());
-    assert(params.elitism <= dnas.size());
+    assert(nextGen.size() > 0);
 
-    using Fitness = typename DNAType::Fitness;
     using MutationRate = typename DNAType::MutationRate;
 
     std::size_t const popSize = dnas.size();
+    std::size_t const nextSize = nextGen.size();
 
-    // Compute the fitness of the dnas
-    #pragma omp parallel for schedule(dynamic, 1)
-    for(auto i = 0u; i < popSize; ++i)
+    std::vector<double> & scores = ws.scores;
+    bool const multiObjective = params.multiObjective.enabled;
+    if(multiObjective)
     {
-        dnas[i].computeFitness(ngen);
+        params.multiObjectiveHook(ngen, rankObjectives(dnas, ws));
     }
-
-    Fitness cumulativeFitness = 0.0;
-    #pragma omp parallel for reduction(+:cumulativeFitness)
-    for(auto i = 0u; i < popSize; ++i)
+    else if(params.novelty.enabled)
+    {
+        params.noveltyHook(ngen, assessNovelty(dnas, ws, params.novelty));
+    }
+    else
     {
-        cumulativeFitness += dnas[i].getFitness();
+        #pragma omp parallel for schedule(static)
+        for(auto i = 0u; i < popSize; ++i)
+        {
+            scores[i] = dnas[i].getFitness();
+        }
     }
 
-    // Create the mating pool
-    #pragma omp parallel for schedule(dynamic, 1)
-    for(auto i = 0u; i < dnas.size(); ++i)
+    // Roulette wheel: parent i is drawn with probability score_i / total,
+    // by a binary search of the prefix sum of the scores
+    std::vector<double> & cumulativeFitness = ws.cumulativeFitness;
+
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < popSize; ++i)
     {
-        auto const & dna = dnas[i];
-        matingPool[i] = RankedDNA<DNAType>(
-            std::cref(dna), dna.getFitness() / cumulativeFitness
-        );
+        cumulativeFitness[i] = std::max(0.0, scores[i]);
     }
 
-    // Reverse sort: greatest relative fitness to lowest
-    std::sort(std::begin(matingPool), std::end(matingPool),
-        [](RankedDNA<DNAType> const & lhs, RankedDNA<DNAType> const & rhs)
-        {
-            return lhs.score > rhs.score;
-        }
-    );
+    double const totalFitness = prefixSum(cumulativeFitness);
 
+    std::vector<double> & wheelIndex = ws.wheelIndex;
+    std::size_t const nblocks = (popSize + WheelBlock - 1) / WheelBlock;
 
-    // Compute score of dnas
-    Fitness cumulativeScore = 0.0;
-    for(auto & dna: matingPool)
+    #pragma omp parallel for schedule(static)
+    for(auto b = 0u; b < nblocks; ++b)
     {
-        cumulativeScore += dna.score;
-        dna.score = cumulativeScore;
+        wheelIndex[b] = cumulativeFitness[std::min((b + 1) * WheelBlock, popSize) - 1];
     }
 
+    selectElites(std::min<std::size_t>(params.elitism, nextSize), ws);
+
     // Reproduce
     MutationRate const mutationRate = params.mutationRate;
-    #pragma omp parallel
+    std::size_t const nelites = ws.elites.size();
+
+    // Lineage, for the history
+    std::vector<uint32_t> & nextParents = ws.nextParents;
+    bool const lineage = params.history != nullptr;
+    if(lineage) nextParents.resize(2 * nextSize);
+    for(auto i = 0u; lineage && i < nelites; ++i)
     {
-        // Create a random generator per thread
+        nextParents[2 * i] = ws.elites[i];
+        nextParents[2 * i + 1] = HistoryNoParent;
+    }
 
-        #ifdef _OPENMP
-        std::size_t threadNum = omp_get_thread_num();
-        #else
-        std::size_t threadNum = 0;
-        #endif
+    // Create next generation, each child by a thread of the node of its slot
+    std::unique_ptr<ShardedSchedule> const shards = shardIndividuals(
+        nextSize, params.placement.enabled
+    );
 
-        std::mt19937_64 rng((threadNum + 1) * static_cast<uint64_t>(
-            std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())
-        ));
-        std::uniform_real_distribution<double> random(0.0, 1.0);
+    #pragma omp parallel
+    {
+        RandomStream & rng = RandomStream::local();
+        uint32_t r[4];
 
         // Parent selection lambda
-        auto const selectParent =
-        [&rng, &random](MatingPool<DNAType> & matingPool) -> DNAType const &
+        auto const selectParent = [&](uint32_t random) -> DNAType const &
         {
-            Fitness r = random(rng);
-            for(auto i = 0u; i < matingPool.size()-1; ++i)
+            // Without any positive score, every individual is equally likely
+            if(multiObjective || !(totalFitness > 0.0))
             {
-                if(matingPool[i].score > r)
-                {
-                    return matingPool[i].dna;
-                }
+                return dnas[static_cast<std::size_t>(
+                    random * (static_cast<double>(popSize) / 4294967296.0)
+                )];
             }
 
-            return matingPool[matingPool.size()-1].dna;
-        };
+            double const x = random * (totalFitness / 4294967296.0);
+            std::size_t const block = static_cast<std::size_t>(
+                std::upper_bound(wheelIndex.begin(), wheelIndex.begin() + nblocks, x) -
+                wheelIndex.begin()
+            );
+            if(block >= nblocks) return dnas[popSize - 1];
 
+            auto const first = cumulativeFitness.begin() + block * WheelBlock;
+            auto const last = cumulativeFitness.begin() + std::min((block + 1) * WheelBlock, popSize);
+            std::size_t const index = static_cast<std::size_t>(
+                std::upper_bound(first, last, x) - cumulativeFitness.begin()
+            );
+            return dnas[std::min(index, popSize - 1)];
+        };
 
-        // Elitism: keep the best individuals of the previous generation
-        #pragma omp for schedule(dynamic, 1)
-        for(auto i = 0u; i < params.elitism; ++i)
+        forEachIndividual(nelites + nspeculative, nextSize, shards.get(), [&](std::size_t i)
         {
-            nextGen[i] = matingPool[i].dna;
-            nextGen[i].reset();
-        }
+            DNAType const * parents[2];
+            if(multiObjective)
+            {
+                // Binary tournaments on the crowded comparison
+                rng.fill(r, 4);
+                for(auto p = 0u; p < 2; ++p)
+                {
+                    DNAType const & a = selectParent(r[2 * p]);
+                    DNAType const & b = selectParent(r[2 * p + 1]);
+                    parents[p] = scores[&a - dnas.data()] < scores[&b - dnas.data()] ? &b : &a;
+                }
+            }
+            else
+            {
+                rng.fill(r, 2);
+                parents[0] = &selectParent(r[0]);
+                parents[1] = &selectParent(r[1]);
+            }
+            DNAType const & parentA = *parents[0];
+            DNAType const & parentB = *parents[1];
 
-        // Create next generation
-        #pragma omp for schedule(dynamic, 1)
-        for(auto i = params.elitism; i < dnas.size(); ++i)
-        {
-            DNAType const & parentA = selectParent(matingPool);
-            DNAType const & parentB = selectParent(matingPool);
+            if(lineage)
+            {
+                nextParents[2 * i] = static_cast<uint32_t>(&parentA - dnas.data());
+                nextParents[2 * i + 1] = static_cast<uint32_t>(&parentB - dnas.data());
+            }
 
-            DNAType childDNA;
-            childDNA.setSubject(parentA.crossover(parentB));
+            // The slot still holds a dna of two generations ago: its subject
+            // can be recycled for the child
+            DNAType & childDNA = nextGen[i];
+            parentA.crossoverInto(parentB, childDNA);
             childDNA.init(params.dnaParams);
             childDNA.mutate(mutationRate);
+        });
+    }
 
-            nextGen[i] = std::move(childDNA);
-        }
+    if(hook) hook->get();
+
+    // Elitism: keep the best individuals of the previous generation
+    #pragma omp parallel for schedule(static)
+    for(auto i = 0u; i < nelites; ++i)
+    {
+        nextGen[i] = dnas[ws.elites[i]];
+        nextGen[i].reset();
     }
 }
 
@@ -167,70 +1550,161 @@ DNAs<DNAType> evolve(
         "DNAType must be default constructible"
     );
 
-    DNAs<DNAType> dnas;
-    dnas.reserve(population.size());
+    std::size_t const popSize = population.size();
 
     int seed = 42;//time(NULL);
 
+    // Warm start: seeds first, then their mutated copies, then random dnas
+    auto const & warmStart = params.warmStart;
+    std::size_t const nseeds = std::min(warmStart.seeds.size(), popSize);
+    std::size_t const ncopies = nseeds == 0 ? 0 : nseeds + std::min(
+        popSize - nseeds,
+        static_cast<std::size_t>(warmStart.mutatedFraction * static_cast<double>(popSize - nseeds))
+    );
+
+    DNAs<DNAType> seeds(nseeds);
+    for(auto s = 0u; s < nseeds; ++s)
+    {
+        assert(warmStart.seeds[s] != nullptr);
+        seeds[s].setSubject(warmStart.seeds[s]);
+        seeds[s].init(params.dnaParams);
+    }
+
+    // Threads pinned before the first allocations of the run
+    bool const placement = params.placement.enabled;
+    std::size_t pinned = 0;
+    if(placement && pinThreads()) pinned = threadCount();
+
     // Create initial DNAs
-    for(auto i = 0u; i < population.size(); ++i)
+    DNAs<DNAType> dnas(popSize);
+    std::unique_ptr<ShardedSchedule> const shards = shardIndividuals(popSize, placement);
+
+    #pragma omp parallel
+    forEachIndividual(0, popSize, shards.get(), [&](std::size_t i)
     {
         assert(population[i] != nullptr);
-        DNAType dna;
+        DNAType & dna = dnas[i];
         dna.setSubject(population[i]);
         dna.init(params.dnaParams);
-        dna.randomize(seed+i);
-        dnas.emplace_back(std::move(dna));
-    }
 
-    assert(dnas.size() == population.size());
+        if(i < ncopies)
+        {
+            // The crossover of a seed with itself copies its genes
+            DNAType const & source = seeds[i % nseeds];
+            source.crossoverInto(source, dna);
+            dna.init(params.dnaParams);
+            if(i >= nseeds) dna.mutate(warmStart.mutationRate);
+        }
+        else
+        {
+            dna.randomize(seed+i);
+        }
+    });
 
-    // Initialize a dummy mating pool
-    MatingPool<DNAType> matingPool;
-    matingPool.reserve(population.size());
-    for(auto const & dna: dnas)
-    {
-        matingPool.emplace_back(std::cref(dna), 0.0);
-    }
+    if(ngenerations == 0) return sortByFitness(dnas);
 
     // Initialize the container for the next generation
-    DNAs<DNAType> nextGen;
-    nextGen.resize(population.size());
+    DNAs<DNAType> nextGen(popSize);
+
+    bool const lineage = params.history != nullptr;
+
+    EvolutionWorkspace ws;
+    ws.elites.reserve(threadCount() * params.elitism);
+    ws.surrogate.configure(
+        params.surrogate.enabled ? params.surrogate.capacity : 0, params.surrogate.neighbours
+    );
+    ws.workers = startWorkers(dnas.front(), params);
 
-    // Evolve
-    for(auto i = 0u; i < ngenerations; ++i)
+    StopCondition stop(params.stop, ngenerations);
+    PopulationController controller(params.populationControl, popSize, params.elitism);
+
+    // Pipelined generations, on the plain path only
+    bool const pipelined = params.pipeline.enabled &&
+        !params.racing.enabled && !params.surrogate.enabled && !params.multiFidelity.enabled &&
+        !params.novelty.enabled && !params.multiObjective.enabled && !ws.workers &&
+        !params.populationControl.enabled;
+    std::future<void> prepared;
+
+    // Evolve: the last generation is evaluated but not bred
+    for(auto i = 0u; ; ++i)
     {
+        std::size_t const size = dnas.size();
+        resizeWorkspace(ws, size, lineage);
+
         params.preGenHook(i, dnas);
 
-        evolution(i, dnas, nextGen, matingPool, params);
+        // The hook may change the number of threads
+        if(placement && pinned != threadCount() && pinThreads()) pinned = threadCount();
 
-        params.postGenHook(i, dnas);
+        if(prepared.valid()) prepared.get();
 
-        std::swap(nextGen, dnas);
-    }
+        bool const last = i + 1 >= ngenerations;
+        std::size_t nspeculative = 0;
+        if(pipelined && !last)
+        {
+            nextGen.resize(size);
+            PipelineReport const report = evaluateAhead(i, dnas, nextGen, ws, params);
+            nspeculative = report.speculative;
+            params.pipelineHook(i, report);
+        }
+        else evaluate(i, dnas, ws, params, last);
 
-    // Evaluate the last generation
-    std::swap(nextGen, dnas);
-    std::size_t const popSize = nextGen.size();
+        StopReason reason = StopReason::Generations;
+        bool const stopping = stop.check(i, bestEvaluatedFitness(dnas, ws.rounds), reason);
 
-    params.preGenHook(ngenerations, nextGen);
+        // The generation returned is fully evaluated, even when the run stops
+        // early on a raced, screened or coarse one
+        if(stopping && !fullyEvaluated(ws.rounds)) evaluateAgain(i, dnas, ws, params);
 
-    #pragma omp parallel for schedule(dynamic, 1)
-    for(auto i = 0u; i < popSize; ++i)
-    {
-        nextGen[i].computeFitness(ngenerations);
-    }
+        if(params.history) recordGeneration(*params.history, i, dnas, ws.parents);
+
+        // Pipelined: the hook reads the generation while the next one is bred
+        std::future<void> hook;
+        if(pipelined && !last && !stopping)
+        {
+            hook = std::async(std::launch::async, [&params, &dnas, i]()
+            {
+                unpinCurrentThread();
+                params.postGenHook(i, dnas);
+            });
+        }
+        else params.postGenHook(i, dnas);
+
+        if(stopping)
+        {
+            params.stopHook(i, reason);
+            break;
+        }
 
-    params.postGenHook(ngenerations, nextGen);
+        if(pipelined)
+        {
+            std::function<void ()> const prepare = dnas.front().prepareEvaluation(i + 1);
+            if(prepare)
+            {
+                prepared = std::async(std::launch::async, [prepare]()
+                {
+                    unpinCurrentThread();
+                    prepare();
+                });
+            }
+        }
 
-    std::sort(std::begin(nextGen), std::end(nextGen),
-        [](DNAType const & lhs, DNAType const & rhs)
+        std::size_t nextSize = size;
+        if(params.populationControl.enabled)
         {
-            return lhs.getFitness() < rhs.getFitness();
+            PopulationReport report;
+            nextSize = controller.next(size, stop.stalled(), report);
+            params.populationHook(i, report);
         }
-    );
 
-    return nextGen;
+        nextGen.resize(nextSize);
+        breed(i, dnas, nextGen, ws, params, nspeculative, hook.valid() ? &hook : nullptr);
+
+        std::swap(nextGen, dnas);
+        if(lineage) ws.parents.swap(ws.nextParents);
+    }
+
+    return sortByFitness(dnas);
 }
 
 #endif //EVOLUTION_INL
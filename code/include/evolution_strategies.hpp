@@ -0,0 +1,52 @@
+#ifndef EVOLUTION_STRATEGIES_HPP
+#define EVOLUTION_STRATEGIES_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <evolution.hpp>
+
+// Natural evolution strategies (OpenAI-ES) on the features of the dnas
+// (DNA::getFeatures / setFeatures). Each generation, individual 0 holds the
+// mean theta, the others theta + sigma * eps and theta - sigma * eps in
+// antithetic pairs. The centered ranks of their fitnesses weight the
+// perturbations into a gradient estimate, applied by Adam. An odd population
+// makes full pairs: with an even one, the last individual has no partner and
+// does not contribute to the gradient.
+struct ESParams
+{
+    // Use evolveES rather than evolve (for the callers choosing the engine)
+    bool enabled = false;
+
+    // Standard deviation of the perturbations
+    double sigma = 0.05;
+
+    // Adam step size
+    double learningRate = 0.02;
+
+    // Perturbations are regenerated from (seed, generation, pair)
+    uint64_t seed = 42;
+};
+
+// Same contract as evolve(), with the same evaluation (dnaParams, workers),
+// stop criteria and generation hooks; racing, surrogate, novelty and the
+// population control do not apply. The initial
+// mean is the first warm start seed, or a random dna.
+//
+// Cost of a generation of n individuals and g features, besides the DNA
+// methods (computeFitness, reset, setFeatures: once per individual): noise
+// regenerated twice per pair (O(ng) normal draws), sort of the fitnesses.
+// Memory: the mean and 2 Adam moments (3g floats), one partial gradient per
+// block of 16 pairs and one noise buffer per thread; the perturbations are
+// never stored. A run does not depend on the number of threads.
+template <typename DNAType, typename T>
+DNAs<DNAType> evolveES(
+    Population<T> const & population,
+    std::size_t ngenerations,
+    EvolutionParams<DNAType> const & params = { },
+    ESParams const & es = { }
+);
+
+#include "evolution_strategies.inl"
+
+#endif //EVOLUTION_STRATEGIES_HPP
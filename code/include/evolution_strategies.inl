@@ -0,0 +1,233 @@
+#ifndef EVOLUTION_STRATEGIES_INL
+#define EVOLUTION_STRATEGIES_INL
+
+#include "evolution_strategies.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <genome_kernels.hpp>
+
+namespace {
+
+// Pairs per block of the gradient sum: the blocks, then their sums, are added
+// in a fixed order whatever the number of threads
+std::size_t const ESGradientBlock = 16;
+
+// Perturbation of a pair of a generation, the same at each call
+inline void esNoise(
+    uint64_t seed, std::size_t ngen, std::size_t pair, std::vector<float> & noise
+)
+{
+    RandomStream rng(seed ^ (static_cast<uint64_t>(ngen) << 40) ^ static_cast<uint64_t>(pair));
+    gaussianNoise(noise.data(), noise.size(), rng);
+}
+
+}
+
+template <typename DNAType, typename T>
+DNAs<DNAType> evolveES(
+    Population<T> const & population,
+    std::size_t ngenerations,
+    EvolutionParams<DNAType> const & params,
+    ESParams const & es
+)
+{
+    static_assert(
+        std::is_base_of<DNA<T, DNAType>, DNAType>::value,
+        "DNAType must inherit from DNA<T, DNAType>"
+    );
+
+    static_assert(
+        std::is_default_constructible<DNAType>::value,
+        "DNAType must be default constructible"
+    );
+
+    std::size_t const popSize = population.size();
+    assert(popSize > 0);
+
+    int seed = 42;
+
+    DNAs<DNAType> dnas(popSize);
+
+    #pragma omp parallel for schedule(dynamic, dynamicChunk(popSize))
+    for(auto i = 0u; i < popSize; ++i)
+    {
+        assert(population[i] != nullptr);
+        DNAType & dna = dnas[i];
+        dna.setSubject(population[i]);
+        dna.init(params.dnaParams);
+        dna.randomize(seed+i);
+    }
+
+    // Initial mean: the first seed, or the first random dna
+    std::vector<float> theta;
+    {
+        DNAType start = dnas.front();
+        if(!params.warmStart.seeds.empty())
+        {
+            start.setSubject(params.warmStart.seeds.front());
+            start.init(params.dnaParams);
+        }
+
+        std::size_t size = 0;
+        float const * features = start.getFeatures(size);
+        assert(features && "evolveES requires DNA::getFeatures");
+        if(features) theta.assign(features, features + size);
+    }
+
+    std::size_t const dimension = theta.size();
+    std::size_t const nperturbed = popSize - 1;
+    std::size_t const npairs = (nperturbed + 1) / 2;
+
+    // With an even population the last individual has no antithetic partner:
+    // it is evaluated, but left out of the gradient, which it would bias
+    std::size_t const nfullPairs = nperturbed / 2;
+    std::size_t const nblocks = (nfullPairs + ESGradientBlock - 1) / ESGradientBlock;
+    std::vector<std::vector<double>> blocks(nblocks);
+
+    double const sigma = es.sigma;
+    std::vector<double> utilities(popSize, 0.0);
+    std::vector<double> gradient(dimension);
+    std::vector<double> moment1(dimension, 0.0);
+    std::vector<double> moment2(dimension, 0.0);
+
+    std::unique_ptr<WorkerPool> workers = startWorkers(dnas.front(), params);
+    StopCondition stop(params.stop, ngenerations);
+
+    for(auto ngen = 0u; ngen < ngenerations; ++ngen)
+    {
+        // Individual 0 is the mean, 2p+1 and 2p+2 the antithetic pair p
+        #pragma omp parallel
+        {
+            std::vector<float> noise(dimension);
+            std::vector<float> features(dimension);
+
+            auto const perturb = [&](std::size_t i, float scale)
+            {
+                for(auto j = 0u; j < dimension; ++j)
+                {
+                    features[j] = theta[j] + scale * noise[j];
+                }
+
+                if(ngen > 0) dnas[i].reset();
+                bool const set = dnas[i].setFeatures(features.data(), dimension);
+                assert(set && "evolveES requires DNA::setFeatures");
+                (void) set;
+            };
+
+            #pragma omp for schedule(dynamic, dynamicChunk(npairs + 1))
+            for(auto k = 0u; k <= npairs; ++k)
+            {
+                if(k == 0)
+                {
+                    perturb(0, 0.0f);
+                    continue;
+                }
+
+                esNoise(es.seed, ngen, k - 1, noise);
+                perturb(2 * k - 1, static_cast<float>(sigma));
+                if(2 * k < popSize) perturb(2 * k, static_cast<float>(-sigma));
+            }
+        }
+
+        params.preGenHook(ngen, dnas);
+        computeFitnesses(ngen, dnas, workers.get(), params);
+
+        // The individuals all derive from the mean: no parents
+        if(params.history) recordGeneration(*params.history, ngen, dnas, { });
+        params.postGenHook(ngen, dnas);
+
+        double best = -std::numeric_limits<double>::infinity();
+        for(auto const & dna : dnas) best = std::max(best, dna.getFitness());
+
+        StopReason reason = StopReason::Generations;
+        if(stop.check(ngen, best, reason))
+        {
+            params.stopHook(ngen, reason);
+            break;
+        }
+
+        if(nperturbed == 0) continue;
+
+        // Fitness shaping: centered ranks of the perturbed individuals
+        std::vector<std::size_t> order(nperturbed);
+        std::iota(order.begin(), order.end(), 1u);
+        std::sort(order.begin(), order.end(), [&dnas](std::size_t lhs, std::size_t rhs)
+        {
+            if(dnas[lhs].getFitness() < dnas[rhs].getFitness()) return true;
+            if(dnas[rhs].getFitness() < dnas[lhs].getFitness()) return false;
+            return lhs < rhs;
+        });
+        for(auto r = 0u; r < nperturbed; ++r)
+        {
+            utilities[order[r]] = nperturbed > 1 ?
+                static_cast<double>(r) / static_cast<double>(nperturbed - 1) - 0.5 : 0.0;
+        }
+
+        // Gradient estimate, the noise of each pair regenerated once. The
+        // pairs are summed in blocks of fixed size, for runs independent of
+        // the number of threads.
+        #pragma omp parallel
+        {
+            std::vector<float> noise(dimension);
+
+            #pragma omp for schedule(dynamic, 1)
+            for(auto b = 0u; b < nblocks; ++b)
+            {
+                std::vector<double> & block = blocks[b];
+                block.assign(dimension, 0.0);
+
+                std::size_t const last = std::min(nfullPairs, (b + 1) * ESGradientBlock);
+                for(auto p = b * ESGradientBlock; p < last; ++p)
+                {
+                    double const weight = utilities[2 * p + 1] - utilities[2 * p + 2];
+
+                    esNoise(es.seed, ngen, p, noise);
+                    for(auto j = 0u; j < dimension; ++j)
+                    {
+                        block[j] += weight * noise[j];
+                    }
+                }
+            }
+        }
+
+        std::fill(gradient.begin(), gradient.end(), 0.0);
+        for(auto const & block : blocks)
+        {
+            for(auto j = 0u; j < block.size(); ++j)
+            {
+                gradient[j] += block[j];
+            }
+        }
+
+        // Adam ascent step
+        double const beta1 = 0.9;
+        double const beta2 = 0.999;
+        double const t = static_cast<double>(ngen + 1);
+        double const correction1 = 1.0 - std::pow(beta1, t);
+        double const correction2 = 1.0 - std::pow(beta2, t);
+        double const norm = nfullPairs > 0 ?
+            1.0 / (2.0 * static_cast<double>(nfullPairs) * sigma) : 0.0;
+
+        for(auto j = 0u; j < dimension; ++j)
+        {
+            double const g = gradient[j] * norm;
+            moment1[j] = beta1 * moment1[j] + (1.0 - beta1) * g;
+            moment2[j] = beta2 * moment2[j] + (1.0 - beta2) * g * g;
+
+            double const step = es.learningRate * (moment1[j] / correction1) /
+                (std::sqrt(moment2[j] / correction2) + 1e-8);
+            theta[j] = static_cast<float>(theta[j] + step);
+        }
+    }
+
+    return sortByFitness(dnas);
+}
+
+#endif //EVOLUTION_STRATEGIES_INL
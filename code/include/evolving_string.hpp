@@ -1,6 +1,8 @@
 #ifndef EVOLVING_STRING
 #define EVOLVING_STRING
 
+#include <cstddef>
+#include <memory>
 #include <string>
 
 #include <dna.hpp>
@@ -10,7 +12,15 @@ struct EvolvingString
 {
     EvolvingString(std::string const & target):
         m_genes(""),
-        m_target(target)
+        m_target(std::make_shared<std::string const>(target))
+    {
+
+    }
+
+    // Individuals of a population share a single copy of their target
+    EvolvingString(std::shared_ptr<std::string const> target):
+        m_genes(""),
+        m_target(std::move(target))
     {
 
     }
@@ -27,7 +37,7 @@ struct EvolvingString
 
     std::string const & getTarget() const
     {
-        return m_target;
+        return *m_target;
     }
 
     void setGenes(std::string const & genes)
@@ -37,7 +47,7 @@ struct EvolvingString
 
     private:
         std::string m_genes;
-        std::string m_target;
+        std::shared_ptr<std::string const> m_target;
 };
 
 class EvolvingStringDNA : public DNA<EvolvingString, EvolvingStringDNA>
@@ -50,12 +60,18 @@ class EvolvingStringDNA : public DNA<EvolvingString, EvolvingStringDNA>
         virtual Fitness computeFitness(std::size_t ngen = 0) override;
         virtual void reset() override;
         virtual Subject crossover(EvolvingStringDNA const & partner) const override;
+        virtual void crossoverInto(
+            EvolvingStringDNA const & partner, EvolvingStringDNA & child
+        ) const override;
         virtual void mutate(MutationRate mutationRate) override;
 
-        static char RandomChar();
-        static std::string RandomString(std::size_t length);
+    private:
+        void breed(EvolvingStringDNA const & partner, EvolvingString & child) const;
 };
 
-void stringEvolution();
+// Scaling benchmark of the evolution engine: the string fitness is nearly
+// free, so the time per individual is the overhead of evolve() itself.
+// Populations grow by 10x from 1000 up to maxPopulation.
+void stringEvolution(std::size_t maxPopulation = 1000000, std::size_t ngenerations = 20);
 
 #endif //EVOLVING_STRING
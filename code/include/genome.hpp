@@ -0,0 +1,34 @@
+#ifndef NEURO_CAR_GENOME_HPP
+#define NEURO_CAR_GENOME_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <neural_network.hpp>
+
+#include <genome_kernels.hpp>
+
+namespace NeuroCar {
+
+// Flat storage of the weights and biases of a neural network.
+// For each layer l and each neuron j of layer l+1, the I weights coming from
+// layer l are followed by the bias of j: one contiguous row of I+1 genes.
+using Genome = std::vector<float>;
+
+std::size_t genomeSize(NeuroEvolution::NeuralNetwork::Shape const & shape);
+
+void networkToGenome(NeuroEvolution::NeuralNetwork const & nn, Genome & genome);
+void genomeToNetwork(Genome const & genome, NeuroEvolution::NeuralNetwork & nn);
+
+// Zero each connection weight with probability rate (biases are kept)
+void pruneGenome(
+    NeuroEvolution::NeuralNetwork::Shape const & shape, Genome & genome,
+    double rate, RandomStream & rng
+);
+
+// Fraction of the connection weights that are exactly zero
+double genomeSparsity(NeuroEvolution::NeuralNetwork::Shape const & shape, Genome const & genome);
+
+}
+
+#endif //NEURO_CAR_GENOME_HPP
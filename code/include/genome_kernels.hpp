@@ -0,0 +1,61 @@
+#ifndef GENOME_KERNELS_HPP
+#define GENOME_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk random number generator: interleaved xorshift128 generators, so that a
+// whole SIMD register of random numbers is produced per iteration.
+class RandomStream
+{
+    public:
+        static std::size_t const Lanes = 4;
+
+        explicit RandomStream(uint64_t seed);
+
+        // Fill out with n uniformly distributed 32-bit integers
+        void fill(uint32_t * out, std::size_t n);
+
+        // Stream of the calling thread, seeded from std::random_device
+        static RandomStream & local();
+
+    private:
+        alignas(16) uint32_t m_x[Lanes];
+        alignas(16) uint32_t m_y[Lanes];
+        alignas(16) uint32_t m_z[Lanes];
+        alignas(16) uint32_t m_w[Lanes];
+};
+
+// Uniform crossover: each gene comes from a or b with the same probability
+void crossoverGenes(
+    float const * a, float const * b, float * child, std::size_t n,
+    RandomStream & rng
+);
+
+// Add a uniform perturbation in [-amplitude, amplitude] to each gene with
+// probability rate
+void mutateGenes(
+    float * genes, std::size_t n, double rate, float amplitude,
+    RandomStream & rng
+);
+
+// Set each gene to zero with probability rate
+void pruneGenes(float * genes, std::size_t n, double rate, RandomStream & rng);
+
+// Uniform crossover of byte genomes
+void crossoverBytes(
+    uint8_t const * a, uint8_t const * b, uint8_t * child, std::size_t n,
+    RandomStream & rng
+);
+
+// Replace each byte with probability rate by a random symbol of the alphabet
+void mutateBytes(
+    uint8_t * genes, std::size_t n, double rate,
+    char const * alphabet, std::size_t alphabetSize,
+    RandomStream & rng
+);
+
+// Fill out with n standard normal values
+void gaussianNoise(float * out, std::size_t n, RandomStream & rng);
+
+#endif //GENOME_KERNELS_HPP
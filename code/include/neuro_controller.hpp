@@ -2,12 +2,19 @@
 #define NEURO_CAR_NEURO_CONTROLLER_HPP
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 #include <car.hpp>
 
 #include <controller.hpp>
 #include <neural_network.hpp>
 
+#include <genome.hpp>
+#include <quantized_network.hpp>
+#include <sparse_network.hpp>
+#include <trajectory_recorder.hpp>
+
 namespace NeuroCar {
 
 class NeuroController : public Controller
@@ -15,6 +22,14 @@ class NeuroController : public Controller
     public:
         using NeuralNetwork = NeuroEvolution::NeuralNetwork;
 
+        // Network driving the car
+        enum class Inference
+        {
+            Float,
+            Quantized,
+            Sparse     // Non-zero weights of the genome given to compactNetwork
+        };
+
     public:
 
         NeuroController();
@@ -26,11 +41,82 @@ class NeuroController : public Controller
         void setNeuralNetwork(NeuralNetwork const & nn);
         void setDestination(b2Vec2 destination);
 
+        // Maximum number of steps before the car is killed (0: no limit)
+        void setStepLimit(uint32_t limit);
+        uint32_t getStepCount() const;
+        void resetStepCount();
+
+        // Physics steps between two decisions: the sensors are sampled and the
+        // network evaluated every period steps, the flags are held in between
+        void setControlPeriod(uint32_t period);
+        uint32_t getControlPeriod() const;
+        uint32_t getDecisionCount() const;
+
+        // Distance driven and decisions changing the flags since the last
+        // resetStepCount
+        float getPathLength() const;
+        uint32_t getFlagChanges() const;
+
+        void setQuantizedNetwork(std::shared_ptr<QuantizedNetwork const> qnn);
+
+        // Rebuild the sparse network from the genome of the float network
+        void compactNetwork(Genome const & genome);
+        SparseNetwork const & getSparseNetwork() const;
+
+        void setInference(Inference inference);
+        Inference getInference() const;
+
+        // Evaluate both the float and the quantized networks at each step
+        // and count the steps where their flags differ
+        void setCompareFlags(bool compare);
+        uint32_t getComparedSteps() const;
+        uint32_t getFlagDisagreements() const;
+
+        // Append the network inputs of each step to log (nullptr: disabled)
+        void setInputLog(std::vector<NeuroEvolution::Weight> * log);
+
+        // Record each step of the episode (nullptr: disabled)
+        void setRecorder(TrajectoryRecorder * recorder);
+
+        // Append the position of the car (x, y) to log every interval steps
+        // (nullptr or 0: disabled)
+        void setPositionLog(std::vector<float> * log, uint32_t interval);
+
         virtual uint32_t updateFlags(Car * c) const override;
 
+    private:
+        uint32_t decide() const;
+        uint32_t computeFloatFlags() const;
+        uint32_t computeSparseFlags() const;
+
     private:
         NeuralNetwork m_neuralNetwork;
         b2Vec2 m_destination;
+
+        std::shared_ptr<QuantizedNetwork const> m_quantizedNetwork;
+        SparseNetwork m_sparseNetwork;
+        Inference m_inference;
+        bool m_compareFlags;
+        mutable uint32_t m_comparedSteps;
+        mutable uint32_t m_flagDisagreements;
+        std::vector<NeuroEvolution::Weight> * m_inputLog;
+        TrajectoryRecorder * m_recorder;
+        std::vector<float> * m_positionLog;
+        uint32_t m_positionInterval;
+
+        uint32_t m_stepLimit;
+        mutable uint32_t m_stepCount;
+
+        uint32_t m_controlPeriod;
+        mutable uint32_t m_decisionCount;
+        mutable uint32_t m_heldFlags;
+        mutable uint32_t m_flagChanges;
+        mutable float m_pathLength;
+        mutable b2Vec2 m_lastPos;
+
+        // Network inputs and outputs of the last step
+        mutable std::vector<NeuroEvolution::Weight> m_inputs;
+        mutable std::vector<NeuroEvolution::Weight> m_outputs;
 };
 
 }
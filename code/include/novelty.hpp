@@ -0,0 +1,100 @@
+#ifndef NOVELTY_HPP
+#define NOVELTY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Squared distances of the k nearest points found so far (bounded max-heap)
+class NearestDistances
+{
+    public:
+        NearestDistances();
+
+        // Drops the distances
+        void reset(std::size_t k);
+
+        void offer(float distance2);
+
+        // Squared distance a point must beat to be kept (+inf until k found)
+        float bound() const;
+
+        // Mean Euclidean distance of the kept points (0 if none)
+        double meanDistance() const;
+
+        std::size_t size() const;
+
+    private:
+        std::size_t m_k;
+        std::vector<float> m_heap;
+};
+
+// Static k-d tree over points of the same dimension, each with an id.
+// Built in O(n log n) (median splits on the widest coordinate), queried in
+// about O(log n) for close neighbours. Thread-safe queries.
+class KdTree
+{
+    public:
+        KdTree();
+
+        // points: n rows of dimension coordinates, ids: n ids
+        void build(
+            std::vector<float> points, std::vector<uint32_t> ids, std::size_t dimension
+        );
+
+        void clear();
+
+        // Offers the distances to the points, but the one with id exclude
+        void nearest(float const * point, NearestDistances & nearest, uint32_t exclude) const;
+
+        std::size_t size() const;
+        std::vector<float> const & getPoints() const;
+
+    private:
+        void split(std::size_t first, std::size_t last, std::vector<uint32_t> & order);
+        void search(
+            std::size_t first, std::size_t last,
+            float const * point, NearestDistances & nearest, uint32_t exclude
+        ) const;
+        float distance2(std::size_t row, float const * point) const;
+
+    private:
+        std::size_t m_dimension;
+        std::vector<float> m_points;     // Rows in tree order
+        std::vector<uint32_t> m_ids;
+        std::vector<uint8_t> m_axes;     // Split coordinate of each inner node
+};
+
+// Growing set of behaviors. Insertions go to a small buffer scanned
+// linearly; full buffers are merged into k-d trees of 1, 2, 4... buffers,
+// like a binary counter, so that an insertion costs O(log^2 n) amortized and
+// a query O(log^2 n) whatever the archive size.
+class NoveltyArchive
+{
+    public:
+        NoveltyArchive();
+
+        // Drops the behaviors
+        void clear();
+
+        // The first behavior sets the dimension, others are ignored
+        void add(float const * behavior, std::size_t size);
+
+        bool accepts(std::size_t size) const;
+
+        // Offers the distances to the archived behaviors. Thread-safe.
+        void nearest(float const * behavior, NearestDistances & nearest) const;
+
+        std::size_t size() const;
+
+    private:
+        void flush();
+
+    private:
+        std::size_t m_dimension;
+        std::size_t m_count;
+        std::vector<float> m_buffer;
+        std::vector<KdTree> m_levels;   // Level l: empty or 2^l buffers
+};
+
+#endif //NOVELTY_HPP
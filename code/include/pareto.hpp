@@ -0,0 +1,32 @@
+#ifndef PARETO_HPP
+#define PARETO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Objectives are maximized. a dominates b if it is at least as good on every
+// objective and better on one.
+bool dominates(double const * a, double const * b, std::size_t nobjectives);
+
+// Non-dominated sorting of n points of nobjectives objectives (row major):
+// rank 0 is the Pareto front, rank r + 1 the front of the points left once
+// ranks 0..r are removed. The domination relation is computed in parallel
+// into a bit matrix (n^2 / 8 bytes, 12.5 MB for 10000 points), then the
+// fronts are peeled by decrementing domination counts. O(m n^2 / p).
+// Returns the number of fronts.
+std::size_t nondominatedSort(
+    double const * objectives, std::size_t n, std::size_t nobjectives,
+    std::vector<uint32_t> & ranks
+);
+
+// Crowding distance of each point within its front: the sum over the
+// objectives of the normalized gap between its neighbours, +inf on the
+// boundaries. Fronts are processed in parallel.
+void crowdingDistances(
+    double const * objectives, std::size_t n, std::size_t nobjectives,
+    std::vector<uint32_t> const & ranks, std::size_t nfronts,
+    std::vector<double> & distances
+);
+
+#endif //PARETO_HPP
@@ -0,0 +1,51 @@
+#ifndef POOL_STATS_HPP
+#define POOL_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+
+// Number of objects allocated and recycled by a pool
+struct PoolCounts
+{
+    std::size_t allocations = 0;
+    std::size_t reuses = 0;
+
+    PoolCounts operator-(PoolCounts const & rhs) const
+    {
+        PoolCounts diff;
+        diff.allocations = allocations - rhs.allocations;
+        diff.reuses = reuses - rhs.reuses;
+        return diff;
+    }
+};
+
+// Thread-safe allocation counters of a pool
+class PoolCounter
+{
+    public:
+        PoolCounter(): m_allocations(0), m_reuses(0) { }
+
+        void allocated()
+        {
+            m_allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void reused()
+        {
+            m_reuses.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        PoolCounts counts() const
+        {
+            PoolCounts c;
+            c.allocations = m_allocations.load(std::memory_order_relaxed);
+            c.reuses = m_reuses.load(std::memory_order_relaxed);
+            return c;
+        }
+
+    private:
+        std::atomic<std::size_t> m_allocations;
+        std::atomic<std::size_t> m_reuses;
+};
+
+#endif //POOL_STATS_HPP
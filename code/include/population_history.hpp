@@ -0,0 +1,133 @@
+#ifndef POPULATION_HISTORY_HPP
+#define POPULATION_HISTORY_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Layout of a history file: a PopulationHistoryHeader, then one record of
+// stride bytes per individual per generation, the records of a generation
+// contiguous. A record is a HistoryRecord followed by genomeSize floats and
+// padding. The index file (<filename>.idx) holds a HistoryIndexEntry per
+// generation, appended once its records are written: a reader never sees an
+// entry before its records. Both files are append-only.
+struct PopulationHistoryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t genomeSize;
+    uint32_t stride;
+};
+
+struct HistoryRecord
+{
+    double fitness;
+    uint32_t parents[2]; // Indices in the previous generation
+};
+
+struct HistoryIndexEntry
+{
+    uint64_t generation;
+    uint64_t offset;     // Of the first record, from the start of the file
+    uint64_t count;
+};
+
+// Parent of the individuals of the first generation, and second parent of
+// the elites (copies of their first parent)
+uint32_t const HistoryNoParent = 0xFFFFFFFF;
+
+// Writes the population of every generation to a history file. The caller
+// fills the records of a generation in a buffer (in parallel), a background
+// thread writes it with one large sequential write. At most maxPending
+// generations wait for the writer: begin() blocks beyond.
+class PopulationHistory
+{
+    public:
+        PopulationHistory(std::string const & filename, std::size_t maxPending = 2);
+        ~PopulationHistory();
+
+        PopulationHistory(PopulationHistory const &) = delete;
+        PopulationHistory & operator=(PopulationHistory const &) = delete;
+
+        bool isOpen() const;
+
+        // Start the records of a generation of n individuals. The genome size
+        // is fixed by the first generation: false for another size.
+        bool begin(uint64_t generation, std::size_t n, std::size_t genomeSize);
+
+        // Record i of the current generation, thread-safe for distinct i. The
+        // genome is truncated or padded with zeros to the genome size.
+        void setRecord(
+            std::size_t i, double fitness, uint32_t parentA, uint32_t parentB,
+            float const * genome, std::size_t size
+        );
+
+        // Queue the generation for the writer
+        void commit();
+
+    private:
+        struct Block
+        {
+            uint64_t generation = 0;
+            std::size_t count = 0;
+            std::vector<char> data;
+        };
+
+        void write();
+
+    private:
+        std::ofstream m_file;
+        std::ofstream m_index;
+        uint64_t m_offset;
+        std::size_t m_genomeSize;
+        std::size_t m_stride;
+        bool m_started;
+
+        std::size_t m_maxPending;
+        Block m_current;
+        std::deque<Block> m_pending;
+        std::vector<Block> m_free;
+        bool m_stop;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::thread m_writer;
+};
+
+// Read-only view of a history file, memory-mapped: the records are read in
+// place. The view covers the generations complete when it was opened.
+class PopulationHistoryReader
+{
+    public:
+        PopulationHistoryReader(std::string const & filename);
+        ~PopulationHistoryReader();
+
+        PopulationHistoryReader(PopulationHistoryReader const &) = delete;
+        PopulationHistoryReader & operator=(PopulationHistoryReader const &) = delete;
+
+        bool isOpen() const;
+
+        std::size_t getGenomeSize() const;
+        std::size_t getGenerationCount() const;
+        HistoryIndexEntry const & getGeneration(std::size_t g) const;
+
+        // Record i of the g-th generation of the index, then its genome
+        HistoryRecord const & getRecord(std::size_t g, std::size_t i) const;
+        float const * getGenome(HistoryRecord const & record) const;
+
+    private:
+        char const * m_data;
+        std::size_t m_size;
+        HistoryIndexEntry const * m_index;
+        std::size_t m_indexSize;
+        std::size_t m_ngenerations;
+        std::size_t m_genomeSize;
+        std::size_t m_stride;
+};
+
+#endif //POPULATION_HISTORY_HPP
@@ -0,0 +1,77 @@
+#ifndef NEURO_CAR_QUANTIZED_NETWORK_HPP
+#define NEURO_CAR_QUANTIZED_NETWORK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <neural_network.hpp>
+
+namespace NeuroCar {
+
+// Post-training quantization of an evolved network.
+// Weights are stored as int8 with one scale per layer, activations are
+// quantized to int16 with per-layer scales calibrated on recorded inputs.
+// The controller only needs the sign of (output - 0.5), i.e. the sign of the
+// last pre-activation, so the last layer never leaves the integer domain.
+class QuantizedNetwork
+{
+    public:
+        using Weight = NeuroEvolution::Weight;
+        using Shape = std::vector<uint32_t>;
+
+    public:
+        QuantizedNetwork();
+
+        // calibrationInputs: concatenated input vectors recorded while
+        // driving with the float network
+        static QuantizedNetwork quantize(
+            NeuroEvolution::NeuralNetwork const & nn,
+            std::vector<Weight> const & calibrationInputs
+        );
+
+        Shape const & getShape() const;
+
+        // Bit i is set when output i is greater than 0.5
+        uint32_t computeFlags(Weight const * inputs) const;
+
+        // Dequantized outputs, mostly for diagnostics
+        void compute(Weight const * inputs, Weight * outputs) const;
+
+        // Size of the serialized network in bytes
+        std::size_t byteSize() const;
+
+    private:
+        struct Layer
+        {
+            uint32_t inputs;
+            uint32_t outputs;
+            float inputScale;  // Real activation = int16 activation * scale
+            float weightScale; // Real weight = int8 weight * scale
+            std::vector<int8_t> weights; // outputs x inputs, row-major
+            std::vector<int32_t> biases; // In inputScale * weightScale units
+
+            // Rows widened to int16 and padded for the SIMD dot products
+            uint32_t stride;
+            std::vector<int16_t> rows;
+        };
+
+        void prepare();
+        void quantizeInputs(Layer const & layer, Weight const * inputs, int16_t * q) const;
+        void accumulate(Layer const & layer, int16_t const * q, int32_t * acc) const;
+
+        friend bool saveToFile(QuantizedNetwork const &, std::string const &);
+        friend bool loadFromFile(std::string const &, QuantizedNetwork &);
+
+    private:
+        Shape m_shape;
+        std::vector<Layer> m_layers;
+};
+
+bool saveToFile(QuantizedNetwork const & qnn, std::string const & filename);
+bool loadFromFile(std::string const & filename, QuantizedNetwork & qnn);
+
+}
+
+#endif //NEURO_CAR_QUANTIZED_NETWORK_HPP
@@ -0,0 +1,88 @@
+#ifndef NEURO_CAR_RUN_STATUS_HPP
+#define NEURO_CAR_RUN_STATUS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <genome.hpp>
+
+namespace NeuroCar {
+
+// State of a running evolution, as published to the status segment
+struct RunStatus
+{
+    uint64_t generation = 0;
+    uint64_t evaluations = 0;      // Episodes simulated since the start
+    double evaluationsPerSecond = 0.0;
+    double bestFitness = 0.0;      // Best fitness so far
+    uint64_t updateTime = 0;       // Milliseconds since the epoch
+    Genome bestGenome;             // Genome of the best individual so far
+};
+
+struct RunStatusSegment;
+
+// Publishes the status of the run in a POSIX shared memory segment.
+// Every update goes through a seqlock: the sequence number is odd while the
+// block is written, readers copy the block and retry if it changed meanwhile.
+// Readers never take a lock, so they cannot slow the run down.
+class RunStatusWriter
+{
+    public:
+        // name: shared memory object name, e.g. "/neuro_car"
+        RunStatusWriter(std::string const & name, std::size_t maxGenomeSize);
+        ~RunStatusWriter();
+
+        RunStatusWriter(RunStatusWriter const &) = delete;
+        RunStatusWriter & operator=(RunStatusWriter const &) = delete;
+
+        bool isOpen() const;
+
+        // Update the generation and the evaluation counters
+        void publish(uint64_t generation, uint64_t evaluations);
+
+        // Also replace the best individual if its fitness is higher
+        void publish(
+            uint64_t generation, uint64_t evaluations,
+            double fitness, Genome const & genome
+        );
+
+    private:
+        void write(uint64_t generation, uint64_t evaluations, Genome const * genome);
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::string m_name;
+        RunStatusSegment * m_segment;
+        std::size_t m_size;
+
+        RunStatus m_status;
+        Clock::time_point m_lastTime;
+        uint64_t m_lastEvaluations;
+};
+
+// Attaches read-only to the segment of a RunStatusWriter
+class RunStatusReader
+{
+    public:
+        RunStatusReader(std::string const & name);
+        ~RunStatusReader();
+
+        RunStatusReader(RunStatusReader const &) = delete;
+        RunStatusReader & operator=(RunStatusReader const &) = delete;
+
+        bool isOpen() const;
+
+        // Consistent copy of the status (false if no writer ever published)
+        bool read(RunStatus & status) const;
+
+    private:
+        RunStatusSegment const * m_segment;
+        std::size_t m_size;
+};
+
+}
+
+#endif //NEURO_CAR_RUN_STATUS_HPP
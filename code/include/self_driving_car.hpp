@@ -2,10 +2,15 @@
 #define NEURO_CAR_SELF_DRIVING_CAR_HPP
 
 #include <memory>
+#include <vector>
 
 #include <car.hpp>
+#include <curriculum.hpp>
 #include <dna.hpp>
+#include <genome.hpp>
 #include <neuro_controller.hpp>
+#include <pool_stats.hpp>
+#include <trajectory_recorder.hpp>
 
 namespace NeuroCar {
 
@@ -33,6 +38,18 @@ class SelfDrivingCar
         NeuralNetwork & getNeuralNetwork();
         NeuralNetwork const & getNeuralNetwork() const;
 
+        // Flat copy of the weights the genetic operators work on
+        Genome const & getGenome() const;
+
+        // Genome to modify: the network is only updated by syncNeuralNetwork
+        Genome & editGenome();
+
+        // Reload the genome after a direct change of the neural network
+        void syncGenome();
+
+        // Write the modified genome back into the neural network
+        void syncNeuralNetwork();
+
         b2Vec2 const & getDestination() const;
         void setDestination(b2Vec2 destination);
 
@@ -43,13 +60,22 @@ class SelfDrivingCar
 
         void setCar(std::shared_ptr<Car> car);
 
+        // Rank under which the next episode is recorded (-1: not recorded)
+        void setTraceRank(int32_t rank);
+        int32_t getTraceRank() const;
+
 
     private:
         std::shared_ptr<Car> m_car;
         NeuroController m_neuroController;
 
+        Genome m_genome;
+        bool m_networkOutdated;
+
         uint32_t m_worldSeed;
         b2Vec2 m_destination;
+
+        int32_t m_traceRank;
 };
 
 } // NeuroCar
@@ -64,11 +90,64 @@ struct DNAParams<NeuroCar::SelfDrivingCarDNA>
     uint32_t worldNbObstacles = 15;
     uint32_t worldSeedChangeInterval = 100;
     uint32_t worldSimulationRate = 10;
+
+    // Box2D constraint solver iterations per physics step
+    uint32_t velocityIterations = 8;
+    uint32_t positionIterations = 3;
+
+    // Coarse fidelity of multi-fidelity evaluation: physics steps per
+    // simulated second and solver iterations. The episode length and the
+    // control period are scaled to the same simulated time.
+    uint32_t coarseSimulationRate = 5;
+    uint32_t coarseVelocityIterations = 4;
+    uint32_t coarsePositionIterations = 2;
+
+    // Maximum number of physics steps of an episode (0: let the world decide).
+    // Partial evaluations (racing) require a finite episode length.
+    uint32_t episodeLength = 0;
+
+    // Physics steps between two decisions of the network. The car is
+    // controlled at worldSimulationRate / controlPeriod decisions per
+    // simulated second, holding its flags in between.
+    uint32_t controlPeriod = 1;
+
+    // Probability for a mutation to zero each connection weight
+    double pruneRate = 0.0;
+
+    // Drive with the non-zero weights only, compacted before each episode
+    // (dense inference by default)
+    bool sparseInference = false;
+
+    // Positions sampled along the episode for the behavior descriptor of
+    // novelty search, besides the final one (requires episodeLength)
+    uint32_t behaviorSamples = 0;
+
+    // Episode-length schedule, growing up to episodeLength (nullptr: fixed)
+    std::shared_ptr<NeuroCar::EpisodeCurriculum> curriculum = nullptr;
+
+    // Destination of the episodes of the individuals marked with a trace rank
+    std::shared_ptr<NeuroCar::TrajectoryRecorder> recorder = nullptr;
 };
 
 
 namespace NeuroCar {
 
+// Allocations done by the evolution of self driving cars. Only the
+// individuals are recycled: car_physics cannot reset a Car or a World after
+// an episode, so each evaluation still allocates one of each (cloneInitial,
+// createWorld), counted here but not pooled.
+struct SelfDrivingCarPoolStats
+{
+    PoolCounts individuals; // Reuses: individuals recycled by crossoverInto
+    PoolCounts worlds;      // Reuses: world seeds validated from the cache
+    PoolCounts cars;        // Never reused
+};
+
+SelfDrivingCarPoolStats getPoolStats();
+
+// Episodes simulated since the start of the process
+uint64_t getEpisodeCount();
+
 class SelfDrivingCarDNA : public DNA<SelfDrivingCar, SelfDrivingCarDNA>
 {
     public:
@@ -77,12 +156,43 @@ class SelfDrivingCarDNA : public DNA<SelfDrivingCar, SelfDrivingCarDNA>
         virtual void init(Params const & params) override;
         virtual void randomize(std::size_t seed) override;
         virtual Fitness computeFitness(std::size_t ngen = 0) override;
+        virtual Fitness computePartialFitness(std::size_t ngen, double budget) override;
+        // The episode at the coarse physics rate and solver iterations. Not
+        // recorded: the trace rank is kept for the full evaluation.
+        virtual Fitness computeCoarseFitness(std::size_t ngen) override;
         virtual void reset() override;
         virtual Subject crossover(SelfDrivingCarDNA const & partner) const override;
+        virtual void crossoverInto(
+            SelfDrivingCarDNA const & partner, SelfDrivingCarDNA & child
+        ) const override;
         virtual void mutate(MutationRate mutationRate) override;
+        // The genome, none until the genetic operators produced one
+        virtual float const * getFeatures(std::size_t & size) const override;
+        virtual bool setFeatures(float const * features, std::size_t size) override;
+        // Sampled and final positions of the last episode
+        virtual float const * getBehavior(std::size_t & size) const override;
+        // Fitness, survival, steadiness and straightness of the last episode
+        virtual double const * getObjectives(std::size_t & size) const override;
+        // Fitness, behavior and objectives. Decoding a complete evaluation
+        // counts an episode.
+        virtual void encodeEvaluation(std::vector<char> & data) const override;
+        virtual bool decodeEvaluation(char const * data, std::size_t size) override;
+        // Find the valid seed of the world of generation ngen when it changes,
+        // so that the evaluations find it cached
+        virtual std::function<void ()> prepareEvaluation(std::size_t ngen) const override;
+
+        // Seed of the world the individual is evaluated in at generation ngen
+        uint32_t getWorldSeed(std::size_t ngen) const;
+
+    private:
+        uint32_t getEpisodeLength(std::size_t ngen) const;
+        Fitness simulate(std::size_t ngen, uint32_t maxSteps, uint32_t fixedSteps);
+        void breed(SelfDrivingCarDNA const & partner, SelfDrivingCar & child) const;
 
     private:
         Params m_params;
+        std::vector<float> m_behavior;
+        std::vector<double> m_objectives;
 };
 
 }
@@ -0,0 +1,65 @@
+#ifndef NEURO_CAR_SPARSE_NETWORK_HPP
+#define NEURO_CAR_SPARSE_NETWORK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <genome.hpp>
+#include <neural_network.hpp>
+
+namespace NeuroCar {
+
+// Inference network keeping only the non-zero weights of a genome, one CSR
+// matrix per layer. Compacted once per individual before its episode; the
+// buffers are reused by the next compaction. When AVX2 or AVX-512 is active,
+// the rows are also stored by slices of 8 rows, summed one row per SIMD lane.
+class SparseNetwork
+{
+    public:
+        using Weight = NeuroEvolution::Weight;
+        using Shape = NeuroEvolution::NeuralNetwork::Shape;
+
+    public:
+        SparseNetwork();
+
+        void compact(Shape const & shape, Genome const & genome);
+
+        // Same results as the dense network with the same genome
+        void compute(Weight const * inputs, Weight * outputs) const;
+
+        Shape const & getShape() const;
+
+        std::size_t getConnectionCount() const;
+        std::size_t getActiveConnectionCount() const;
+
+    private:
+        struct Layer
+        {
+            uint32_t inputs = 0;
+            uint32_t outputs = 0;
+            std::vector<uint32_t> rowStart; // outputs + 1 offsets into columns
+            std::vector<uint16_t> columns;
+            std::vector<float> values;
+            std::vector<float> biases;
+
+            // The k-th connections of the rows of a slice are contiguous,
+            // zero-padded up to the longest row of the slice. Only the full
+            // slices are stored: the last rows are read from the CSR arrays.
+            std::vector<uint32_t> sliceStart; // slices + 1 offsets, in steps of 8 connections
+            std::vector<int32_t> sliceColumns;
+            std::vector<float> sliceValues;
+        };
+
+    private:
+        Shape m_shape;
+        std::vector<Layer> m_layers;
+        std::size_t m_connections;
+
+        mutable std::vector<Weight> m_activations;
+        mutable std::vector<Weight> m_next;
+};
+
+}
+
+#endif //NEURO_CAR_SPARSE_NETWORK_HPP
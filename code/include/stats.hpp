@@ -3,6 +3,9 @@
 
 #include <algorithm>
 #include <fstream>
+#include <limits>
+
+#include <pareto.hpp>
 
 class StatsAll
 {
@@ -121,7 +124,30 @@ class Stats
             std::size_t n = std::min(i+1, m_history.size());
             Fitness meanN = cumulativeFitness / static_cast<Fitness>(n);
 
-            m_file << maxFitness << ", " << mean << ", " << meanN << std::endl;
+            m_file << maxFitness << ", " << mean << ", " << meanN << ", " << dnas.size();
+
+            // Best value of each objective, when the dnas have some
+            std::size_t nobjectives = 0;
+            dnas.front().getObjectives(nobjectives);
+            for(auto k = 0u; k < nobjectives; ++k)
+            {
+                double best = -std::numeric_limits<double>::infinity();
+                for(auto const & dna : dnas)
+                {
+                    std::size_t size = 0;
+                    double const * objectives = dna.getObjectives(size);
+                    if(objectives && size == nobjectives) best = std::max(best, objectives[k]);
+                }
+                m_file << ", " << best;
+            }
+
+            m_file << std::endl;
+        }
+
+        // Comment line, e.g. the reason the run stopped
+        void note(std::string const & text)
+        {
+            m_file << "# " << text << std::endl;
         }
 
     private:
@@ -131,6 +157,38 @@ class Stats
         std::size_t m_index;
 };
 
+// Write the objectives of the Pareto front of the dnas, one per line
+template <typename DNAType>
+bool dumpParetoFront(std::string const & filename, DNAs<DNAType> const & dnas)
+{
+    std::size_t nobjectives = 0;
+    if(dnas.empty() || !dnas.front().getObjectives(nobjectives)) return false;
+
+    std::vector<double> objectives;
+    for(auto const & dna : dnas)
+    {
+        std::size_t size = 0;
+        double const * o = dna.getObjectives(size);
+        if(o && size == nobjectives) objectives.insert(objectives.end(), o, o + size);
+    }
+
+    std::size_t const n = objectives.size() / nobjectives;
+    std::vector<uint32_t> ranks;
+    nondominatedSort(objectives.data(), n, nobjectives, ranks);
+
+    std::ofstream file(filename, std::ios::out | std::ios::trunc);
+    for(auto i = 0u; i < n && file; ++i)
+    {
+        if(ranks[i] != 0) continue;
+
+        for(auto k = 0u; k < nobjectives; ++k)
+        {
+            file << (k > 0 ? ", " : "") << objectives[i * nobjectives + k];
+        }
+        file << std::endl;
+    }
 
+    return bool(file);
+}
 
 #endif //STATS_HPP
@@ -0,0 +1,40 @@
+#ifndef SURROGATE_HPP
+#define SURROGATE_HPP
+
+#include <cstddef>
+#include <vector>
+
+// k-nearest-neighbours regression of the fitness over flat feature vectors
+// (genomes), trained online on the most recent full evaluations. Prediction
+// is a linear scan of the samples: O(capacity * dimension).
+class SurrogateModel
+{
+    public:
+        SurrogateModel();
+
+        // Drops the samples
+        void configure(std::size_t capacity, std::size_t neighbours);
+
+        // Replaces the oldest sample once full. The first sample sets the
+        // dimension, vectors of another size are ignored.
+        void add(float const * features, std::size_t size, double fitness);
+
+        bool accepts(std::size_t size) const;
+
+        // Inverse-distance weighted mean of the fitness of the nearest samples.
+        // Thread-safe, requires accepts(size) and at least one sample.
+        double predict(float const * features, std::size_t size) const;
+
+        std::size_t getSampleCount() const;
+
+    private:
+        std::size_t m_capacity;
+        std::size_t m_neighbours;
+        std::size_t m_dimension;
+        std::size_t m_count;
+        std::size_t m_next;
+        std::vector<float> m_features; // m_capacity rows of m_dimension
+        std::vector<double> m_fitness;
+};
+
+#endif //SURROGATE_HPP
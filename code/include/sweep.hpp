@@ -0,0 +1,138 @@
+#ifndef NEURO_CAR_SWEEP_HPP
+#define NEURO_CAR_SWEEP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <car.hpp>
+#include <evolution.hpp>
+#include <self_driving_car.hpp>
+
+namespace NeuroCar {
+
+// One evolution of a sweep
+struct ExperimentConfig
+{
+    std::string name;
+    double mutationRate = 0.01;
+    uint32_t elitism = 2;
+    std::size_t nindividuals = 100;
+    std::size_t ngenerations = 100;
+    uint32_t worldSeedChangeInterval = 10;
+    int32_t worldSeed = 0;
+
+    // Share of the threads under the Priority policy
+    double priority = 1.0;
+};
+
+enum class SweepPolicy
+{
+    FairShare, // Experiments start in file order and get the same share
+    Priority   // Highest priorities start first, shares follow the priorities
+};
+
+struct SweepParams
+{
+    std::vector<ExperimentConfig> experiments;
+
+    uint32_t nthreads = 1;
+    SweepPolicy policy = SweepPolicy::FairShare;
+    RacingParams racing = { };
+    SurrogateParams surrogate = { };
+    MultiFidelityParams multiFidelity = { };
+    NoveltyParams novelty = { };
+    MultiObjectiveParams multiObjective = { };
+    StopParams stop = { };
+
+    // Directory of the stats (<name>.csv) and best network (<name>.txt) files
+    std::string outputDirectory = ".";
+
+    // Called at the end of each generation of each experiment, one call at a
+    // time, from the thread running the experiment
+    using GenerationHook = std::function<
+        void (ExperimentConfig const &, std::size_t ngen, double bestFitness, uint32_t nthreads)
+    >;
+    GenerationHook generationHook = nullptr;
+};
+
+struct ExperimentResult
+{
+    std::string name;
+    double bestFitness = 0.0;
+    std::size_t generations = 0;
+    std::size_t evaluations = 0; // Individuals evaluated
+    double seconds = 0.0;        // Wall time
+};
+
+// Read the experiments of a sweep file. Each line is a grid of experiments:
+// space-separated key=value fields, comma-separated values being combined with
+// every value of the other keys. Keys: name, mutation, elitism, population,
+// generations, interval, seed, priority. Missing keys take the value of
+// defaults. Lines starting with '#' are comments.
+//   name=small population=50 mutation=0.005,0.01,0.02 elitism=1,2
+bool loadSweepFile(
+    std::string const & filename,
+    ExperimentConfig const & defaults,
+    std::vector<ExperimentConfig> & experiments,
+    std::string & error
+);
+
+// Split of the threads of the process between the running experiments of a
+// sweep. Every running experiment gets at least one thread, the remaining
+// ones are shared by weight; shares are recomputed whenever an experiment
+// starts or ends, and applied at the next generation.
+class SweepScheduler
+{
+    public:
+        SweepScheduler(uint32_t nthreads, SweepPolicy policy, std::vector<double> const & priorities);
+
+        // Next experiment to start, false when none is left
+        bool next(std::size_t & experiment);
+
+        // Threads of a running experiment
+        uint32_t threads(std::size_t experiment);
+
+        void finish(std::size_t experiment);
+
+        // Maximum number of experiments running at the same time
+        std::size_t getMaxConcurrency() const;
+
+    private:
+        void rebalance();
+
+    private:
+        std::mutex m_mutex;
+        uint32_t m_nthreads;
+        std::vector<double> m_weights;
+        std::vector<std::size_t> m_pending; // Next to start at the back
+        std::vector<std::size_t> m_running;
+        std::vector<uint32_t> m_shares;
+};
+
+// Run the experiments concurrently in this process, on params.nthreads
+// threads in total. The experiments share the world caches.
+std::vector<ExperimentResult> runSweep(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    SweepParams const & params
+);
+
+// Reference for runSweep: each experiment in a forked process of its own,
+// all at once and each on params.nthreads threads, as independent runs would
+// be. Nothing is shared between the processes. Fork before this process
+// starts its OpenMP threads. Empty results for the failed children.
+std::vector<ExperimentResult> runSweepProcesses(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    SweepParams const & params
+);
+
+}
+
+#endif //NEURO_CAR_SWEEP_HPP
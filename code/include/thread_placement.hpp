@@ -0,0 +1,77 @@
+#ifndef THREAD_PLACEMENT_HPP
+#define THREAD_PLACEMENT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// NUMA-aware execution: the OpenMP threads are pinned to cores, in
+// contiguous blocks per NUMA node, and the population is split in one
+// contiguous shard per node. The threads of a node evaluate and breed the
+// individuals of its shard, so that their allocations (network, world,
+// Box2D bodies) are first touched, and later reused, on that node. A thread
+// only takes work from another shard once its own is done.
+struct ThreadPlacementParams
+{
+    bool enabled = false;
+};
+
+// CPUs of each NUMA node, from /sys/devices/system/node: a single node with
+// every CPU the process may run on when the machine has no NUMA information
+struct NumaTopology
+{
+    std::vector<std::vector<int>> nodes;
+};
+
+NumaTopology const & numaTopology();
+
+// Node of a thread of a team of nthreads: nthreads / nnodes consecutive
+// threads per node
+std::size_t threadNode(std::size_t thread, std::size_t nthreads, std::size_t nnodes);
+
+// Pin each thread of the next OpenMP teams (omp_get_max_threads() threads)
+// to a CPU of its node, round-robin over the CPUs of the node. To be called
+// outside of any parallel region, again when the number of threads changes.
+// False if the threads could not be pinned.
+bool pinThreads();
+
+// Let each thread of the next OpenMP teams run on any CPU of the topology
+// again. False if the affinity could not be reset.
+bool unpinThreads();
+
+// Let the calling thread run on any CPU of the topology again. Threads and
+// processes inherit the affinity of their creator: the helper threads and
+// the worker processes started by a pinned thread call it first.
+bool unpinCurrentThread();
+
+// Dynamic schedule of the loop [0, n[ split in nshards contiguous shards,
+// shard s being [n s / nshards, n (s + 1) / nshards[. Threads take chunks of
+// their own shard first, then of the others in turn once it is drained.
+class ShardedSchedule
+{
+    public:
+        ShardedSchedule(std::size_t n, std::size_t nshards, std::size_t chunk);
+
+        std::size_t getShardCount() const;
+
+        // Next chunk [begin, end[ for a thread of the given shard, thread-safe.
+        // False once the whole loop is handed out.
+        bool next(std::size_t shard, std::size_t & begin, std::size_t & end);
+
+    private:
+        // One cache line per shard: the counters are contended
+        struct Shard
+        {
+            std::atomic<std::size_t> next;
+            std::size_t end;
+            char padding[64 - sizeof(std::atomic<std::size_t>) - sizeof(std::size_t)];
+        };
+
+    private:
+        std::size_t m_nshards;
+        std::size_t m_chunk;
+        std::unique_ptr<Shard[]> m_shards;
+};
+
+#endif //THREAD_PLACEMENT_HPP
@@ -0,0 +1,87 @@
+#ifndef NEURO_CAR_TRAJECTORY_RECORDER_HPP
+#define NEURO_CAR_TRAJECTORY_RECORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <car.hpp>
+#include <neural_network.hpp>
+
+namespace NeuroCar {
+
+// Header of an episode block of a trace file.
+// An episode longer than the per-thread buffer is split in several parts.
+struct TrajectoryHeader
+{
+    uint32_t generation;
+    uint32_t rank;        // Rank of the individual when it was selected
+    uint32_t worldSeed;
+    uint32_t part;
+    uint16_t ninputs;
+    uint16_t noutputs;
+    uint32_t nframes;
+    uint32_t payloadSize; // Bytes of delta-encoded frames following the header
+};
+
+struct TrajectoryFrame
+{
+    float x;
+    float y;
+    float angle;
+    std::vector<float> inputs;  // Sensor distances then angle to destination
+    std::vector<float> outputs;
+    uint32_t flags;
+};
+
+// Records the steps of selected episodes to a binary trace file.
+// Frames are captured in a preallocated buffer of the recording thread and
+// flushed as one block per episode: fixed-point values, delta-encoded from
+// the previous frame as zigzag varints. Blocks are self-sized, so that the
+// file can be walked in place once memory-mapped.
+class TrajectoryRecorder
+{
+    public:
+        using Weight = NeuroEvolution::Weight;
+
+    public:
+        TrajectoryRecorder(std::string const & filename, std::size_t bufferFrames = 4096);
+
+        bool isOpen() const;
+
+        // Episode of the calling thread
+        void beginEpisode(uint32_t generation, uint32_t rank, uint32_t worldSeed);
+        void record(
+            b2Vec2 const & pos, float angle,
+            Weight const * inputs, std::size_t ninputs,
+            Weight const * outputs, std::size_t noutputs,
+            uint32_t flags
+        );
+        void endEpisode();
+
+    private:
+        struct Buffer;
+
+        void flush(Buffer & buffer);
+        Buffer & localBuffer();
+
+    private:
+        std::mutex m_mutex;
+        std::ofstream m_file;
+        std::size_t m_bufferFrames;
+};
+
+// Decode every frame of a trace file
+using TrajectoryCallback = std::function<
+    void (TrajectoryHeader const &, std::vector<TrajectoryFrame> const &)
+>;
+
+bool readTrajectories(std::string const & filename, TrajectoryCallback const & callback);
+
+}
+
+#endif //NEURO_CAR_TRAJECTORY_RECORDER_HPP
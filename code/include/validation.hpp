@@ -0,0 +1,72 @@
+#ifndef NEURO_CAR_VALIDATION_HPP
+#define NEURO_CAR_VALIDATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <car.hpp>
+#include <self_driving_car.hpp>
+
+namespace NeuroCar {
+
+struct ValidationParams
+{
+    // Saved networks to score. Files ending in ".q8" are quantized networks.
+    std::vector<std::string> networkFiles;
+
+    // World seeds [firstSeed, firstSeed + nseeds[
+    int32_t firstSeed = 0;
+    uint32_t nseeds = 1000;
+
+    // An episode is a success when its fitness reaches this value
+    double successFitness = 0.95;
+
+    // Control periods each network is scored with (empty: the one of the
+    // DNA parameters), to compare their cost and fitness
+    std::vector<uint32_t> controlPeriods;
+
+    // Score each network with both dense and sparse inference (quantized
+    // networks only run quantized)
+    bool compareSparse = false;
+};
+
+struct ValidationResult
+{
+    std::string filename;
+    bool loaded = false;
+    uint32_t controlPeriod = 1;
+    bool quantized = false;
+    bool sparse = false;
+
+    std::size_t episodes = 0;
+    std::size_t successes = 0;
+
+    // Fitness distribution
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double p10 = 0.0;
+    double median = 0.0;
+    double p90 = 0.0;
+    double max = 0.0;
+
+    // Time spent simulating the episodes of the network (all threads)
+    double seconds = 0.0;
+};
+
+// Evaluate every (network, control period, inference, seed) in parallel. The
+// valid world of each seed is searched once and shared by all the networks.
+// One result per network, control period and inference, in that order
+// (a single inference for the quantized networks).
+std::vector<ValidationResult> validateNetworks(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    ValidationParams const & params
+);
+
+}
+
+#endif //NEURO_CAR_VALIDATION_HPP
@@ -0,0 +1,106 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct WorkerPoolParams
+{
+    // Evaluate in worker processes rather than in the OpenMP threads
+    bool enabled = false;
+
+    // Number of worker processes (0: the number of threads)
+    std::size_t nworkers = 0;
+
+    // Jobs per message, and messages sent ahead to each worker
+    std::size_t batchSize = 4;
+    std::size_t batchesInFlight = 2;
+
+    // Dispatches of a job before it is given up (its worker died each time)
+    std::size_t maxAttempts = 3;
+
+    // Seconds a job may run before its worker is considered hung, killed and
+    // replaced like a dead one (0: no limit)
+    double jobTimeout = 300.0;
+};
+
+struct WorkerPoolReport
+{
+    std::size_t jobs = 0;
+    std::size_t batches = 0;
+    std::size_t restarts = 0;  // Workers that died and were replaced
+    std::size_t timeouts = 0;  // Of them, workers killed by the job timeout
+    std::size_t retries = 0;   // Jobs sent again after the death of a worker
+    std::size_t failures = 0;  // Jobs given up, or failed by the handler
+    double seconds = 0.0;
+};
+
+// Pool of worker processes evaluating jobs for the parent process. Each
+// worker is a fork of the parent, taken when it starts, talking to it over a
+// Unix domain socket pair: the parent sends batches of jobs ahead and the
+// worker streams back the result of each job as soon as it is done. A
+// worker that dies (crash, failed assertion, kill) or runs a job for longer
+// than the job timeout is replaced and its unfinished jobs are sent again,
+// so that it takes a single job down with it at worst.
+//
+// The workers are forked from the thread calling the constructor and run(),
+// which must be outside of any parallel region. The handler must not rely on
+// OpenMP (the thread pool of the runtime does not survive a fork).
+class WorkerPool
+{
+    public:
+        // Run by the workers: result of the job described by request. The
+        // job fails if the handler returns false or throws.
+        using Handler = std::function<
+            bool (char const * request, std::size_t size, std::vector<char> & result)
+        >;
+
+        // Run by the parent as the results come (nullptr: the job failed)
+        using ResultCallback = std::function<
+            void (std::size_t job, char const * result, std::size_t size)
+        >;
+
+        WorkerPool(WorkerPoolParams const & params, Handler handler);
+        ~WorkerPool();
+
+        WorkerPool(WorkerPool const &) = delete;
+        WorkerPool & operator=(WorkerPool const &) = delete;
+
+        // False if no worker could be started
+        bool isOpen() const;
+        std::size_t size() const;
+
+        // Evaluate the jobs, request j being data[offsets[j], offsets[j + 1][.
+        // Returns once every job succeeded or failed.
+        WorkerPoolReport run(
+            std::vector<char> const & data,
+            std::vector<std::size_t> const & offsets,
+            ResultCallback const & onResult
+        );
+
+    private:
+        struct Worker
+        {
+            int pid = -1;
+            int socket = -1;
+            std::vector<uint32_t> jobs;   // Sent, result not received yet
+            std::chrono::steady_clock::time_point started; // Of the first job
+            std::vector<char> output;     // Not sent yet
+            std::size_t written = 0;      // Bytes of output already sent
+            std::vector<char> input;      // Partial results
+        };
+
+        bool spawn(Worker & worker);
+        void stop(Worker & worker, bool kill);
+        void serve(int socket) const;
+
+    private:
+        WorkerPoolParams m_params;
+        Handler m_handler;
+        std::vector<Worker> m_workers;
+};
+
+#endif //WORKER_POOL_HPP
@@ -0,0 +1,68 @@
+#ifndef NEURO_CAR_WORLD_CACHE_HPP
+#define NEURO_CAR_WORLD_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <tuple>
+
+namespace NeuroCar {
+
+// Parameters determining the layout of a world and the validity of its seed
+struct WorldKey
+{
+    uint32_t seed;
+    uint32_t width;
+    uint32_t height;
+    uint32_t nbObstacles;
+    float spawnX;
+    float spawnY;
+
+    bool operator<(WorldKey const & rhs) const
+    {
+        return std::tie(seed, width, height, nbObstacles, spawnX, spawnY) <
+            std::tie(rhs.seed, rhs.width, rhs.height, rhs.nbObstacles,
+                rhs.spawnX, rhs.spawnY);
+    }
+};
+
+// Valid seeds shared by all the runs using the same directory, in a file of
+// fixed-size records. A layout is fully determined by its valid seed, so a
+// record replaces the generation and collision test of the rejected worlds.
+// Writers append whole records with O_APPEND, so any number of processes can
+// read and write the file at the same time; duplicate records are harmless.
+// Records are stored in native byte order.
+class WorldCache
+{
+    public:
+        using Callback = std::function<void (WorldKey const &, uint32_t validSeed)>;
+
+    public:
+        WorldCache();
+        ~WorldCache();
+
+        WorldCache(WorldCache const &) = delete;
+        WorldCache & operator=(WorldCache const &) = delete;
+
+        // Open directory/worlds.ncwc, creating the directory and the file
+        bool open(std::string const & directory);
+        bool isOpen() const;
+
+        std::string const & getFilename() const;
+
+        // Read the records appended since the last call by any process.
+        // Returns the number of records read.
+        std::size_t load(Callback const & callback);
+
+        bool append(WorldKey const & key, uint32_t validSeed);
+
+    private:
+        std::string m_filename;
+        int m_fd;
+        std::size_t m_loaded; // Bytes of the file already read
+};
+
+}
+
+#endif //NEURO_CAR_WORLD_CACHE_HPP
@@ -0,0 +1,48 @@
+#ifndef NEURO_CAR_WORLD_FACTORY_HPP
+#define NEURO_CAR_WORLD_FACTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <car.hpp>
+#include <pool_stats.hpp>
+#include <self_driving_car.hpp>
+#include <world_cache.hpp>
+
+class Renderer;
+
+namespace NeuroCar {
+
+using WorldParams = DNAParams<SelfDrivingCarDNA>;
+
+// Build the world of a seed, without checking that the car fits in it.
+// The renderer is only used in graphic mode.
+std::unique_ptr<World> createWorld(
+    WorldParams const & params, uint32_t seed, Renderer * renderer = nullptr
+);
+
+// First seed from seed on whose world does not collide with the car at its
+// spawn point. Valid seeds are cached process-wide, and across runs once a
+// world cache is open, so the rejected worlds of a seed are only built once.
+uint32_t findValidSeed(
+    WorldParams const & params, std::shared_ptr<Car> const & car, uint32_t seed
+);
+
+// World of findValidSeed(params, car, seed)
+std::unique_ptr<World> createValidWorld(
+    WorldParams const & params, std::shared_ptr<Car> const & car, uint32_t seed,
+    Renderer * renderer = nullptr
+);
+
+// Back the valid seed cache with the WorldCache of a directory, shared with
+// the other runs using it. nseeds: number of valid seeds known after loading.
+bool openWorldCache(std::string const & directory, std::size_t & nseeds);
+
+// Allocations: worlds built. Reuses: valid seeds found in the cache.
+PoolCounts getWorldCounts();
+
+}
+
+#endif //NEURO_CAR_WORLD_FACTORY_HPP
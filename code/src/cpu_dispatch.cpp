@@ -0,0 +1,88 @@
+#include <cpu_dispatch.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+
+namespace {
+
+struct IsaSelection
+{
+    Isa isa;
+    bool overridden;
+};
+
+IsaSelection selectIsa()
+{
+    Isa const detected = detectIsa();
+    IsaSelection selection = { detected, false };
+
+    char const * forced = std::getenv("NEURO_CAR_ISA");
+    if(!forced) return selection;
+
+    for(auto isa : { Isa::Generic, Isa::Avx2, Isa::Avx512 })
+    {
+        if(std::strcmp(forced, isaName(isa)) != 0) continue;
+
+        if(isa <= detected)
+        {
+            selection.isa = isa;
+            selection.overridden = isa != detected;
+        }
+        else
+        {
+            std::cout << "Warning: NEURO_CAR_ISA=" << forced << " is not supported by the CPU, "
+                      << "using " << isaName(detected) << std::endl;
+        }
+        return selection;
+    }
+
+    std::cout << "Warning: unknown NEURO_CAR_ISA value \"" << forced << "\" "
+              << "(generic, avx2 or avx512), using " << isaName(detected) << std::endl;
+    return selection;
+}
+
+IsaSelection const & selection()
+{
+    static IsaSelection const s = selectIsa();
+    return s;
+}
+
+}
+
+char const * isaName(Isa isa)
+{
+    switch(isa)
+    {
+        case Isa::Avx512: return "avx512";
+        case Isa::Avx2:   return "avx2";
+        default:          return "generic";
+    }
+}
+
+Isa detectIsa()
+{
+    #if NEURO_CAR_DISPATCH
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+    {
+        return Isa::Avx512;
+    }
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return Isa::Avx2;
+    }
+    #endif
+    return Isa::Generic;
+}
+
+Isa activeIsa()
+{
+    return selection().isa;
+}
+
+bool isaOverridden()
+{
+    return selection().overridden;
+}
@@ -0,0 +1,109 @@
+#include <curriculum.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace NeuroCar {
+
+EpisodeCurriculum::EpisodeCurriculum(
+    CurriculumParams const & params,
+    uint32_t fullLength,
+    uint32_t worldSeedChangeInterval
+):
+    m_params(params),
+    m_fullLength(fullLength),
+    m_worldInterval(std::max(1u, worldSeedChangeInterval)),
+    m_adaptiveLength(0),
+    m_growthPending(false),
+    m_plateauFitness(0.0),
+    m_plateauLength(0),
+    m_episodes(0),
+    m_budgetSteps(0),
+    m_fixedSteps(0),
+    m_simulatedSteps(0)
+{
+    double const start = std::max(0.0, std::min(1.0, m_params.startFraction));
+    m_adaptiveLength = std::max(1u, static_cast<uint32_t>(std::round(start * m_fullLength)));
+}
+
+std::size_t EpisodeCurriculum::worldStart(std::size_t ngen) const
+{
+    return ngen - ngen % m_worldInterval;
+}
+
+uint32_t EpisodeCurriculum::getEpisodeLength(std::size_t ngen) const
+{
+    if(m_params.type == CurriculumParams::Type::Adaptive)
+    {
+        return std::min(m_fullLength, m_adaptiveLength.load(std::memory_order_relaxed));
+    }
+
+    double const start = std::max(0.0, std::min(1.0, m_params.startFraction));
+    double const ramp = static_cast<double>(std::max<std::size_t>(1, m_params.rampGenerations));
+    double progress = std::min(1.0, this->worldStart(ngen) / ramp);
+
+    if(m_params.type == CurriculumParams::Type::Step)
+    {
+        double const nlevels = std::max(1u, m_params.nlevels);
+        progress = std::floor(progress * nlevels) / nlevels;
+    }
+
+    double const fraction = start + (1.0 - start) * progress;
+    return std::max(1u, std::min(m_fullLength,
+        static_cast<uint32_t>(std::round(fraction * m_fullLength))
+    ));
+}
+
+CurriculumParams const & EpisodeCurriculum::getParams() const
+{
+    return m_params;
+}
+
+void EpisodeCurriculum::update(std::size_t ngen, double bestFitness)
+{
+    if(m_params.type != CurriculumParams::Type::Adaptive) return;
+
+    // Fitnesses are only comparable within the same world
+    if(ngen == this->worldStart(ngen) || bestFitness > m_plateauFitness + m_params.plateauTolerance)
+    {
+        m_plateauFitness = bestFitness;
+        m_plateauLength = 0;
+    }
+    else if(++m_plateauLength >= m_params.plateauGenerations)
+    {
+        m_growthPending = true;
+    }
+
+    // Grow when the next generation enters a new world
+    std::size_t const next = ngen + 1;
+    if(m_growthPending && next == this->worldStart(next))
+    {
+        uint32_t const length = m_adaptiveLength.load(std::memory_order_relaxed);
+        uint32_t const grown = static_cast<uint32_t>(std::ceil(length * m_params.growthFactor));
+        m_adaptiveLength.store(
+            std::min(m_fullLength, std::max(length + 1, grown)), std::memory_order_relaxed
+        );
+        m_growthPending = false;
+        m_plateauLength = 0;
+    }
+}
+
+void EpisodeCurriculum::recordEpisode(uint32_t budget, uint32_t fixedBudget, uint32_t steps)
+{
+    m_episodes.fetch_add(1, std::memory_order_relaxed);
+    m_budgetSteps.fetch_add(budget, std::memory_order_relaxed);
+    m_fixedSteps.fetch_add(fixedBudget, std::memory_order_relaxed);
+    m_simulatedSteps.fetch_add(steps, std::memory_order_relaxed);
+}
+
+CurriculumStats EpisodeCurriculum::getStats() const
+{
+    CurriculumStats stats;
+    stats.episodes = m_episodes.load(std::memory_order_relaxed);
+    stats.budgetSteps = m_budgetSteps.load(std::memory_order_relaxed);
+    stats.fixedSteps = m_fixedSteps.load(std::memory_order_relaxed);
+    stats.simulatedSteps = m_simulatedSteps.load(std::memory_order_relaxed);
+    return stats;
+}
+
+}
@@ -1,9 +1,9 @@
 #include <evolving_string.hpp>
+#include <genome_kernels.hpp>
 
 #include <algorithm>
 #include <cassert>
-#include <iterator>
-#include <random>
+#include <chrono>
 #include <string>
 
 #include <iostream>
@@ -29,10 +29,19 @@ void EvolvingStringDNA::init(Params const &)
 
 }
 
-void EvolvingStringDNA::randomize(std::size_t)
+void EvolvingStringDNA::randomize(std::size_t seed)
 {
     assert(m_subject);
-    m_subject->setGenes(EvolvingStringDNA::RandomString(m_subject->getTarget().size()));
+
+    // One stream per call: evolve() randomizes the population in parallel
+    RandomStream rng(seed);
+    auto & genes = m_subject->getGenes();
+    genes.assign(m_subject->getTarget().size(), ALPHABET[0]);
+
+    mutateBytes(
+        reinterpret_cast<uint8_t *>(&genes[0]), genes.size(), 1.0,
+        ALPHABET, sizeof(ALPHABET)/sizeof(*ALPHABET)-1, rng
+    );
 }
 
 EvolvingStringDNA::Fitness EvolvingStringDNA::computeFitness(std::size_t)
@@ -68,81 +77,90 @@ EvolvingStringDNA::Subject EvolvingStringDNA::crossover(EvolvingStringDNA const
 
     Subject child = Subject(new EvolvingString(*m_subject));
 
-    std::size_t length = m_subject->getGenes().size();
-
-    static std::random_device rd;
-    static std::default_random_engine rng(rd());
-    std::uniform_int_distribution<> dist(0, length-1);
+    this->breed(partner, *child);
 
-    uint32_t midpoint = dist(rng);
+    return child;
+}
 
-    auto const & parentAGenes = m_subject->getGenes();
-    auto const & parentBGenes = partner.getSubject()->getGenes();
-    auto & childGenes = child->getGenes();
+void EvolvingStringDNA::crossoverInto(
+    EvolvingStringDNA const & partner, EvolvingStringDNA & child
+) const
+{
+    assert(m_subject);
 
-    for(auto i = 0u; i < length; ++i)
+    // Reuse the subject and its genes buffer when nobody else refers to it
+    // (elites share theirs with the previous generation)
+    Subject & subject = child.m_subject;
+    if(!subject || subject.use_count() != 1)
     {
-        // FIXME: does not seem really good crossover function...
-        childGenes[i] = i > midpoint ? parentAGenes[i] : parentBGenes[i];
+        subject = Subject(new EvolvingString(*m_subject));
     }
 
-    return child;
+    this->breed(partner, *subject);
 }
 
-void EvolvingStringDNA::mutate(MutationRate mutationRate)
+void EvolvingStringDNA::breed(EvolvingStringDNA const & partner, EvolvingString & child) const
 {
-    static std::random_device rd;
-    static std::default_random_engine rng(rd());
-    std::uniform_real_distribution<MutationRate> random(0.0, 1.0);
+    std::size_t length = m_subject->getGenes().size();
 
-    auto & genes = m_subject->getGenes();
-    std::size_t length = genes.size();
+    auto const & parentAGenes = m_subject->getGenes();
+    auto const & parentBGenes = partner.getSubject()->getGenes();
+    auto & childGenes = child.getGenes();
 
-    for(auto i = 0u; i < length; ++i)
-    {
-        if(random(rng) < mutationRate)
-        {
-            genes[i] = RandomChar();
-        }
-    }
-}
+    assert(parentBGenes.size() == length);
+    childGenes.resize(length);
 
+    crossoverBytes(
+        reinterpret_cast<uint8_t const *>(parentAGenes.data()),
+        reinterpret_cast<uint8_t const *>(parentBGenes.data()),
+        reinterpret_cast<uint8_t *>(&childGenes[0]),
+        length, RandomStream::local()
+    );
+}
 
-char EvolvingStringDNA::RandomChar()
+void EvolvingStringDNA::mutate(MutationRate mutationRate)
 {
-    static std::random_device rd;
-    static std::default_random_engine rng(rd());
-    static std::uniform_int_distribution<> dist(0, sizeof(ALPHABET)/sizeof(*ALPHABET)-2);
+    auto & genes = m_subject->getGenes();
 
-    return ALPHABET[dist(rng)];
+    mutateBytes(
+        reinterpret_cast<uint8_t *>(&genes[0]), genes.size(), mutationRate,
+        ALPHABET, sizeof(ALPHABET)/sizeof(*ALPHABET)-1, RandomStream::local()
+    );
 }
 
-std::string EvolvingStringDNA::RandomString(std::size_t length)
+void stringEvolution(std::size_t maxPopulation, std::size_t ngenerations)
 {
-    std::string str;
-    str.reserve(length);
-    std::generate_n(std::back_inserter(str), length, [&]() { return RandomChar(); });
+    using Clock = std::chrono::steady_clock;
 
-    return str;
-}
+    auto const target = std::make_shared<std::string const>("To be or not to be");
 
-void stringEvolution()
-{
-    Population<EvolvingString> strings;
-    for(auto i = 0; i < 200; ++i)
+    std::cout << "Population, Generations, Time (s), ns/individual/generation, "
+              << "Best fitness" << std::endl;
+
+    for(std::size_t n = 1000; n <= maxPopulation; n *= 10)
     {
-        strings.push_back(createIndividual<EvolvingString>("To be or not to be"));
-    }
+        Population<EvolvingString> strings(n);
+
+        #pragma omp parallel for schedule(static)
+        for(auto i = 0u; i < n; ++i)
+        {
+            strings[i] = createIndividual<EvolvingString>(target);
+        }
 
-    EvolutionParams<EvolvingStringDNA> params;
-    params.mutationRate = 0.02;
-    params.elitism = 2;
+        EvolutionParams<EvolvingStringDNA> params;
+        params.mutationRate = 0.02;
+        params.elitism = 2;
 
-    DNAs<EvolvingStringDNA> dnas = evolve<EvolvingStringDNA>(strings, 10000, params);
+        auto const start = Clock::now();
 
-    for(auto & dna: dnas)
-    {
-        auto subject = dna.getSubject();
-        std::cout << subject->getGenes() << std::endl;
+        DNAs<EvolvingStringDNA> dnas = evolve<EvolvingStringDNA>(strings, ngenerations, params);
+
+        double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << n << ", " << ngenerations << ", " << seconds << ", "
+                  << 1e9 * seconds / (static_cast<double>(n) * std::max<std::size_t>(ngenerations, 1))
+                  << ", " << (dnas.empty() ? 0.0 : dnas.back().getFitness())
+                  << " (" << (dnas.empty() ? "" : dnas.back().getSubject()->getGenes()) << ")"
+                  << std::endl;
     }
 }
@@ -0,0 +1,112 @@
+#include <genome.hpp>
+
+#include <cassert>
+#include <cmath>
+
+namespace NeuroCar {
+
+std::size_t genomeSize(NeuroEvolution::NeuralNetwork::Shape const & shape)
+{
+    std::size_t size = 0;
+    for(auto l = 0u; l + 1 < shape.size(); ++l)
+    {
+        size += (shape[l] + 1) * shape[l+1];
+    }
+    return size;
+}
+
+void networkToGenome(NeuroEvolution::NeuralNetwork const & nn, Genome & genome)
+{
+    auto const & shape = nn.getShape();
+    genome.resize(genomeSize(shape));
+
+    std::size_t k = 0;
+    for(auto l = 0u; l + 1 < shape.size(); ++l)
+    {
+        auto I = shape[l];
+        auto J = shape[l+1];
+
+        for(auto j = 0u; j < J; ++j)
+        {
+            for(auto i = 0u; i < I; ++i)
+            {
+                genome[k++] = static_cast<float>(nn.getWeight(l, i, j));
+            }
+
+            // j because bias vectors start at layer 1
+            genome[k++] = static_cast<float>(nn.getBias(l, j));
+        }
+    }
+}
+
+void genomeToNetwork(Genome const & genome, NeuroEvolution::NeuralNetwork & nn)
+{
+    auto const & shape = nn.getShape();
+    assert(genome.size() == genomeSize(shape));
+
+    std::size_t k = 0;
+    for(auto l = 0u; l + 1 < shape.size(); ++l)
+    {
+        auto I = shape[l];
+        auto J = shape[l+1];
+
+        for(auto j = 0u; j < J; ++j)
+        {
+            for(auto i = 0u; i < I; ++i)
+            {
+                nn.setWeight(l, i, j, genome[k++]);
+            }
+
+            nn.setBias(l, j, genome[k++]);
+        }
+    }
+}
+
+void pruneGenome(
+    NeuroEvolution::NeuralNetwork::Shape const & shape, Genome & genome,
+    double rate, RandomStream & rng
+)
+{
+    assert(genome.size() == genomeSize(shape));
+
+    std::size_t k = 0;
+    for(auto l = 0u; l + 1 < shape.size(); ++l)
+    {
+        auto I = shape[l];
+        auto J = shape[l+1];
+
+        for(auto j = 0u; j < J; ++j)
+        {
+            pruneGenes(&genome[k], I, rate, rng);
+            k += I + 1;
+        }
+    }
+}
+
+double genomeSparsity(NeuroEvolution::NeuralNetwork::Shape const & shape, Genome const & genome)
+{
+    assert(genome.size() == genomeSize(shape));
+
+    std::size_t zeros = 0;
+    std::size_t weights = 0;
+    std::size_t k = 0;
+    for(auto l = 0u; l + 1 < shape.size(); ++l)
+    {
+        auto I = shape[l];
+        auto J = shape[l+1];
+
+        for(auto j = 0u; j < J; ++j)
+        {
+            for(auto i = 0u; i < I; ++i)
+            {
+                if(std::fpclassify(genome[k + i]) == FP_ZERO) ++zeros;
+            }
+            weights += I;
+            k += I + 1;
+        }
+    }
+
+    return weights > 0 ? static_cast<double>(zeros) / weights : 0.0;
+}
+
+}
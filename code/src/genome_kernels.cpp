@@ -0,0 +1,568 @@
+#include <genome_kernels.hpp>
+#include <cpu_dispatch.hpp>
+
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if NEURO_CAR_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Per-thread buffers of random numbers, reused between calls
+thread_local std::vector<uint32_t> lotteryBuffer;
+thread_local std::vector<uint32_t> valueBuffer;
+thread_local std::vector<uint8_t> maskBuffer;
+
+uint32_t * randoms(std::vector<uint32_t> & buffer, std::size_t n, RandomStream & rng)
+{
+    if(buffer.size() < n) buffer.resize(n);
+    rng.fill(buffer.data(), n);
+    return buffer.data();
+}
+
+uint64_t splitmix64(uint64_t & state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// r < threshold(rate) happens with probability rate
+uint32_t threshold(double rate)
+{
+    if(rate <= 0.0) return 0u;
+    if(rate >= 1.0) return 0xFFFFFFFFu;
+    return static_cast<uint32_t>(rate * 4294967296.0);
+}
+
+// Uniform float in [-1, 1[ from 24 random bits
+inline float toSignedUnit(uint32_t r)
+{
+    return static_cast<float>(r >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+}
+
+RandomStream::RandomStream(uint64_t seed)
+{
+    for(auto l = 0u; l < Lanes; ++l)
+    {
+        uint64_t const a = splitmix64(seed);
+        uint64_t const b = splitmix64(seed);
+        m_x[l] = static_cast<uint32_t>(a);
+        m_y[l] = static_cast<uint32_t>(a >> 32);
+        m_z[l] = static_cast<uint32_t>(b);
+        m_w[l] = static_cast<uint32_t>(b >> 32) | 1u; // Never all zeros
+    }
+}
+
+void RandomStream::fill(uint32_t * out, std::size_t n)
+{
+    std::size_t i = 0;
+
+    #ifdef __SSE2__
+    __m128i x = _mm_load_si128(reinterpret_cast<__m128i const *>(m_x));
+    __m128i y = _mm_load_si128(reinterpret_cast<__m128i const *>(m_y));
+    __m128i z = _mm_load_si128(reinterpret_cast<__m128i const *>(m_z));
+    __m128i w = _mm_load_si128(reinterpret_cast<__m128i const *>(m_w));
+
+    for(; i + Lanes <= n; i += Lanes)
+    {
+        __m128i t = _mm_xor_si128(x, _mm_slli_epi32(x, 11));
+        t = _mm_xor_si128(t, _mm_srli_epi32(t, 8));
+        x = y;
+        y = z;
+        z = w;
+        w = _mm_xor_si128(_mm_xor_si128(w, _mm_srli_epi32(w, 19)), t);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), w);
+    }
+
+    _mm_store_si128(reinterpret_cast<__m128i *>(m_x), x);
+    _mm_store_si128(reinterpret_cast<__m128i *>(m_y), y);
+    _mm_store_si128(reinterpret_cast<__m128i *>(m_z), z);
+    _mm_store_si128(reinterpret_cast<__m128i *>(m_w), w);
+    #endif
+
+    // Scalar version of the same generators
+    for(; i < n; i += Lanes)
+    {
+        for(auto l = 0u; l < Lanes; ++l)
+        {
+            uint32_t t = m_x[l] ^ (m_x[l] << 11);
+            t ^= t >> 8;
+            m_x[l] = m_y[l];
+            m_y[l] = m_z[l];
+            m_z[l] = m_w[l];
+            m_w[l] = m_w[l] ^ (m_w[l] >> 19) ^ t;
+            if(i + l < n) out[i + l] = m_w[l];
+        }
+    }
+}
+
+RandomStream & RandomStream::local()
+{
+    static std::random_device rd;
+    thread_local RandomStream stream(
+        (static_cast<uint64_t>(rd()) << 32) ^ rd() ^
+        std::hash<std::thread::id>()(std::this_thread::get_id())
+    );
+    return stream;
+}
+
+// Kernel variants. The generic ones also finish the tails of the wider ones,
+// and all of them produce the same results from the same random numbers.
+namespace {
+
+inline uint8_t pickSymbol(uint32_t value, char const * alphabet, std::size_t alphabetSize)
+{
+    uint64_t const index = (static_cast<uint64_t>(value) * alphabetSize) >> 32;
+    return static_cast<uint8_t>(alphabet[index]);
+}
+
+void crossoverGenesGeneric(
+    float const * a, float const * b, float * child, uint32_t const * r, std::size_t n
+)
+{
+    std::size_t i = 0;
+
+    #ifdef __SSE2__
+    for(; i + 4 <= n; i += 4)
+    {
+        // Sign bit of the random number selects the parent
+        __m128i const ri = _mm_loadu_si128(reinterpret_cast<__m128i const *>(r + i));
+        __m128 const mask = _mm_castsi128_ps(_mm_srai_epi32(ri, 31));
+        __m128 const va = _mm_loadu_ps(a + i);
+        __m128 const vb = _mm_loadu_ps(b + i);
+        _mm_storeu_ps(child + i,
+            _mm_or_ps(_mm_and_ps(mask, va), _mm_andnot_ps(mask, vb))
+        );
+    }
+    #endif
+
+    for(; i < n; ++i)
+    {
+        child[i] = (r[i] >> 31) ? a[i] : b[i];
+    }
+}
+
+void mutateGenesGeneric(
+    float * genes, uint32_t const * lottery, uint32_t const * values, std::size_t n,
+    uint32_t t, float amplitude
+)
+{
+    std::size_t i = 0;
+
+    #ifdef __SSE2__
+    // SSE2 only has signed comparisons: flip the sign bits
+    __m128i const bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    __m128i const vt = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(t)), bias);
+    __m128 const scale = _mm_set1_ps(2.0f / 16777216.0f);
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const amp = _mm_set1_ps(amplitude);
+
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128i const l = _mm_loadu_si128(reinterpret_cast<__m128i const *>(lottery + i));
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const *>(values + i));
+        __m128 const mask = _mm_castsi128_ps(
+            _mm_cmpgt_epi32(vt, _mm_xor_si128(l, bias))
+        );
+
+        __m128 delta = _mm_cvtepi32_ps(_mm_srli_epi32(v, 8));
+        delta = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(delta, scale), one), amp);
+
+        __m128 const g = _mm_loadu_ps(genes + i);
+        _mm_storeu_ps(genes + i, _mm_add_ps(g, _mm_and_ps(mask, delta)));
+    }
+    #endif
+
+    for(; i < n; ++i)
+    {
+        if(lottery[i] < t) genes[i] += toSignedUnit(values[i]) * amplitude;
+    }
+}
+
+void pruneGenesGeneric(float * genes, uint32_t const * lottery, std::size_t n, uint32_t t)
+{
+    for(std::size_t i = 0; i < n; ++i)
+    {
+        if(lottery[i] < t) genes[i] = 0.0f;
+    }
+}
+
+void crossoverBytesGeneric(
+    uint8_t const * a, uint8_t const * b, uint8_t * child, uint8_t const * r, std::size_t n
+)
+{
+    std::size_t i = 0;
+
+    #ifdef __SSE2__
+    __m128i const zero = _mm_setzero_si128();
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i const ri = _mm_loadu_si128(reinterpret_cast<__m128i const *>(r + i));
+        __m128i const mask = _mm_cmplt_epi8(ri, zero);
+        __m128i const va = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a + i));
+        __m128i const vb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(child + i),
+            _mm_or_si128(_mm_and_si128(mask, va), _mm_andnot_si128(mask, vb))
+        );
+    }
+    #endif
+
+    for(; i < n; ++i)
+    {
+        child[i] = (r[i] & 0x80u) ? a[i] : b[i];
+    }
+}
+
+void mutateBytesGeneric(
+    uint8_t * genes, uint32_t const * lottery, uint32_t const * values, std::size_t n,
+    uint32_t t, char const * alphabet, std::size_t alphabetSize
+)
+{
+    if(maskBuffer.size() < n + 16) maskBuffer.resize(n + 16);
+    uint8_t * mask = maskBuffer.data();
+
+    std::size_t i = 0;
+
+    #ifdef __SSE2__
+    __m128i const bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    __m128i const vt = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(t)), bias);
+
+    // 16 comparisons, packed into one byte mask per gene
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i m[4];
+        for(auto k = 0u; k < 4; ++k)
+        {
+            __m128i const l = _mm_loadu_si128(
+                reinterpret_cast<__m128i const *>(lottery + i + 4 * k)
+            );
+            m[k] = _mm_cmpgt_epi32(vt, _mm_xor_si128(l, bias));
+        }
+        __m128i const m16a = _mm_packs_epi32(m[0], m[1]);
+        __m128i const m16b = _mm_packs_epi32(m[2], m[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i),
+            _mm_packs_epi16(m16a, m16b)
+        );
+    }
+    #endif
+
+    for(; i < n; ++i)
+    {
+        mask[i] = lottery[i] < t ? 0xFFu : 0u;
+    }
+
+    // Mutations are rare: the replacement symbols are picked sparsely
+    for(i = 0; i < n; ++i)
+    {
+        if(mask[i]) genes[i] = pickSymbol(values[i], alphabet, alphabetSize);
+    }
+}
+
+#if NEURO_CAR_DISPATCH
+
+NEURO_CAR_TARGET_AVX2
+void crossoverGenesAvx2(
+    float const * a, float const * b, float * child, uint32_t const * r, std::size_t n
+)
+{
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        // blendv selects on the sign bit of each lane
+        __m256 const mask = _mm256_castsi256_ps(
+            _mm256_loadu_si256(reinterpret_cast<__m256i const *>(r + i))
+        );
+        _mm256_storeu_ps(child + i,
+            _mm256_blendv_ps(_mm256_loadu_ps(b + i), _mm256_loadu_ps(a + i), mask)
+        );
+    }
+    crossoverGenesGeneric(a + i, b + i, child + i, r + i, n - i);
+}
+
+NEURO_CAR_TARGET_AVX2
+void mutateGenesAvx2(
+    float * genes, uint32_t const * lottery, uint32_t const * values, std::size_t n,
+    uint32_t t, float amplitude
+)
+{
+    __m256i const bias = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    __m256i const vt = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(t)), bias);
+    __m256 const scale = _mm256_set1_ps(2.0f / 16777216.0f);
+    __m256 const one = _mm256_set1_ps(1.0f);
+    __m256 const amp = _mm256_set1_ps(amplitude);
+
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i const l = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(lottery + i));
+        __m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(values + i));
+        __m256 const mask = _mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(vt, _mm256_xor_si256(l, bias))
+        );
+
+        __m256 delta = _mm256_cvtepi32_ps(_mm256_srli_epi32(v, 8));
+        delta = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(delta, scale), one), amp);
+
+        __m256 const g = _mm256_loadu_ps(genes + i);
+        _mm256_storeu_ps(genes + i, _mm256_add_ps(g, _mm256_and_ps(mask, delta)));
+    }
+    mutateGenesGeneric(genes + i, lottery + i, values + i, n - i, t, amplitude);
+}
+
+NEURO_CAR_TARGET_AVX2
+void pruneGenesAvx2(float * genes, uint32_t const * lottery, std::size_t n, uint32_t t)
+{
+    __m256i const bias = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    __m256i const vt = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(t)), bias);
+
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i const l = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(lottery + i));
+        __m256 const mask = _mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(vt, _mm256_xor_si256(l, bias))
+        );
+        _mm256_storeu_ps(genes + i, _mm256_andnot_ps(mask, _mm256_loadu_ps(genes + i)));
+    }
+    pruneGenesGeneric(genes + i, lottery + i, n - i, t);
+}
+
+NEURO_CAR_TARGET_AVX2
+void crossoverBytesAvx2(
+    uint8_t const * a, uint8_t const * b, uint8_t * child, uint8_t const * r, std::size_t n
+)
+{
+    std::size_t i = 0;
+    for(; i + 32 <= n; i += 32)
+    {
+        __m256i const ri = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(r + i));
+        __m256i const va = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+        __m256i const vb = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(child + i),
+            _mm256_blendv_epi8(vb, va, ri)
+        );
+    }
+    crossoverBytesGeneric(a + i, b + i, child + i, r + i, n - i);
+}
+
+NEURO_CAR_TARGET_AVX2
+void mutateBytesAvx2(
+    uint8_t * genes, uint32_t const * lottery, uint32_t const * values, std::size_t n,
+    uint32_t t, char const * alphabet, std::size_t alphabetSize
+)
+{
+    __m256i const bias = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    __m256i const vt = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(t)), bias);
+
+    // One bit per gene: only the mutated genes are visited, without mask buffer
+    std::size_t i = 0;
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256i const l = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(lottery + i));
+        unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(vt, _mm256_xor_si256(l, bias))
+        )));
+        for(; bits; bits &= bits - 1)
+        {
+            std::size_t const k = i + static_cast<unsigned>(__builtin_ctz(bits));
+            genes[k] = pickSymbol(values[k], alphabet, alphabetSize);
+        }
+    }
+    mutateBytesGeneric(genes + i, lottery + i, values + i, n - i, t, alphabet, alphabetSize);
+}
+
+NEURO_CAR_TARGET_AVX512
+void crossoverGenesAvx512(
+    float const * a, float const * b, float * child, uint32_t const * r, std::size_t n
+)
+{
+    __m512i const zero = _mm512_setzero_si512();
+
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        __mmask16 const mask = _mm512_cmplt_epi32_mask(_mm512_loadu_si512(r + i), zero);
+        _mm512_storeu_ps(child + i,
+            _mm512_mask_blend_ps(mask, _mm512_loadu_ps(b + i), _mm512_loadu_ps(a + i))
+        );
+    }
+    crossoverGenesGeneric(a + i, b + i, child + i, r + i, n - i);
+}
+
+NEURO_CAR_TARGET_AVX512
+void mutateGenesAvx512(
+    float * genes, uint32_t const * lottery, uint32_t const * values, std::size_t n,
+    uint32_t t, float amplitude
+)
+{
+    __m512i const vt = _mm512_set1_epi32(static_cast<int>(t));
+    __m512 const scale = _mm512_set1_ps(2.0f / 16777216.0f);
+    __m512 const one = _mm512_set1_ps(1.0f);
+    __m512 const amp = _mm512_set1_ps(amplitude);
+    __mmask16 const all = 0xFFFF;
+
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        __mmask16 const mask = _mm512_cmplt_epu32_mask(_mm512_loadu_si512(lottery + i), vt);
+
+        // Zero-masked forms: the plain ones trip -Wmaybe-uninitialized in GCC 12
+        __m512i const v = _mm512_maskz_srli_epi32(all, _mm512_loadu_si512(values + i), 8);
+        __m512 delta = _mm512_maskz_cvtepi32_ps(all, v);
+        delta = _mm512_mul_ps(_mm512_sub_ps(_mm512_mul_ps(delta, scale), one), amp);
+
+        __m512 const g = _mm512_loadu_ps(genes + i);
+        _mm512_storeu_ps(genes + i, _mm512_add_ps(g, _mm512_maskz_mov_ps(mask, delta)));
+    }
+    mutateGenesGeneric(genes + i, lottery + i, values + i, n - i, t, amplitude);
+}
+
+NEURO_CAR_TARGET_AVX512
+void pruneGenesAvx512(float * genes, uint32_t const * lottery, std::size_t n, uint32_t t)
+{
+    __m512i const vt = _mm512_set1_epi32(static_cast<int>(t));
+
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        __mmask16 const mask = _mm512_cmplt_epu32_mask(_mm512_loadu_si512(lottery + i), vt);
+        _mm512_mask_storeu_ps(genes + i, mask, _mm512_setzero_ps());
+    }
+    pruneGenesGeneric(genes + i, lottery + i, n - i, t);
+}
+
+NEURO_CAR_TARGET_AVX512
+void crossoverBytesAvx512(
+    uint8_t const * a, uint8_t const * b, uint8_t * child, uint8_t const * r, std::size_t n
+)
+{
+    std::size_t i = 0;
+    for(; i + 64 <= n; i += 64)
+    {
+        __mmask64 const mask = _mm512_movepi8_mask(_mm512_loadu_si512(r + i));
+        _mm512_storeu_si512(child + i,
+            _mm512_mask_blend_epi8(mask, _mm512_loadu_si512(b + i), _mm512_loadu_si512(a + i))
+        );
+    }
+    crossoverBytesGeneric(a + i, b + i, child + i, r + i, n - i);
+}
+
+NEURO_CAR_TARGET_AVX512
+void mutateBytesAvx512(
+    uint8_t * genes, uint32_t const * lottery, uint32_t const * values, std::size_t n,
+    uint32_t t, char const * alphabet, std::size_t alphabetSize
+)
+{
+    __m512i const vt = _mm512_set1_epi32(static_cast<int>(t));
+
+    std::size_t i = 0;
+    for(; i + 16 <= n; i += 16)
+    {
+        unsigned bits = _mm512_cmplt_epu32_mask(_mm512_loadu_si512(lottery + i), vt);
+        for(; bits; bits &= bits - 1)
+        {
+            std::size_t const k = i + static_cast<unsigned>(__builtin_ctz(bits));
+            genes[k] = pickSymbol(values[k], alphabet, alphabetSize);
+        }
+    }
+    mutateBytesGeneric(genes + i, lottery + i, values + i, n - i, t, alphabet, alphabetSize);
+}
+
+#endif
+
+}
+
+void crossoverGenes(
+    float const * a, float const * b, float * child, std::size_t n,
+    RandomStream & rng
+)
+{
+    static auto const kernel = NEURO_CAR_SELECT_KERNEL(crossoverGenes);
+
+    uint32_t const * r = randoms(lotteryBuffer, n, rng);
+    kernel(a, b, child, r, n);
+}
+
+void mutateGenes(
+    float * genes, std::size_t n, double rate, float amplitude,
+    RandomStream & rng
+)
+{
+    static auto const kernel = NEURO_CAR_SELECT_KERNEL(mutateGenes);
+
+    uint32_t const t = threshold(rate);
+    if(t == 0u) return;
+
+    uint32_t const * lottery = randoms(lotteryBuffer, n, rng);
+    uint32_t const * values  = randoms(valueBuffer, n, rng);
+    kernel(genes, lottery, values, n, t, amplitude);
+}
+
+void pruneGenes(float * genes, std::size_t n, double rate, RandomStream & rng)
+{
+    static auto const kernel = NEURO_CAR_SELECT_KERNEL(pruneGenes);
+
+    uint32_t const t = threshold(rate);
+    if(t == 0u) return;
+
+    uint32_t const * lottery = randoms(lotteryBuffer, n, rng);
+    kernel(genes, lottery, n, t);
+}
+
+void crossoverBytes(
+    uint8_t const * a, uint8_t const * b, uint8_t * child, std::size_t n,
+    RandomStream & rng
+)
+{
+    static auto const kernel = NEURO_CAR_SELECT_KERNEL(crossoverBytes);
+
+    // One random bit per byte is enough: draw the bytes in bulk
+    std::size_t const nwords = (n + 3) / 4;
+    uint32_t const * words = randoms(lotteryBuffer, nwords, rng);
+    kernel(a, b, child, reinterpret_cast<uint8_t const *>(words), n);
+}
+
+void mutateBytes(
+    uint8_t * genes, std::size_t n, double rate,
+    char const * alphabet, std::size_t alphabetSize,
+    RandomStream & rng
+)
+{
+    static auto const kernel = NEURO_CAR_SELECT_KERNEL(mutateBytes);
+
+    uint32_t const t = threshold(rate);
+    if(t == 0u || alphabetSize == 0) return;
+
+    uint32_t const * lottery = randoms(lotteryBuffer, n, rng);
+    uint32_t const * values  = randoms(valueBuffer, n, rng);
+    kernel(genes, lottery, values, n, t, alphabet, alphabetSize);
+}
+
+void gaussianNoise(float * out, std::size_t n, RandomStream & rng)
+{
+    // Box-Muller: one pair of uniforms per pair of normal values
+    std::size_t const npairs = (n + 1) / 2;
+    uint32_t const * r = randoms(lotteryBuffer, 2 * npairs, rng);
+
+    for(auto p = 0u; p < npairs; ++p)
+    {
+        double const u1 = (r[2 * p] + 1.0) / 4294967296.0; // ]0, 1]
+        double const angle = r[2 * p + 1] * (2.0 * M_PI / 4294967296.0);
+        double const radius = std::sqrt(-2.0 * std::log(u1));
+
+        out[2 * p] = static_cast<float>(radius * std::cos(angle));
+        if(2 * p + 1 < n) out[2 * p + 1] = static_cast<float>(radius * std::sin(angle));
+    }
+}
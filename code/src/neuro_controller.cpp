@@ -1,15 +1,67 @@
 #include <neuro_controller.hpp>
 #include <functions.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
 #include <iostream>
 
 namespace NeuroCar {
 
+namespace {
+
+// Output bits of the network, in the order of its outputs
+uint32_t toCarFlags(uint32_t outputBits)
+{
+    uint32_t flags = 0;
+
+    if(outputBits & (1u << 0)) flags |= Car::RIGHT;
+    if(outputBits & (1u << 1)) flags |= Car::LEFT;
+    if(outputBits & (1u << 2)) flags |= Car::FORWARD;
+    if(outputBits & (1u << 3)) flags |= Car::BACKWARD;
+
+    return flags;
+}
+
+// Flags of the outputs of the float networks
+uint32_t thresholdFlags(std::vector<NeuroEvolution::Weight> const & outputs)
+{
+    uint32_t flags = 0;
+
+    float threshold = 0.5;
+
+    if(outputs[0] > threshold) flags |= Car::RIGHT;
+    if(outputs[1] > threshold) flags |= Car::LEFT;
+    if(outputs[2] > threshold) flags |= Car::FORWARD;
+    if(outputs[3] > threshold) flags |= Car::BACKWARD;
+
+    return flags;
+}
+
+}
+
 NeuroController::NeuroController():
     Controller(),
-    m_neuralNetwork()
+    m_neuralNetwork(),
+    m_quantizedNetwork(nullptr),
+    m_sparseNetwork(),
+    m_inference(Inference::Float),
+    m_compareFlags(false),
+    m_comparedSteps(0),
+    m_flagDisagreements(0),
+    m_inputLog(nullptr),
+    m_recorder(nullptr),
+    m_positionLog(nullptr),
+    m_positionInterval(0),
+    m_stepLimit(0),
+    m_stepCount(0),
+    m_controlPeriod(1),
+    m_decisionCount(0),
+    m_heldFlags(0),
+    m_flagChanges(0),
+    m_pathLength(0.0f),
+    m_lastPos(0.0f, 0.0f)
 {
     //Shape
     NeuralNetwork::Shape shape;
@@ -25,7 +77,25 @@ NeuroController::NeuroController():
 
 NeuroController::NeuroController(NeuralNetwork const & nn):
     Controller(),
-    m_neuralNetwork(nn)
+    m_neuralNetwork(nn),
+    m_quantizedNetwork(nullptr),
+    m_sparseNetwork(),
+    m_inference(Inference::Float),
+    m_compareFlags(false),
+    m_comparedSteps(0),
+    m_flagDisagreements(0),
+    m_inputLog(nullptr),
+    m_recorder(nullptr),
+    m_positionLog(nullptr),
+    m_positionInterval(0),
+    m_stepLimit(0),
+    m_stepCount(0),
+    m_controlPeriod(1),
+    m_decisionCount(0),
+    m_heldFlags(0),
+    m_flagChanges(0),
+    m_pathLength(0.0f),
+    m_lastPos(0.0f, 0.0f)
 {
 
 }
@@ -55,11 +125,148 @@ void NeuroController::setDestination(b2Vec2 destination)
     m_destination = destination;
 }
 
+void NeuroController::setStepLimit(uint32_t limit)
+{
+    m_stepLimit = limit;
+}
+
+uint32_t NeuroController::getStepCount() const
+{
+    return m_stepCount;
+}
+
+void NeuroController::resetStepCount()
+{
+    m_stepCount = 0;
+    m_decisionCount = 0;
+    m_heldFlags = 0;
+    m_flagChanges = 0;
+    m_pathLength = 0.0f;
+}
+
+void NeuroController::setControlPeriod(uint32_t period)
+{
+    m_controlPeriod = std::max(1u, period);
+}
+
+uint32_t NeuroController::getControlPeriod() const
+{
+    return m_controlPeriod;
+}
+
+uint32_t NeuroController::getDecisionCount() const
+{
+    return m_decisionCount;
+}
+
+float NeuroController::getPathLength() const
+{
+    return m_pathLength;
+}
+
+uint32_t NeuroController::getFlagChanges() const
+{
+    return m_flagChanges;
+}
+
+void NeuroController::setQuantizedNetwork(std::shared_ptr<QuantizedNetwork const> qnn)
+{
+    m_quantizedNetwork = qnn;
+}
+
+void NeuroController::setInference(Inference inference)
+{
+    assert(inference != Inference::Quantized || m_quantizedNetwork);
+    m_inference = inference;
+}
+
+NeuroController::Inference NeuroController::getInference() const
+{
+    return m_inference;
+}
+
+void NeuroController::compactNetwork(Genome const & genome)
+{
+    m_sparseNetwork.compact(m_neuralNetwork.getShape(), genome);
+}
+
+SparseNetwork const & NeuroController::getSparseNetwork() const
+{
+    return m_sparseNetwork;
+}
+
+void NeuroController::setCompareFlags(bool compare)
+{
+    assert(!compare || m_quantizedNetwork);
+    m_compareFlags = compare;
+    m_comparedSteps = 0;
+    m_flagDisagreements = 0;
+}
+
+uint32_t NeuroController::getComparedSteps() const
+{
+    return m_comparedSteps;
+}
+
+uint32_t NeuroController::getFlagDisagreements() const
+{
+    return m_flagDisagreements;
+}
+
+void NeuroController::setInputLog(std::vector<NeuroEvolution::Weight> * log)
+{
+    m_inputLog = log;
+}
+
+void NeuroController::setRecorder(TrajectoryRecorder * recorder)
+{
+    m_recorder = recorder;
+}
+
+void NeuroController::setPositionLog(std::vector<float> * log, uint32_t interval)
+{
+    m_positionLog = interval > 0 ? log : nullptr;
+    m_positionInterval = interval;
+}
+
 uint32_t NeuroController::updateFlags(Car * c) const
 {
     using Weights = std::vector<NeuroEvolution::Weight>;
 
-    Weights inputs;
+    // Budget exhausted: end the episode the same way a collision does
+    if(m_stepLimit > 0 && m_stepCount >= m_stepLimit)
+    {
+        c->kill();
+        return 0;
+    }
+
+    b2Vec2 const pos = c->getPos();
+    if(m_stepCount > 0)
+    {
+        float const dx = pos.x - m_lastPos.x;
+        float const dy = pos.y - m_lastPos.y;
+        m_pathLength += std::sqrt(dx * dx + dy * dy);
+    }
+    m_lastPos = pos;
+
+    if(m_positionLog && m_stepCount > 0 && m_stepCount % m_positionInterval == 0)
+    {
+        m_positionLog->push_back(pos.x);
+        m_positionLog->push_back(pos.y);
+    }
+
+    // Hold the last decision between two control steps
+    if(m_controlPeriod > 1 && m_stepCount % m_controlPeriod != 0)
+    {
+        ++m_stepCount;
+        return m_heldFlags;
+    }
+
+    ++m_stepCount;
+    ++m_decisionCount;
+
+    Weights & inputs = m_inputs;
+    inputs.clear();
 
     // Adding raycast results as input
     for(auto d : c->getCollisionDists())
@@ -107,19 +314,76 @@ uint32_t NeuroController::updateFlags(Car * c) const
 
     inputs.push_back(dist);*/
 
-    // Compute next decision
-    Weights outputs = m_neuralNetwork.compute(inputs);
+    if(m_inputLog)
+    {
+        m_inputLog->insert(m_inputLog->end(), inputs.begin(), inputs.end());
+    }
 
-    uint32_t flags = 0;
+    // Compute next decision
+    uint32_t const flags = this->decide();
 
-    float threshold = 0.5;
+    if(m_recorder)
+    {
+        // Quantized inference leaves no float outputs to record
+        m_recorder->record(
+            carPos, c->getAngle(), inputs.data(), inputs.size(),
+            m_outputs.data(), m_outputs.size(), flags
+        );
+    }
 
-    if(outputs[0] > threshold) flags |= Car::RIGHT;
-    if(outputs[1] > threshold) flags |= Car::LEFT;
-    if(outputs[2] > threshold) flags |= Car::FORWARD;
-    if(outputs[3] > threshold) flags |= Car::BACKWARD;
+    if(m_decisionCount > 1 && flags != m_heldFlags) ++m_flagChanges;
+    m_heldFlags = flags;
 
     return flags;
 }
 
+uint32_t NeuroController::decide() const
+{
+    using Weights = std::vector<NeuroEvolution::Weight>;
+
+    if(m_inference == Inference::Float && !m_compareFlags)
+    {
+        return this->computeFloatFlags();
+    }
+
+    if(m_inference == Inference::Sparse)
+    {
+        return this->computeSparseFlags();
+    }
+
+    m_outputs.clear();
+
+    Weights const & inputs = m_inputs;
+
+    uint32_t const quantizedFlags = toCarFlags(
+        m_quantizedNetwork->computeFlags(inputs.data())
+    );
+
+    if(m_compareFlags)
+    {
+        uint32_t const floatFlags = this->computeFloatFlags();
+        ++m_comparedSteps;
+        if(floatFlags != quantizedFlags) ++m_flagDisagreements;
+
+        if(m_inference == Inference::Float) return floatFlags;
+    }
+
+    return quantizedFlags;
+}
+
+uint32_t NeuroController::computeFloatFlags() const
+{
+    m_outputs = m_neuralNetwork.compute(m_inputs);
+
+    return thresholdFlags(m_outputs);
+}
+
+uint32_t NeuroController::computeSparseFlags() const
+{
+    m_outputs.resize(m_sparseNetwork.getShape().back());
+    m_sparseNetwork.compute(m_inputs.data(), m_outputs.data());
+
+    return thresholdFlags(m_outputs);
+}
+
 }
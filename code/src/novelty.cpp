@@ -0,0 +1,295 @@
+#include <novelty.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+// Ranges of at most Leaf points are scanned linearly
+std::size_t const Leaf = 8;
+
+// Behaviors inserted in the archive between two merges
+std::size_t const BufferRows = 64;
+
+uint32_t const NoId = std::numeric_limits<uint32_t>::max();
+
+}
+
+NearestDistances::NearestDistances():
+    m_k(0),
+    m_heap()
+{
+
+}
+
+void NearestDistances::reset(std::size_t k)
+{
+    m_k = k;
+    m_heap.clear();
+    m_heap.reserve(k);
+}
+
+void NearestDistances::offer(float distance2)
+{
+    if(m_heap.size() < m_k)
+    {
+        m_heap.push_back(distance2);
+        std::push_heap(m_heap.begin(), m_heap.end());
+    }
+    else if(m_k > 0 && distance2 < m_heap.front())
+    {
+        std::pop_heap(m_heap.begin(), m_heap.end());
+        m_heap.back() = distance2;
+        std::push_heap(m_heap.begin(), m_heap.end());
+    }
+}
+
+float NearestDistances::bound() const
+{
+    return m_heap.size() < m_k ? std::numeric_limits<float>::infinity() : m_heap.front();
+}
+
+double NearestDistances::meanDistance() const
+{
+    if(m_heap.empty()) return 0.0;
+
+    double sum = 0.0;
+    for(auto d : m_heap) sum += std::sqrt(static_cast<double>(d));
+    return sum / static_cast<double>(m_heap.size());
+}
+
+std::size_t NearestDistances::size() const
+{
+    return m_heap.size();
+}
+
+KdTree::KdTree():
+    m_dimension(0),
+    m_points(),
+    m_ids(),
+    m_axes()
+{
+
+}
+
+void KdTree::build(
+    std::vector<float> points, std::vector<uint32_t> ids, std::size_t dimension
+)
+{
+    assert(dimension > 0 && points.size() == ids.size() * dimension);
+
+    std::size_t const n = ids.size();
+    m_dimension = dimension;
+    m_points = std::move(points);
+    m_ids = std::move(ids);
+    m_axes.assign(n, 0);
+
+    std::vector<uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    this->split(0, n, order);
+
+    // Store the rows in tree order, for the locality of the searches
+    std::vector<float> sortedPoints(n * m_dimension);
+    std::vector<uint32_t> sortedIds(n);
+    for(auto r = 0u; r < n; ++r)
+    {
+        std::copy(
+            m_points.begin() + order[r] * m_dimension,
+            m_points.begin() + (order[r] + 1) * m_dimension,
+            sortedPoints.begin() + r * m_dimension
+        );
+        sortedIds[r] = m_ids[order[r]];
+    }
+    m_points.swap(sortedPoints);
+    m_ids.swap(sortedIds);
+}
+
+void KdTree::clear()
+{
+    m_points.clear();
+    m_ids.clear();
+    m_axes.clear();
+}
+
+void KdTree::split(std::size_t first, std::size_t last, std::vector<uint32_t> & order)
+{
+    if(last - first <= Leaf) return;
+
+    // Split on the widest coordinate of the range
+    uint8_t axis = 0;
+    float widest = -1.0f;
+    for(std::size_t a = 0; a < m_dimension && a <= 255; ++a)
+    {
+        float low = std::numeric_limits<float>::infinity();
+        float high = -low;
+        for(auto r = first; r < last; ++r)
+        {
+            float const x = m_points[order[r] * m_dimension + a];
+            low = std::min(low, x);
+            high = std::max(high, x);
+        }
+        if(high - low > widest)
+        {
+            widest = high - low;
+            axis = static_cast<uint8_t>(a);
+        }
+    }
+
+    std::size_t const mid = first + (last - first) / 2;
+    std::nth_element(
+        order.begin() + first, order.begin() + mid, order.begin() + last,
+        [this, axis](uint32_t lhs, uint32_t rhs)
+        {
+            return m_points[lhs * m_dimension + axis] < m_points[rhs * m_dimension + axis];
+        }
+    );
+    m_axes[mid] = axis;
+
+    this->split(first, mid, order);
+    this->split(mid + 1, last, order);
+}
+
+void KdTree::nearest(float const * point, NearestDistances & nearest, uint32_t exclude) const
+{
+    this->search(0, m_ids.size(), point, nearest, exclude);
+}
+
+void KdTree::search(
+    std::size_t first, std::size_t last,
+    float const * point, NearestDistances & nearest, uint32_t exclude
+) const
+{
+    if(last - first <= Leaf)
+    {
+        for(auto r = first; r < last; ++r)
+        {
+            if(m_ids[r] != exclude) nearest.offer(this->distance2(r, point));
+        }
+        return;
+    }
+
+    std::size_t const mid = first + (last - first) / 2;
+    if(m_ids[mid] != exclude) nearest.offer(this->distance2(mid, point));
+
+    // Nearest side first, the other one only if it may hold closer points
+    float const diff = point[m_axes[mid]] - m_points[mid * m_dimension + m_axes[mid]];
+    if(diff < 0.0f)
+    {
+        this->search(first, mid, point, nearest, exclude);
+        if(diff * diff < nearest.bound()) this->search(mid + 1, last, point, nearest, exclude);
+    }
+    else
+    {
+        this->search(mid + 1, last, point, nearest, exclude);
+        if(diff * diff < nearest.bound()) this->search(first, mid, point, nearest, exclude);
+    }
+}
+
+float KdTree::distance2(std::size_t row, float const * point) const
+{
+    float const * p = &m_points[row * m_dimension];
+    float d = 0.0f;
+    for(auto i = 0u; i < m_dimension; ++i)
+    {
+        float const diff = p[i] - point[i];
+        d += diff * diff;
+    }
+    return d;
+}
+
+std::size_t KdTree::size() const
+{
+    return m_ids.size();
+}
+
+std::vector<float> const & KdTree::getPoints() const
+{
+    return m_points;
+}
+
+NoveltyArchive::NoveltyArchive():
+    m_dimension(0),
+    m_count(0),
+    m_buffer(),
+    m_levels()
+{
+
+}
+
+void NoveltyArchive::clear()
+{
+    m_dimension = 0;
+    m_count = 0;
+    m_buffer.clear();
+    m_levels.clear();
+}
+
+void NoveltyArchive::add(float const * behavior, std::size_t size)
+{
+    if(size == 0) return;
+    if(m_dimension == 0) m_dimension = size;
+    if(size != m_dimension) return;
+
+    m_buffer.insert(m_buffer.end(), behavior, behavior + size);
+    ++m_count;
+
+    if(m_buffer.size() == BufferRows * m_dimension) this->flush();
+}
+
+void NoveltyArchive::flush()
+{
+    // Carry the buffer up to the first empty level, merging the full ones
+    std::vector<float> carry;
+    carry.swap(m_buffer);
+
+    for(auto l = 0u; ; ++l)
+    {
+        if(l == m_levels.size()) m_levels.emplace_back();
+
+        KdTree & level = m_levels[l];
+        if(level.size() == 0)
+        {
+            std::vector<uint32_t> ids(carry.size() / m_dimension);
+            std::iota(ids.begin(), ids.end(), 0u);
+            level.build(std::move(carry), std::move(ids), m_dimension);
+            return;
+        }
+
+        carry.insert(carry.end(), level.getPoints().begin(), level.getPoints().end());
+        level.clear();
+    }
+}
+
+bool NoveltyArchive::accepts(std::size_t size) const
+{
+    return size > 0 && (m_dimension == 0 || size == m_dimension);
+}
+
+void NoveltyArchive::nearest(float const * behavior, NearestDistances & nearest) const
+{
+    std::size_t const nbuffered = m_dimension > 0 ? m_buffer.size() / m_dimension : 0;
+    for(auto r = 0u; r < nbuffered; ++r)
+    {
+        float const * p = &m_buffer[r * m_dimension];
+        float d = 0.0f;
+        for(auto i = 0u; i < m_dimension; ++i)
+        {
+            float const diff = p[i] - behavior[i];
+            d += diff * diff;
+        }
+        nearest.offer(d);
+    }
+
+    for(auto const & level : m_levels)
+    {
+        if(level.size() > 0) level.nearest(behavior, nearest, NoId);
+    }
+}
+
+std::size_t NoveltyArchive::size() const
+{
+    return m_count;
+}
@@ -0,0 +1,163 @@
+#include <pareto.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// 1 if a dominates b, -1 if b dominates a, 0 otherwise
+int compare(double const * a, double const * b, std::size_t nobjectives)
+{
+    bool better = false;
+    bool worse = false;
+    for(auto k = 0u; k < nobjectives; ++k)
+    {
+        better = better || a[k] > b[k];
+        worse = worse || a[k] < b[k];
+    }
+    return better == worse ? 0 : (better ? 1 : -1);
+}
+
+}
+
+bool dominates(double const * a, double const * b, std::size_t nobjectives)
+{
+    return compare(a, b, nobjectives) > 0;
+}
+
+std::size_t nondominatedSort(
+    double const * objectives, std::size_t n, std::size_t nobjectives,
+    std::vector<uint32_t> & ranks
+)
+{
+    ranks.assign(n, 0);
+    if(n == 0) return 0;
+
+    // Row i: the points i dominates, one bit each
+    std::size_t const nwords = (n + 63) / 64;
+    std::vector<uint64_t> dominated(n * nwords, 0);
+    std::vector<uint32_t> counts(n, 0);
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for(auto i = 0u; i < n; ++i)
+    {
+        uint64_t * row = &dominated[i * nwords];
+        double const * a = objectives + i * nobjectives;
+
+        uint32_t count = 0;
+        for(auto j = 0u; j < n; ++j)
+        {
+            int const c = compare(a, objectives + j * nobjectives, nobjectives);
+            if(c > 0) row[j / 64] |= uint64_t(1) << (j % 64);
+            else if(c < 0) ++count;
+        }
+        counts[i] = count;
+    }
+
+    std::vector<uint32_t> front;
+    for(auto i = 0u; i < n; ++i)
+    {
+        if(counts[i] == 0) front.push_back(static_cast<uint32_t>(i));
+    }
+
+    // Peel the fronts: the points whose last dominator was in the front
+    // just ranked make the next one
+    std::size_t nfronts = 0;
+    std::vector<uint32_t> next;
+    while(!front.empty())
+    {
+        for(auto i : front) ranks[i] = static_cast<uint32_t>(nfronts);
+
+        next.clear();
+
+        #pragma omp parallel
+        {
+            std::vector<uint32_t> local;
+
+            #pragma omp for schedule(dynamic, 16)
+            for(auto f = 0u; f < front.size(); ++f)
+            {
+                uint64_t const * row = &dominated[front[f] * nwords];
+                for(auto w = 0u; w < nwords; ++w)
+                {
+                    for(uint64_t bits = row[w]; bits != 0; bits &= bits - 1)
+                    {
+                        std::size_t const j = w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+
+                        uint32_t left;
+                        #pragma omp atomic capture
+                        left = --counts[j];
+
+                        if(left == 0) local.push_back(static_cast<uint32_t>(j));
+                    }
+                }
+            }
+
+            #pragma omp critical
+            next.insert(next.end(), local.begin(), local.end());
+        }
+
+        front.swap(next);
+        ++nfronts;
+    }
+
+    return nfronts;
+}
+
+void crowdingDistances(
+    double const * objectives, std::size_t n, std::size_t nobjectives,
+    std::vector<uint32_t> const & ranks, std::size_t nfronts,
+    std::vector<double> & distances
+)
+{
+    double const infinity = std::numeric_limits<double>::infinity();
+    distances.assign(n, 0.0);
+
+    // Members of each front, contiguous
+    std::vector<std::size_t> offsets(nfronts + 1, 0);
+    for(auto r : ranks) ++offsets[r + 1];
+    for(auto f = 0u; f < nfronts; ++f) offsets[f + 1] += offsets[f];
+
+    std::vector<uint32_t> members(n);
+    {
+        std::vector<std::size_t> position(offsets.begin(), offsets.end() - 1);
+        for(auto i = 0u; i < n; ++i) members[position[ranks[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(auto f = 0u; f < nfronts; ++f)
+    {
+        std::vector<uint32_t> order(members.begin() + offsets[f], members.begin() + offsets[f + 1]);
+        std::size_t const size = order.size();
+
+        if(size <= 2)
+        {
+            for(auto i : order) distances[i] = infinity;
+            continue;
+        }
+
+        for(auto k = 0u; k < nobjectives; ++k)
+        {
+            auto const value = [objectives, nobjectives, k](uint32_t i)
+            {
+                return objectives[i * nobjectives + k];
+            };
+
+            std::sort(order.begin(), order.end(), [&value](uint32_t lhs, uint32_t rhs)
+            {
+                return value(lhs) < value(rhs) || (!(value(rhs) < value(lhs)) && lhs < rhs);
+            });
+
+            distances[order.front()] = infinity;
+            distances[order.back()] = infinity;
+
+            double const range = value(order.back()) - value(order.front());
+            if(!(range > 0.0)) continue;
+
+            for(auto t = 1u; t + 1 < size; ++t)
+            {
+                distances[order[t]] += (value(order[t + 1]) - value(order[t - 1])) / range;
+            }
+        }
+    }
+}
@@ -0,0 +1,268 @@
+#include <population_history.hpp>
+#include <thread_placement.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+char const MAGIC[4] = { 'N', 'C', 'P', 'H' };
+uint32_t const VERSION = 1;
+
+std::size_t recordStride(std::size_t genomeSize)
+{
+    std::size_t const size = sizeof(HistoryRecord) + genomeSize * sizeof(float);
+    return (size + alignof(HistoryRecord) - 1) / alignof(HistoryRecord) * alignof(HistoryRecord);
+}
+
+#if defined(__unix__)
+
+// Read-only mapping of a whole file (nullptr if empty or missing)
+char const * mapFile(std::string const & filename, std::size_t & size)
+{
+    size = 0;
+
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) return nullptr;
+
+    struct stat st;
+    void * data = MAP_FAILED;
+    if(::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        size = static_cast<std::size_t>(st.st_size);
+        data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+
+    if(data == MAP_FAILED)
+    {
+        size = 0;
+        return nullptr;
+    }
+    return static_cast<char const *>(data);
+}
+
+#endif
+
+}
+
+PopulationHistory::PopulationHistory(std::string const & filename, std::size_t maxPending):
+    m_file(filename, std::ios::out | std::ios::trunc | std::ios::binary),
+    m_index(filename + ".idx", std::ios::out | std::ios::trunc | std::ios::binary),
+    m_offset(0),
+    m_genomeSize(0),
+    m_stride(0),
+    m_started(false),
+    m_maxPending(std::max<std::size_t>(maxPending, 1)),
+    m_current(),
+    m_pending(),
+    m_free(),
+    m_stop(false),
+    m_mutex(),
+    m_condition(),
+    m_writer()
+{
+    if(this->isOpen()) m_writer = std::thread(&PopulationHistory::write, this);
+}
+
+PopulationHistory::~PopulationHistory()
+{
+    // The writer drains the pending generations before it stops
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+
+    if(m_writer.joinable()) m_writer.join();
+}
+
+bool PopulationHistory::isOpen() const
+{
+    return m_file.is_open() && m_index.is_open();
+}
+
+bool PopulationHistory::begin(uint64_t generation, std::size_t n, std::size_t genomeSize)
+{
+    if(!this->isOpen()) return false;
+
+    if(!m_started)
+    {
+        m_genomeSize = genomeSize;
+        m_stride = recordStride(genomeSize);
+
+        PopulationHistoryHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.genomeSize = uint32_t(m_genomeSize);
+        header.stride = uint32_t(m_stride);
+
+        // Nothing is queued yet: the writer is idle
+        m_file.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        m_offset = sizeof(header);
+        m_started = true;
+    }
+
+    if(genomeSize != m_genomeSize) return false;
+
+    // Recycle a written block, once the writer caught up
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] { return m_pending.size() < m_maxPending; });
+
+        if(!m_free.empty())
+        {
+            m_current = std::move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+
+    m_current.generation = generation;
+    m_current.count = n;
+    m_current.data.resize(n * m_stride);
+    return true;
+}
+
+void PopulationHistory::setRecord(
+    std::size_t i, double fitness, uint32_t parentA, uint32_t parentB,
+    float const * genome, std::size_t size
+)
+{
+    char * record = &m_current.data[i * m_stride];
+
+    HistoryRecord header;
+    header.fitness = fitness;
+    header.parents[0] = parentA;
+    header.parents[1] = parentB;
+    std::memcpy(record, &header, sizeof(header));
+
+    std::size_t const nbytes = std::min(size, m_genomeSize) * sizeof(float);
+    if(nbytes > 0) std::memcpy(record + sizeof(header), genome, nbytes);
+    std::memset(record + sizeof(header) + nbytes, 0, m_stride - sizeof(header) - nbytes);
+}
+
+void PopulationHistory::commit()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(std::move(m_current));
+    }
+    m_condition.notify_all();
+
+    m_current = Block();
+}
+
+void PopulationHistory::write()
+{
+    // Off the CPU of the thread that created the history, if pinned
+    unpinCurrentThread();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for(;;)
+    {
+        m_condition.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+        if(m_pending.empty()) return;
+
+        Block block = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+
+        // The records, then their index entry
+        HistoryIndexEntry entry;
+        entry.generation = block.generation;
+        entry.offset = m_offset;
+        entry.count = block.count;
+
+        m_file.write(block.data.data(), std::streamsize(block.data.size()));
+        m_file.flush();
+        m_index.write(reinterpret_cast<char const *>(&entry), sizeof(entry));
+        m_index.flush();
+        m_offset += block.data.size();
+
+        lock.lock();
+        m_free.push_back(std::move(block));
+        m_condition.notify_all();
+    }
+}
+
+PopulationHistoryReader::PopulationHistoryReader(std::string const & filename):
+    m_data(nullptr),
+    m_size(0),
+    m_index(nullptr),
+    m_indexSize(0),
+    m_ngenerations(0),
+    m_genomeSize(0),
+    m_stride(0)
+{
+    #if defined(__unix__)
+    // The records first: the index may only refer to records already there
+    m_data = mapFile(filename, m_size);
+    if(!m_data || m_size < sizeof(PopulationHistoryHeader)) return;
+
+    PopulationHistoryHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) return;
+
+    m_genomeSize = header.genomeSize;
+    m_stride = header.stride;
+
+    char const * index = mapFile(filename + ".idx", m_indexSize);
+    m_index = reinterpret_cast<HistoryIndexEntry const *>(index);
+
+    // Complete generations only
+    std::size_t const nentries = m_indexSize / sizeof(HistoryIndexEntry);
+    while(m_ngenerations < nentries)
+    {
+        HistoryIndexEntry const & entry = m_index[m_ngenerations];
+        if(entry.offset + entry.count * m_stride > m_size) break;
+        ++m_ngenerations;
+    }
+    #else
+    (void) filename;
+    #endif
+}
+
+PopulationHistoryReader::~PopulationHistoryReader()
+{
+    #if defined(__unix__)
+    if(m_data) ::munmap(const_cast<char *>(m_data), m_size);
+    if(m_index) ::munmap(const_cast<HistoryIndexEntry *>(m_index), m_indexSize);
+    #endif
+}
+
+bool PopulationHistoryReader::isOpen() const
+{
+    return m_stride > 0;
+}
+
+std::size_t PopulationHistoryReader::getGenomeSize() const
+{
+    return m_genomeSize;
+}
+
+std::size_t PopulationHistoryReader::getGenerationCount() const
+{
+    return m_ngenerations;
+}
+
+HistoryIndexEntry const & PopulationHistoryReader::getGeneration(std::size_t g) const
+{
+    return m_index[g];
+}
+
+HistoryRecord const & PopulationHistoryReader::getRecord(std::size_t g, std::size_t i) const
+{
+    return *reinterpret_cast<HistoryRecord const *>(m_data + m_index[g].offset + i * m_stride);
+}
+
+float const * PopulationHistoryReader::getGenome(HistoryRecord const & record) const
+{
+    return reinterpret_cast<float const *>(&record + 1);
+}
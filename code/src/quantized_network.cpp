@@ -0,0 +1,437 @@
+#include <quantized_network.hpp>
+#include <cpu_dispatch.hpp>
+#include <functions.hpp>
+#include <genome.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if NEURO_CAR_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace NeuroCar {
+
+namespace {
+
+char const MAGIC[4] = { 'N', 'C', 'Q', '8' };
+uint32_t const VERSION = 1;
+
+// int16 lanes per SIMD dot product step
+uint32_t const ROW_ALIGNMENT = 8;
+
+// Scratch buffers of the inference, reused between steps
+thread_local std::vector<int16_t> quantizedBuffer;
+thread_local std::vector<int32_t> accumulatorBuffer;
+thread_local std::vector<QuantizedNetwork::Weight> activationBuffer;
+
+// Dot product of a padded row with the quantized inputs, stride being a
+// multiple of ROW_ALIGNMENT
+int32_t dotRowGeneric(int16_t const * w, int16_t const * q, uint32_t stride)
+{
+    int32_t sum = 0;
+
+    #ifdef __SSE2__
+    __m128i vsum = _mm_setzero_si128();
+    for(auto i = 0u; i < stride; i += ROW_ALIGNMENT)
+    {
+        __m128i const vw = _mm_loadu_si128(reinterpret_cast<__m128i const *>(w + i));
+        __m128i const vq = _mm_loadu_si128(reinterpret_cast<__m128i const *>(q + i));
+        vsum = _mm_add_epi32(vsum, _mm_madd_epi16(vw, vq));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), vsum);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    #else
+    for(auto i = 0u; i < stride; ++i)
+    {
+        sum += int32_t(w[i]) * int32_t(q[i]);
+    }
+    #endif
+
+    return sum;
+}
+
+#if NEURO_CAR_DISPATCH
+
+NEURO_CAR_TARGET_AVX2
+int32_t dotRowAvx2(int16_t const * w, int16_t const * q, uint32_t stride)
+{
+    __m256i vsum = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for(; i + 16 <= stride; i += 16)
+    {
+        __m256i const vw = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(w + i));
+        __m256i const vq = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(q + i));
+        vsum = _mm256_add_epi32(vsum, _mm256_madd_epi16(vw, vq));
+    }
+
+    __m128i sum = _mm_add_epi32(
+        _mm256_castsi256_si128(vsum), _mm256_extracti128_si256(vsum, 1)
+    );
+    if(i < stride)
+    {
+        __m128i const vw = _mm_loadu_si128(reinterpret_cast<__m128i const *>(w + i));
+        __m128i const vq = _mm_loadu_si128(reinterpret_cast<__m128i const *>(q + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(vw, vq));
+    }
+    sum = _mm_hadd_epi32(sum, sum);
+    sum = _mm_hadd_epi32(sum, sum);
+    return _mm_cvtsi128_si32(sum);
+}
+
+NEURO_CAR_TARGET_AVX512
+int32_t dotRowAvx512(int16_t const * w, int16_t const * q, uint32_t stride)
+{
+    __m512i vsum = _mm512_setzero_si512();
+    uint32_t i = 0;
+    for(; i + 32 <= stride; i += 32)
+    {
+        vsum = _mm512_add_epi32(vsum,
+            _mm512_madd_epi16(_mm512_loadu_si512(w + i), _mm512_loadu_si512(q + i))
+        );
+    }
+    int32_t lanes[16];
+    _mm512_storeu_si512(lanes, vsum);
+
+    int32_t sum = dotRowAvx2(w + i, q + i, stride - i);
+    for(auto l : lanes) sum += l;
+    return sum;
+}
+
+#endif
+
+template <typename T>
+void write(std::ofstream & file, T const & value)
+{
+    file.write(reinterpret_cast<char const *>(&value), sizeof(T));
+}
+
+template <typename T>
+void writeArray(std::ofstream & file, std::vector<T> const & values)
+{
+    file.write(
+        reinterpret_cast<char const *>(values.data()),
+        static_cast<std::streamsize>(values.size() * sizeof(T))
+    );
+}
+
+template <typename T>
+bool read(std::ifstream & file, T & value)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+template <typename T>
+bool readArray(std::ifstream & file, std::vector<T> & values, std::size_t n)
+{
+    values.resize(n);
+    return static_cast<bool>(file.read(
+        reinterpret_cast<char *>(values.data()),
+        static_cast<std::streamsize>(n * sizeof(T))
+    ));
+}
+
+double maxAbs(double const * values, std::size_t n)
+{
+    double m = 0.0;
+    for(auto i = 0u; i < n; ++i) m = std::max(m, std::abs(values[i]));
+    return m;
+}
+
+}
+
+QuantizedNetwork::QuantizedNetwork():
+    m_shape(),
+    m_layers()
+{
+
+}
+
+QuantizedNetwork QuantizedNetwork::quantize(
+    NeuroEvolution::NeuralNetwork const & nn,
+    std::vector<Weight> const & calibrationInputs
+)
+{
+    auto const & nnshape = nn.getShape();
+    assert(nnshape.size() >= 2);
+
+    QuantizedNetwork qnn;
+    for(auto n : nnshape) qnn.m_shape.push_back(static_cast<uint32_t>(n));
+
+    Genome genome;
+    networkToGenome(nn, genome);
+
+    std::size_t const nsamples = calibrationInputs.size() / nnshape[0];
+
+    // Float activations of the current layer, for every calibration sample
+    std::vector<Weight> activations(
+        calibrationInputs.begin(),
+        calibrationInputs.begin() + nsamples * nnshape[0]
+    );
+    std::vector<Weight> next;
+
+    std::size_t row = 0;
+    for(auto l = 0u; l + 1 < nnshape.size(); ++l)
+    {
+        uint32_t const I = qnn.m_shape[l];
+        uint32_t const J = qnn.m_shape[l+1];
+
+        Layer layer;
+        layer.inputs = I;
+        layer.outputs = J;
+
+        // Without calibration data, assume activations in [-1, 1]
+        double const maxActivation = nsamples > 0 ?
+            maxAbs(activations.data(), activations.size()) : 1.0;
+        layer.inputScale = static_cast<float>(
+            (maxActivation > 0.0 ? maxActivation : 1.0) / 32767.0
+        );
+
+        double maxWeight = 0.0;
+        for(auto j = 0u; j < J; ++j)
+        {
+            float const * w = &genome[row + j * (I + 1)];
+            for(auto i = 0u; i < I; ++i) maxWeight = std::max(maxWeight, double(std::abs(w[i])));
+        }
+        layer.weightScale = static_cast<float>(
+            (maxWeight > 0.0 ? maxWeight : 1.0) / 127.0
+        );
+
+        double const biasScale = double(layer.inputScale) * layer.weightScale;
+        double const maxBias = std::numeric_limits<int32_t>::max();
+
+        layer.weights.resize(J * I);
+        layer.biases.resize(J);
+        for(auto j = 0u; j < J; ++j)
+        {
+            float const * w = &genome[row + j * (I + 1)];
+            for(auto i = 0u; i < I; ++i)
+            {
+                double const q = std::round(w[i] / layer.weightScale);
+                layer.weights[j * I + i] = static_cast<int8_t>(std::max(-127.0, std::min(127.0, q)));
+            }
+
+            double const b = std::round(w[I] / biasScale);
+            layer.biases[j] = static_cast<int32_t>(std::max(-maxBias, std::min(maxBias, b)));
+        }
+
+        // Float forward pass to calibrate the next layer
+        next.resize(nsamples * J);
+        for(auto s = 0u; s < nsamples; ++s)
+        {
+            Weight const * in = &activations[s * I];
+            for(auto j = 0u; j < J; ++j)
+            {
+                float const * w = &genome[row + j * (I + 1)];
+                Weight sum = w[I];
+                for(auto i = 0u; i < I; ++i) sum += w[i] * in[i];
+                next[s * J + j] = NeuroEvolution::sigmoid(sum);
+            }
+        }
+        std::swap(activations, next);
+
+        row += (I + 1) * J;
+        qnn.m_layers.push_back(std::move(layer));
+    }
+
+    qnn.prepare();
+
+    return qnn;
+}
+
+QuantizedNetwork::Shape const & QuantizedNetwork::getShape() const
+{
+    return m_shape;
+}
+
+void QuantizedNetwork::prepare()
+{
+    for(auto & layer : m_layers)
+    {
+        uint32_t const I = layer.inputs;
+        layer.stride = (I + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+        layer.rows.assign(layer.outputs * layer.stride, 0);
+        for(auto j = 0u; j < layer.outputs; ++j)
+        {
+            for(auto i = 0u; i < I; ++i)
+            {
+                layer.rows[j * layer.stride + i] = layer.weights[j * I + i];
+            }
+        }
+    }
+}
+
+void QuantizedNetwork::quantizeInputs(
+    Layer const & layer, Weight const * inputs, int16_t * q
+) const
+{
+    Weight const inv = 1.0 / layer.inputScale;
+    for(auto i = 0u; i < layer.inputs; ++i)
+    {
+        Weight const v = std::round(inputs[i] * inv);
+        q[i] = static_cast<int16_t>(std::max(-32767.0, std::min(32767.0, v)));
+    }
+    std::fill(q + layer.inputs, q + layer.stride, int16_t(0));
+}
+
+void QuantizedNetwork::accumulate(
+    Layer const & layer, int16_t const * q, int32_t * acc
+) const
+{
+    static auto const dotRow = NEURO_CAR_SELECT_KERNEL(dotRow);
+
+    for(auto j = 0u; j < layer.outputs; ++j)
+    {
+        int16_t const * w = &layer.rows[j * layer.stride];
+        acc[j] = dotRow(w, q, layer.stride) + layer.biases[j];
+    }
+}
+
+uint32_t QuantizedNetwork::computeFlags(Weight const * inputs) const
+{
+    uint32_t maxWidth = 0;
+    for(auto n : m_shape) maxWidth = std::max(maxWidth, n);
+
+    quantizedBuffer.resize(maxWidth + ROW_ALIGNMENT);
+    accumulatorBuffer.resize(maxWidth);
+    activationBuffer.resize(maxWidth);
+
+    Weight const * in = inputs;
+    for(auto l = 0u; l < m_layers.size(); ++l)
+    {
+        Layer const & layer = m_layers[l];
+
+        this->quantizeInputs(layer, in, quantizedBuffer.data());
+        this->accumulate(layer, quantizedBuffer.data(), accumulatorBuffer.data());
+
+        // sigmoid(x) > 0.5 <=> x > 0: the last layer stays in integers
+        if(l + 1 == m_layers.size())
+        {
+            uint32_t flags = 0;
+            for(auto j = 0u; j < layer.outputs; ++j)
+            {
+                if(accumulatorBuffer[j] > 0) flags |= 1u << j;
+            }
+            return flags;
+        }
+
+        Weight const scale = Weight(layer.inputScale) * layer.weightScale;
+        for(auto j = 0u; j < layer.outputs; ++j)
+        {
+            activationBuffer[j] = NeuroEvolution::sigmoid(accumulatorBuffer[j] * scale);
+        }
+        in = activationBuffer.data();
+    }
+
+    return 0;
+}
+
+void QuantizedNetwork::compute(Weight const * inputs, Weight * outputs) const
+{
+    uint32_t maxWidth = 0;
+    for(auto n : m_shape) maxWidth = std::max(maxWidth, n);
+
+    quantizedBuffer.resize(maxWidth + ROW_ALIGNMENT);
+    accumulatorBuffer.resize(maxWidth);
+    activationBuffer.resize(maxWidth);
+
+    Weight const * in = inputs;
+    for(auto const & layer : m_layers)
+    {
+        this->quantizeInputs(layer, in, quantizedBuffer.data());
+        this->accumulate(layer, quantizedBuffer.data(), accumulatorBuffer.data());
+
+        Weight const scale = Weight(layer.inputScale) * layer.weightScale;
+        for(auto j = 0u; j < layer.outputs; ++j)
+        {
+            activationBuffer[j] = NeuroEvolution::sigmoid(accumulatorBuffer[j] * scale);
+        }
+        in = activationBuffer.data();
+    }
+
+    std::copy(in, in + m_shape.back(), outputs);
+}
+
+std::size_t QuantizedNetwork::byteSize() const
+{
+    std::size_t size = sizeof(MAGIC) + 2 * sizeof(uint32_t);
+    size += m_shape.size() * sizeof(uint32_t);
+    for(auto const & layer : m_layers)
+    {
+        size += 2 * sizeof(float);
+        size += layer.biases.size() * sizeof(int32_t);
+        size += layer.weights.size() * sizeof(int8_t);
+    }
+    return size;
+}
+
+bool saveToFile(QuantizedNetwork const & qnn, std::string const & filename)
+{
+    std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(!file) return false;
+
+    file.write(MAGIC, sizeof(MAGIC));
+    write(file, VERSION);
+    write(file, static_cast<uint32_t>(qnn.m_shape.size()));
+    writeArray(file, qnn.m_shape);
+
+    for(auto const & layer : qnn.m_layers)
+    {
+        write(file, layer.inputScale);
+        write(file, layer.weightScale);
+        writeArray(file, layer.biases);
+        writeArray(file, layer.weights);
+    }
+
+    return static_cast<bool>(file);
+}
+
+bool loadFromFile(std::string const & filename, QuantizedNetwork & qnn)
+{
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if(!file) return false;
+
+    char magic[sizeof(MAGIC)];
+    uint32_t version = 0;
+    uint32_t nlayers = 0;
+
+    if(!file.read(magic, sizeof(magic))) return false;
+    if(std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if(!read(file, version) || version != VERSION) return false;
+    if(!read(file, nlayers) || nlayers < 2) return false;
+
+    QuantizedNetwork::Shape shape;
+    if(!readArray(file, shape, nlayers)) return false;
+
+    std::vector<QuantizedNetwork::Layer> layers;
+    for(auto l = 0u; l + 1 < shape.size(); ++l)
+    {
+        QuantizedNetwork::Layer layer;
+        layer.inputs = shape[l];
+        layer.outputs = shape[l+1];
+
+        if(!read(file, layer.inputScale)) return false;
+        if(!read(file, layer.weightScale)) return false;
+        if(!readArray(file, layer.biases, layer.outputs)) return false;
+        if(!readArray(file, layer.weights, layer.outputs * layer.inputs)) return false;
+
+        layers.push_back(std::move(layer));
+    }
+
+    qnn.m_shape = shape;
+    qnn.m_layers = std::move(layers);
+    qnn.prepare();
+
+    return true;
+}
+
+}
@@ -0,0 +1,295 @@
+#include <run_status.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NeuroCar {
+
+// Layout of the shared memory segment. The genome follows the block, as
+// capacity words holding the bits of its floats.
+struct RunStatusSegment
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t capacity;
+
+    std::atomic<uint32_t> sequence; // Odd while the writer updates the block
+
+    std::atomic<uint32_t> genomeSize;
+    std::atomic<uint64_t> generation;
+    std::atomic<uint64_t> evaluations;
+    std::atomic<uint64_t> evaluationsPerSecond; // Bits of a double
+    std::atomic<uint64_t> bestFitness;          // Bits of a double
+    std::atomic<uint64_t> updateTime;
+};
+
+namespace {
+
+char const MAGIC[4] = { 'N', 'C', 'S', 'T' };
+uint32_t const VERSION = 1;
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Shared atomics must be lock-free");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared atomics must be lock-free");
+
+std::size_t segmentSize(std::size_t capacity)
+{
+    return sizeof(RunStatusSegment) + capacity * sizeof(std::atomic<uint32_t>);
+}
+
+std::atomic<uint32_t> * genomeWords(RunStatusSegment * segment)
+{
+    return reinterpret_cast<std::atomic<uint32_t> *>(segment + 1);
+}
+
+std::atomic<uint32_t> const * genomeWords(RunStatusSegment const * segment)
+{
+    return reinterpret_cast<std::atomic<uint32_t> const *>(segment + 1);
+}
+
+uint64_t toBits(double value)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits)
+{
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count());
+}
+
+}
+
+RunStatusWriter::RunStatusWriter(std::string const & name, std::size_t maxGenomeSize):
+    m_name(name),
+    m_segment(nullptr),
+    m_size(segmentSize(maxGenomeSize)),
+    m_status(),
+    m_lastTime(Clock::now()),
+    m_lastEvaluations(0)
+{
+    #if defined(__unix__)
+    int const fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if(fd < 0) return;
+
+    if(::ftruncate(fd, static_cast<off_t>(m_size)) != 0)
+    {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return;
+    }
+
+    void * data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED)
+    {
+        ::shm_unlink(name.c_str());
+        return;
+    }
+
+    m_segment = new (data) RunStatusSegment();
+    for(auto i = 0u; i < maxGenomeSize; ++i)
+    {
+        new (genomeWords(m_segment) + i) std::atomic<uint32_t>(0);
+    }
+
+    std::memcpy(m_segment->magic, MAGIC, sizeof(MAGIC));
+    m_segment->version = VERSION;
+    m_segment->capacity = static_cast<uint32_t>(maxGenomeSize);
+    m_segment->sequence.store(0, std::memory_order_release);
+    #endif
+
+    m_status.bestFitness = -1.0;
+}
+
+RunStatusWriter::~RunStatusWriter()
+{
+    #if defined(__unix__)
+    if(m_segment)
+    {
+        ::munmap(m_segment, m_size);
+        ::shm_unlink(m_name.c_str());
+    }
+    #endif
+}
+
+bool RunStatusWriter::isOpen() const
+{
+    return m_segment != nullptr;
+}
+
+void RunStatusWriter::publish(uint64_t generation, uint64_t evaluations)
+{
+    this->write(generation, evaluations, nullptr);
+}
+
+void RunStatusWriter::publish(
+    uint64_t generation, uint64_t evaluations,
+    double fitness, Genome const & genome
+)
+{
+    if(fitness > m_status.bestFitness)
+    {
+        m_status.bestFitness = fitness;
+        this->write(generation, evaluations, &genome);
+    }
+    else
+    {
+        this->write(generation, evaluations, nullptr);
+    }
+}
+
+void RunStatusWriter::write(
+    uint64_t generation, uint64_t evaluations, Genome const * genome
+)
+{
+    // Throughput since the last publication that saw new evaluations
+    Clock::time_point const time = Clock::now();
+    if(evaluations > m_lastEvaluations)
+    {
+        double const seconds = std::chrono::duration<double>(time - m_lastTime).count();
+        if(seconds > 0.0)
+        {
+            m_status.evaluationsPerSecond = (evaluations - m_lastEvaluations) / seconds;
+        }
+        m_lastEvaluations = evaluations;
+        m_lastTime = time;
+    }
+
+    m_status.generation = generation;
+    m_status.evaluations = evaluations;
+    m_status.updateTime = now();
+
+    if(!m_segment) return;
+
+    RunStatusSegment & s = *m_segment;
+    uint32_t const sequence = s.sequence.load(std::memory_order_relaxed);
+
+    s.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    s.generation.store(m_status.generation, std::memory_order_relaxed);
+    s.evaluations.store(m_status.evaluations, std::memory_order_relaxed);
+    s.evaluationsPerSecond.store(toBits(m_status.evaluationsPerSecond), std::memory_order_relaxed);
+    s.bestFitness.store(toBits(m_status.bestFitness), std::memory_order_relaxed);
+    s.updateTime.store(m_status.updateTime, std::memory_order_relaxed);
+
+    if(genome)
+    {
+        std::size_t const n = std::min<std::size_t>(genome->size(), s.capacity);
+        std::atomic<uint32_t> * words = genomeWords(m_segment);
+        for(auto i = 0u; i < n; ++i)
+        {
+            uint32_t bits = 0;
+            std::memcpy(&bits, &(*genome)[i], sizeof(bits));
+            words[i].store(bits, std::memory_order_relaxed);
+        }
+        s.genomeSize.store(static_cast<uint32_t>(n), std::memory_order_relaxed);
+    }
+
+    s.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+RunStatusReader::RunStatusReader(std::string const & name):
+    m_segment(nullptr),
+    m_size(0)
+{
+    #if defined(__unix__)
+    int const fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0) return;
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(RunStatusSegment))
+    {
+        ::close(fd);
+        return;
+    }
+
+    m_size = static_cast<std::size_t>(st.st_size);
+    void * data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) return;
+
+    m_segment = static_cast<RunStatusSegment const *>(data);
+    #else
+    static_cast<void>(name);
+    #endif
+}
+
+RunStatusReader::~RunStatusReader()
+{
+    #if defined(__unix__)
+    if(m_segment)
+    {
+        ::munmap(const_cast<RunStatusSegment *>(m_segment), m_size);
+    }
+    #endif
+}
+
+bool RunStatusReader::isOpen() const
+{
+    return m_segment != nullptr;
+}
+
+bool RunStatusReader::read(RunStatus & status) const
+{
+    if(!m_segment) return false;
+
+    RunStatusSegment const & s = *m_segment;
+    if(std::memcmp(s.magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+    if(s.version != VERSION) return false;
+    if(segmentSize(s.capacity) > m_size) return false;
+
+    std::atomic<uint32_t> const * words = genomeWords(m_segment);
+
+    while(true)
+    {
+        uint32_t const before = s.sequence.load(std::memory_order_acquire);
+        if(before == 0) return false;
+        if(before & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        status.generation = s.generation.load(std::memory_order_relaxed);
+        status.evaluations = s.evaluations.load(std::memory_order_relaxed);
+        status.evaluationsPerSecond = fromBits(s.evaluationsPerSecond.load(std::memory_order_relaxed));
+        status.bestFitness = fromBits(s.bestFitness.load(std::memory_order_relaxed));
+        status.updateTime = s.updateTime.load(std::memory_order_relaxed);
+
+        std::size_t const n = std::min(
+            s.genomeSize.load(std::memory_order_relaxed), s.capacity
+        );
+        status.bestGenome.resize(n);
+        for(auto i = 0u; i < n; ++i)
+        {
+            uint32_t const bits = words[i].load(std::memory_order_relaxed);
+            std::memcpy(&status.bestGenome[i], &bits, sizeof(bits));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(s.sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+}
+
+}
@@ -1,13 +1,73 @@
 #include <self_driving_car.hpp>
+#include <genome_kernels.hpp>
+#include <world_factory.hpp>
 #include <renderer.hpp>
 
-#include <random>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
 
 namespace NeuroCar {
 
+namespace {
+
+PoolCounter individualCounter;
+PoolCounter carCounter;
+std::atomic<uint64_t> episodeCounter(0);
+
+// Encoded evaluations: uint32 count, then the values
+template <typename Value>
+void appendValues(std::vector<char> & data, std::vector<Value> const & values)
+{
+    uint32_t const count = uint32_t(values.size());
+    char const * bytes = reinterpret_cast<char const *>(values.data());
+    char header[sizeof(count)];
+    std::memcpy(header, &count, sizeof(count));
+    data.insert(data.end(), header, header + sizeof(count));
+    data.insert(data.end(), bytes, bytes + count * sizeof(Value));
+}
+
+template <typename Value>
+bool extractValues(
+    char const * data, std::size_t size, std::size_t & offset, std::vector<Value> & values
+)
+{
+    uint32_t count = 0;
+    if(size - offset < sizeof(count)) return false;
+    std::memcpy(&count, data + offset, sizeof(count));
+    offset += sizeof(count);
+
+    if((size - offset) / sizeof(Value) < count) return false;
+    values.resize(count);
+    std::memcpy(values.data(), data + offset, count * sizeof(Value));
+    offset += count * sizeof(Value);
+    return true;
+}
+
+}
+
+SelfDrivingCarPoolStats getPoolStats()
+{
+    SelfDrivingCarPoolStats stats;
+    stats.individuals = individualCounter.counts();
+    stats.worlds = getWorldCounts();
+    stats.cars = carCounter.counts();
+    return stats;
+}
+
+uint64_t getEpisodeCount()
+{
+    return episodeCounter.load(std::memory_order_relaxed);
+}
+
 SelfDrivingCar::SelfDrivingCar():
     m_car(nullptr),
-    m_neuroController()
+    m_neuroController(),
+    m_genome(),
+    m_networkOutdated(false),
+    m_traceRank(-1)
 {
 
 }
@@ -30,6 +90,11 @@ SelfDrivingCar::NeuralNetwork & SelfDrivingCar::getNeuralNetwork()
 void SelfDrivingCar::setNeuroController(NeuroController nc)
 {
     m_neuroController = nc;
+
+    // The controller may not hold a float network (quantized inference):
+    // the genome is only reloaded on demand with syncGenome
+    m_genome.clear();
+    m_networkOutdated = false;
 }
 
 SelfDrivingCar::NeuralNetwork const & SelfDrivingCar::getNeuralNetwork() const
@@ -37,6 +102,31 @@ SelfDrivingCar::NeuralNetwork const & SelfDrivingCar::getNeuralNetwork() const
     return m_neuroController.getNeuralNetwork();
 }
 
+Genome const & SelfDrivingCar::getGenome() const
+{
+    return m_genome;
+}
+
+Genome & SelfDrivingCar::editGenome()
+{
+    m_networkOutdated = true;
+    return m_genome;
+}
+
+void SelfDrivingCar::syncGenome()
+{
+    networkToGenome(m_neuroController.getNeuralNetwork(), m_genome);
+    m_networkOutdated = false;
+}
+
+void SelfDrivingCar::syncNeuralNetwork()
+{
+    if(m_networkOutdated)
+    {
+        genomeToNetwork(m_genome, m_neuroController.getNeuralNetwork());
+        m_networkOutdated = false;
+    }
+}
 
 b2Vec2 const & SelfDrivingCar::getDestination() const
 {
@@ -59,6 +149,16 @@ uint32_t SelfDrivingCar::getWorldSeed()
     return m_worldSeed;
 }
 
+void SelfDrivingCar::setTraceRank(int32_t rank)
+{
+    m_traceRank = rank;
+}
+
+int32_t SelfDrivingCar::getTraceRank() const
+{
+    return m_traceRank;
+}
+
 std::shared_ptr<Car> const & SelfDrivingCar::getCar() const
 {
     return m_car;
@@ -87,61 +187,199 @@ void SelfDrivingCarDNA::randomize(std::size_t seed)
     SelfDrivingCar::NeuralNetwork & nn = nc.getNeuralNetwork();
     nn.setSeed(seed);
     nn.synthetize();
+    car->syncGenome();
 }
 
 SelfDrivingCarDNA::Fitness SelfDrivingCarDNA::computeFitness(std::size_t ngen)
 {
-    uint32_t const worldWidth  = m_params.worldWidth;
-    uint32_t const worldHeight = m_params.worldHeight;
-    uint32_t const nbObstacles = m_params.worldNbObstacles;
-    uint32_t const seedChangeInterval = m_params.worldSeedChangeInterval;
-    uint32_t const simulationRate = m_params.worldSimulationRate;
+    return this->simulate(ngen, this->getEpisodeLength(ngen), m_params.episodeLength);
+}
 
-    // Create world lambda
-    #if CAR_PHYSICS_GRAPHIC_MODE_SFML
-    Renderer r(2, worldWidth, worldHeight);
-    auto const createWorld = [&r, &simulationRate](
-        uint32_t w, uint32_t h, uint32_t nbObstacles, uint32_t seed
-    )
+SelfDrivingCarDNA::Fitness SelfDrivingCarDNA::computePartialFitness(
+    std::size_t ngen, double budget
+)
+{
+    // Without a known episode length the budget cannot be enforced
+    if(m_params.episodeLength == 0)
     {
-        World * world = new World(8, 3, &r, simulationRate, 2);
-        world->addBorders(w, h);
-        world->randomize(w, h, nbObstacles, seed);
-        return world;
+        return this->computeFitness(ngen);
+    }
+
+    static auto const scale = [](double fraction, uint32_t length)
+    {
+        uint32_t const steps = std::max(1u, static_cast<uint32_t>(std::ceil(fraction * length)));
+        return std::min(steps, length);
     };
-    #else
-    auto const createWorld = [&simulationRate](
-        uint32_t w, uint32_t h, uint32_t nbObstacles, uint32_t seed
-    )
+
+    // A truncated episode is not the one to trace: keep the rank for the
+    // full evaluation
+    int32_t const traceRank = this->getSubject()->getTraceRank();
+    this->getSubject()->setTraceRank(-1);
+
+    Fitness const fitness = this->simulate(
+        ngen,
+        scale(budget, this->getEpisodeLength(ngen)),
+        scale(budget, m_params.episodeLength)
+    );
+
+    this->getSubject()->setTraceRank(traceRank);
+
+    return fitness;
+}
+
+SelfDrivingCarDNA::Fitness SelfDrivingCarDNA::computeCoarseFitness(std::size_t ngen)
+{
+    Params const fine = m_params;
+    uint32_t const rate = std::max(1u, fine.coarseSimulationRate);
+
+    // Same simulated time: the step counts follow the physics rate
+    auto const scale = [rate, &fine](uint32_t steps)
     {
-        World * world = new World(8, 3, simulationRate);
-        world->addBorders(w, h);
-        world->randomize(w, h, nbObstacles, seed);
-        return world;
+        if(steps == 0) return 0u;
+        return std::max(1u, static_cast<uint32_t>(std::lround(
+            static_cast<double>(steps) * rate / std::max(1u, fine.worldSimulationRate)
+        )));
     };
-    #endif
 
+    uint32_t const maxSteps = scale(this->getEpisodeLength(ngen));
+    uint32_t const fixedSteps = scale(fine.episodeLength);
+
+    m_params.worldSimulationRate = rate;
+    m_params.velocityIterations = fine.coarseVelocityIterations;
+    m_params.positionIterations = fine.coarsePositionIterations;
+    m_params.controlPeriod = std::max(1u, scale(fine.controlPeriod));
+
+    int32_t const traceRank = this->getSubject()->getTraceRank();
+    this->getSubject()->setTraceRank(-1);
+
+    Fitness const fitness = this->simulate(ngen, maxSteps, fixedSteps);
+
+    this->getSubject()->setTraceRank(traceRank);
+    m_params = fine;
+
+    return fitness;
+}
+
+std::function<void ()> SelfDrivingCarDNA::prepareEvaluation(std::size_t ngen) const
+{
+    uint32_t const seed = this->getWorldSeed(ngen);
+    if(ngen > 0 && seed == this->getWorldSeed(ngen - 1)) return std::function<void ()>();
+
+    // A car at its spawn point, not shared with the dna
+    carCounter.allocated();
+    std::shared_ptr<Car> const car = this->getSubject()->getCar()->cloneInitial();
+    Params const params = m_params;
+
+    return [params, car, seed]()
+    {
+        findValidSeed(params, car, seed);
+    };
+}
+
+uint32_t SelfDrivingCarDNA::getEpisodeLength(std::size_t ngen) const
+{
+    if(m_params.curriculum && m_params.episodeLength > 0)
+    {
+        return m_params.curriculum->getEpisodeLength(ngen);
+    }
+
+    return m_params.episodeLength;
+}
+
+uint32_t SelfDrivingCarDNA::getWorldSeed(std::size_t ngen) const
+{
     uint32_t seed = this->getSubject()->getWorldSeed() + 1; // +1 to make sure seed > 0
-    seed += uint32_t(ngen / seedChangeInterval);
+    seed += uint32_t(ngen / m_params.worldSeedChangeInterval);
+    return seed;
+}
 
-    World * world = createWorld(worldWidth, worldHeight, nbObstacles, seed);
+SelfDrivingCarDNA::Fitness SelfDrivingCarDNA::simulate(
+    std::size_t ngen, uint32_t maxSteps, uint32_t fixedSteps
+)
+{
+    // Create world
+    #if CAR_PHYSICS_GRAPHIC_MODE_SFML
+    Renderer r(2, m_params.worldWidth, m_params.worldHeight);
+    Renderer * renderer = &r;
+    #else
+    Renderer * renderer = nullptr;
+    #endif
 
     std::shared_ptr<Car> car = this->getSubject()->getCar();
 
-    // Generate worlds until one is valid
-    while(world->willCollide(car))
+    std::unique_ptr<World> world = createValidWorld(
+        m_params, car, this->getWorldSeed(ngen), renderer
+    );
+
+    // Apply the genetic operators to the network once before the episode
+    this->getSubject()->syncNeuralNetwork();
+
+    NeuroController & nc = this->getSubject()->getNeuroController();
+
+    // Compact the non-zero weights once for the whole episode
+    if(m_params.sparseInference && nc.getInference() != NeuroController::Inference::Quantized)
     {
-        delete world;
-        world = createWorld(worldWidth, worldHeight, nbObstacles, ++seed);
+        if(this->getSubject()->getGenome().empty()) this->getSubject()->syncGenome();
+        nc.compactNetwork(this->getSubject()->getGenome());
+        nc.setInference(NeuroController::Inference::Sparse);
     }
 
+    nc.setStepLimit(maxSteps);
+    nc.setControlPeriod(m_params.controlPeriod);
+    nc.resetStepCount();
+
+    // Behavior descriptor: behaviorSamples positions evenly spread over the
+    // step budget, then the final position
+    uint32_t const nsamples = m_params.behaviorSamples;
+    m_behavior.clear();
+    nc.setPositionLog(
+        &m_behavior, nsamples > 0 && maxSteps > 0 ? std::max(1u, maxSteps / nsamples) : 0
+    );
+
     world->addRequiredDrawable(car);
 
+    TrajectoryRecorder * recorder = nullptr;
+    int32_t const traceRank = this->getSubject()->getTraceRank();
+    if(m_params.recorder && traceRank >= 0)
+    {
+        recorder = m_params.recorder.get();
+        recorder->beginEpisode(
+            uint32_t(ngen), uint32_t(traceRank), this->getWorldSeed(ngen)
+        );
+        nc.setRecorder(recorder);
+    }
+
     world->run();
+    episodeCounter.fetch_add(1, std::memory_order_relaxed);
+
+    nc.setPositionLog(nullptr, 0);
+
+    if(m_params.curriculum)
+    {
+        m_params.curriculum->recordEpisode(maxSteps, fixedSteps, nc.getStepCount());
+    }
+
+    if(recorder)
+    {
+        nc.setRecorder(nullptr);
+        recorder->endEpisode();
+        this->getSubject()->setTraceRank(-1);
+    }
 
     b2Vec2 pos = car->getPos();
     b2Vec2 initPos = car->getInitPos();
 
+    // The car stays where it died until the end of the budget
+    std::size_t const nsampled = std::min<std::size_t>(m_behavior.size(), 2 * nsamples);
+    m_behavior.resize(2 * nsamples);
+    for(auto s = nsampled; s < m_behavior.size(); s += 2)
+    {
+        m_behavior[s] = pos.x;
+        m_behavior[s + 1] = pos.y;
+    }
+    m_behavior.push_back(pos.x);
+    m_behavior.push_back(pos.y);
+
     b2Vec2 destination = this->getSubject()->getDestination();
 
     static auto const distance = [](b2Vec2 const & lhs, b2Vec2 const & rhs)
@@ -159,7 +397,18 @@ SelfDrivingCarDNA::Fitness SelfDrivingCarDNA::computeFitness(std::size_t ngen)
     //Fitness fitness = distance(pos, initPos);
     m_fitness = fitness;
 
-    delete world;
+    // Objectives: the fitness, the part of the step budget survived (a
+    // collision ends the episode early), the steadiness of the controls and
+    // the straightness of the path
+    double const steps = nc.getStepCount();
+    double const decisions = std::max(1u, nc.getDecisionCount());
+    double const path = nc.getPathLength();
+    m_objectives.assign({
+        fitness,
+        maxSteps > 0 ? std::min(1.0, steps / maxSteps) : 0.0,
+        1.0 - nc.getFlagChanges() / decisions,
+        path > 0.0 ? std::min(1.0, distance(pos, initPos) / path) : 0.0
+    });
 
     return fitness;
 }
@@ -167,98 +416,139 @@ SelfDrivingCarDNA::Fitness SelfDrivingCarDNA::computeFitness(std::size_t ngen)
 void SelfDrivingCarDNA::reset()
 {
     // Copy and reset previous car
+    carCounter.allocated();
     m_subject->setCar(m_subject->getCar()->cloneInitial());
 }
 
 SelfDrivingCarDNA::Subject SelfDrivingCarDNA::crossover(SelfDrivingCarDNA const & partner) const
 {
-    using NeuralNetwork = SelfDrivingCar::NeuralNetwork;
-
     assert(m_subject);
 
+    individualCounter.allocated();
     Subject child = createIndividual<NeuroCar::SelfDrivingCar>(*m_subject);
 
-    // Copy and reset previous car
-    child->setCar(m_subject->getCar()->cloneInitial());
+    this->breed(partner, *child);
 
-    static std::random_device rd;
-    static std::default_random_engine rng(rd());
-    std::uniform_real_distribution<double> random(0, 1.0);
+    return child;
+}
 
-    NeuralNetwork const & parentAGenes = m_subject->getNeuralNetwork();
-    NeuralNetwork const & parentBGenes = partner.getSubject()->getNeuralNetwork();
+void SelfDrivingCarDNA::crossoverInto(
+    SelfDrivingCarDNA const & partner, SelfDrivingCarDNA & child
+) const
+{
+    assert(m_subject);
 
-    auto const selectParent = [&parentAGenes, &parentBGenes](float r)
-        -> NeuralNetwork const &
+    // Elites share their subject with the previous generation: only recycle
+    // subjects nobody else refers to
+    Subject & subject = child.m_subject;
+    if(subject && subject.use_count() == 1)
     {
-        return r < 0.5 ? parentAGenes : parentBGenes;
-    };
+        individualCounter.reused();
+        *subject = *m_subject;
+    }
+    else
+    {
+        individualCounter.allocated();
+        subject = createIndividual<NeuroCar::SelfDrivingCar>(*m_subject);
+    }
 
-    auto & childGenes = child->getNeuralNetwork();
+    this->breed(partner, *subject);
+}
+
+void SelfDrivingCarDNA::breed(
+    SelfDrivingCarDNA const & partner, SelfDrivingCar & child
+) const
+{
+    // Copy and reset previous car
+    carCounter.allocated();
+    child.setCar(m_subject->getCar()->cloneInitial());
+
+    // Children are not recorded in place of their parent
+    child.setTraceRank(-1);
+
+    Genome const & parentAGenes = m_subject->getGenome();
+    Genome const & parentBGenes = partner.getSubject()->getGenome();
+    Genome & childGenes = child.editGenome();
+
+    assert(parentAGenes.size() == parentBGenes.size());
+    childGenes.resize(parentAGenes.size());
 
     // Generate new ADN by combining the parents' DNAs
-    auto const & nnshape = parentAGenes.getShape();
-    for(auto l = 0u; l < nnshape.size()-1; ++l)
+    crossoverGenes(
+        parentAGenes.data(), parentBGenes.data(), childGenes.data(),
+        childGenes.size(), RandomStream::local()
+    );
+}
+
+void SelfDrivingCarDNA::mutate(MutationRate mutationRate)
+{
+    auto car = this->getSubject();
+    assert(car);
+
+    Genome & genes = car->editGenome();
+    mutateGenes(genes.data(), genes.size(), mutationRate, 1.0f, RandomStream::local());
+
+    if(m_params.pruneRate > 0.0)
     {
-        auto I = nnshape[l];
-        auto J = nnshape[l+1];
-
-        for(auto j = 0u; j < J; ++j)
-        {
-            for(auto i = 0u; i < I; ++i)
-            {
-                NeuralNetwork const & nn = selectParent(random(rng));
-                childGenes.setWeight(l, i, j, nn.getWeight(l, i, j));
-            }
-
-            NeuralNetwork const & nn = selectParent(random(rng));
-            // j because bias vectors start at layer 1
-            childGenes.setBias(l, j, nn.getBias(l, j));
-        }
+        pruneGenome(car->getNeuralNetwork().getShape(), genes, m_params.pruneRate, RandomStream::local());
     }
-
-    return child;
 }
 
-void SelfDrivingCarDNA::mutate(MutationRate mutationRate)
+float const * SelfDrivingCarDNA::getFeatures(std::size_t & size) const
 {
-    static std::random_device rd;
-    static std::default_random_engine rng(rd());
-    std::uniform_real_distribution<double> lottery(0.0, 1.0);
-    std::uniform_real_distribution<MutationRate> mutation(-1.0, 1.0);
+    Genome const & genes = this->getSubject()->getGenome();
+    size = genes.size();
+    return genes.empty() ? nullptr : genes.data();
+}
 
+bool SelfDrivingCarDNA::setFeatures(float const * features, std::size_t size)
+{
     auto car = this->getSubject();
-    assert(car);
+    if(size != genomeSize(car->getNeuralNetwork().getShape())) return false;
+
+    car->editGenome().assign(features, features + size);
+    return true;
+}
+
+float const * SelfDrivingCarDNA::getBehavior(std::size_t & size) const
+{
+    size = m_behavior.size();
+    return m_behavior.empty() ? nullptr : m_behavior.data();
+}
+
+double const * SelfDrivingCarDNA::getObjectives(std::size_t & size) const
+{
+    size = m_objectives.size();
+    return m_objectives.empty() ? nullptr : m_objectives.data();
+}
 
-    auto & nn = car->getNeuralNetwork();
+void SelfDrivingCarDNA::encodeEvaluation(std::vector<char> & data) const
+{
+    DNA::encodeEvaluation(data);
+    appendValues(data, m_behavior);
+    appendValues(data, m_objectives);
+}
 
-    auto const & nnshape = nn.getShape();
-    for(auto l = 0u; l < nnshape.size()-1; ++l)
+bool SelfDrivingCarDNA::decodeEvaluation(char const * data, std::size_t size)
+{
+    if(!DNA::decodeEvaluation(data, size)) return false;
+
+    m_behavior.clear();
+    m_objectives.clear();
+
+    // The fitness alone: evaluation given up
+    std::size_t offset = sizeof(Fitness);
+    if(offset == size) return true;
+
+    if(!extractValues(data, size, offset, m_behavior) ||
+       !extractValues(data, size, offset, m_objectives) ||
+       offset != size)
     {
-        auto I = nnshape[l];
-        auto J = nnshape[l+1];
-
-        for(auto j = 0u; j < J; ++j)
-        {
-            for(auto i = 0u; i < I; ++i)
-            {
-                MutationRate r = lottery(rng);
-                if(r < mutationRate)
-                {
-                    auto w = nn.getWeight(l, i, j) + mutation(rng);
-                    nn.setWeight(l, i, j, w);
-                }
-            }
-
-            MutationRate r = lottery(rng);
-            if(r < mutationRate)
-            {
-                // j because bias vectors start at layer 1
-                auto b = nn.getBias(l, j) + mutation(rng);
-                nn.setBias(l, j, b);
-            }
-        }
+        return false;
     }
+
+    episodeCounter.fetch_add(1, std::memory_order_relaxed);
+    return true;
 }
 
 }
@@ -1,8 +1,11 @@
 #include <self_driving_car_main.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
 #ifdef _OPENMP
@@ -14,10 +17,20 @@
 #include <io_utils.hpp>
 #include <serialization.hpp>
 
+#include <cpu_dispatch.hpp>
 #include <evolution.hpp>
+#include <evolution_strategies.hpp>
 #include <evolving_string.hpp>
 #include <neuro_controller.hpp>
+#include <population_history.hpp>
+#include <quantized_network.hpp>
+#include <run_status.hpp>
 #include <self_driving_car.hpp>
+#include <sweep.hpp>
+#include <thread_placement.hpp>
+#include <trajectory_recorder.hpp>
+#include <validation.hpp>
+#include <world_factory.hpp>
 
 #include <cmd_options.hpp>
 #include <stats.hpp>
@@ -27,6 +40,58 @@ namespace NeuroCar {
 
 namespace {
 
+using SeedParams = WarmStartParams<Individual<SelfDrivingCar>>;
+
+// Individuals driving with the networks of the comma-separated files, which
+// must have the shape of the networks of the evolution
+bool loadSeeds(
+    std::string const & filenames,
+    CarDef const & carDef,
+    b2Vec2 const & destination,
+    int32_t worldSeed,
+    SeedParams & warmStart
+)
+{
+    static auto const str = [](SelfDrivingCar::NeuralNetwork::Shape const & shape)
+    {
+        std::string text;
+        for(auto n : shape) text += (text.empty() ? "" : "-") + std::to_string(n);
+        return text;
+    };
+
+    SelfDrivingCar::NeuralNetwork::Shape const expected =
+        SelfDrivingCar().getNeuralNetwork().getShape();
+
+    std::stringstream files(filenames);
+    std::string filename;
+    while(std::getline(files, filename, ','))
+    {
+        NeuroEvolution::NeuralNetwork nn;
+        if(!loadFromFile(filename, nn))
+        {
+            std::cout << "Failed to load seed network \"" << filename << "\"" << std::endl;
+            return false;
+        }
+
+        if(nn.getShape() != expected)
+        {
+            std::cout << "Seed network \"" << filename << "\" has shape "
+                      << str(nn.getShape()) << ", expected " << str(expected) << std::endl;
+            return false;
+        }
+
+        auto sdCar = createIndividual<SelfDrivingCar>();
+        sdCar->setNeuroController(NeuroController(nn));
+        sdCar->syncGenome();
+        sdCar->setCar(std::make_shared<Car>(carDef));
+        sdCar->setDestination(destination);
+        sdCar->setWorldSeed(worldSeed);
+        warmStart.seeds.push_back(sdCar);
+    }
+
+    return true;
+}
+
 void carEvolution(
     CarDef const & carDef,
     DNAParams<SelfDrivingCarDNA> const & dnaParams,
@@ -36,37 +101,139 @@ void carEvolution(
     uint32_t elitism,
     std::size_t nindividuals,
     std::size_t ngenerations,
+    RacingParams const & racing,
+    SurrogateParams const & surrogate,
+    MultiFidelityParams const & multiFidelity,
+    NoveltyParams const & novelty,
+    MultiObjectiveParams const & multiObjective,
+    SeedParams const & warmStart,
+    ESParams const & es,
+    WorkerPoolParams const & workers,
+    StopParams const & stop,
+    PopulationControlParams const & populationControl,
+    ThreadPlacementParams const & placement,
+    PipelineParams const & pipeline,
+    std::size_t nrecorded,
+    std::string const & statusName,
+    std::string const & historyName,
     std::string const & filename
 )
 {
-    Population<SelfDrivingCar> cars;
+    // With placement, each car is built on the node of its shard: the static
+    // schedule gives the threads of a node its contiguous share of the cars
+    if(placement.enabled && !pinThreads())
+    {
+        std::cout << "Warning: the threads could not be pinned" << std::endl;
+    }
+
+    Population<SelfDrivingCar> cars(nindividuals);
 
+    #pragma omp parallel for schedule(static) if(placement.enabled)
     for(auto i = 0u; i < nindividuals; ++i)
     {
         auto sdCar = createIndividual<SelfDrivingCar>();
         sdCar->setCar(std::make_shared<Car>(carDef));
         sdCar->setDestination(destination);
         sdCar->setWorldSeed(worldSeed);
-        cars.push_back(sdCar);
+        cars[i] = sdCar;
     }
 
-    static auto const preGenHook = [](
-        std::size_t i, DNAs<SelfDrivingCarDNA> const &
+    // Live status for external readers (status tool)
+    std::unique_ptr<RunStatusWriter> status;
+    if(!statusName.empty())
+    {
+        std::size_t const capacity = genomeSize(cars.front()->getNeuralNetwork().getShape());
+        status.reset(new RunStatusWriter(statusName, capacity));
+        if(!status->isOpen())
+        {
+            std::cout << "Failed to create status segment \""
+                      << statusName << "\"" << std::endl;
+        }
+    }
+
+    // Every individual of every generation, for offline analysis
+    std::shared_ptr<PopulationHistory> history;
+    if(!historyName.empty())
+    {
+        history = std::make_shared<PopulationHistory>(historyName);
+        if(!history->isOpen())
+        {
+            std::cout << "Failed to open history file \""
+                      << historyName << "\"" << std::endl;
+            history.reset();
+        }
+    }
+
+    // Wall time and episodes of the current generation
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point generationStart = Clock::now();
+    uint64_t generationEpisodes = 0;
+
+    auto const preGenHook = [&status, &generationStart, &generationEpisodes, nrecorded](
+        std::size_t i, DNAs<SelfDrivingCarDNA> const & dnas
     )
     {
         std::cout << "Generation " << i << std::endl;
+
+        generationStart = Clock::now();
+        generationEpisodes = getEpisodeCount();
+
+        if(status) status->publish(i, getEpisodeCount());
+
+        // Record the episodes of the best individuals of the last generation:
+        // the elites, first of the generation in the order of the engine (the
+        // mean with evolution strategies). nrecorded is at most their number.
+        if(i > 0)
+        {
+            std::size_t const n = std::min(nrecorded, dnas.size());
+            for(auto r = 0u; r < n; ++r)
+            {
+                dnas[r].getSubject()->setTraceRank(int32_t(r));
+            }
+        }
     };
 
 
     Stats stats("stats.csv", 10);
 
-    auto const saveToFileHook = [&filename, &stats](
+    SelfDrivingCarPoolStats poolStats = getPoolStats();
+
+    std::shared_ptr<EpisodeCurriculum> const curriculum = dnaParams.curriculum;
+    bool const pruning = dnaParams.pruneRate > 0.0;
+    bool const pareto = multiObjective.enabled;
+
+    auto const saveToFileHook = [
+        &filename, &stats, &poolStats, &status,
+        &generationStart, &generationEpisodes, curriculum, pruning, pareto
+    ](
         std::size_t i, DNAs<SelfDrivingCarDNA> const & dnas
     )
     {
         // Save stats to files
         stats(i, dnas);
 
+        double const seconds = std::chrono::duration<double>(
+            Clock::now() - generationStart
+        ).count();
+        uint64_t const episodes = getEpisodeCount() - generationEpisodes;
+        std::cout << "Generation time: " << seconds << " s, " << episodes
+                  << " episodes (" << episodes / std::max(seconds, 1e-9)
+                  << " episodes/s)" << std::endl;
+
+        // Allocations done during this generation
+        SelfDrivingCarPoolStats const current = getPoolStats();
+        PoolCounts const individuals = current.individuals - poolStats.individuals;
+        PoolCounts const worlds = current.worlds - poolStats.worlds;
+        PoolCounts const cars = current.cars - poolStats.cars;
+        poolStats = current;
+
+        std::cout << "Allocations: "
+                  << individuals.allocations << " individuals ("
+                  << individuals.reuses << " recycled), "
+                  << worlds.allocations << " worlds ("
+                  << worlds.reuses << " cached layouts), "
+                  << cars.allocations << " cars" << std::endl;
+
         auto const & bestDNA = *std::max_element(dnas.begin(), dnas.end(),
             [](SelfDrivingCarDNA const & lhs, SelfDrivingCarDNA const & rhs)
             {
@@ -76,7 +243,33 @@ void carEvolution(
 
         std::cout << "Best DNA fitness: " << bestDNA.getFitness() << std::endl;
 
+        if(curriculum)
+        {
+            curriculum->update(i, bestDNA.getFitness());
+
+            CurriculumStats const cs = curriculum->getStats();
+            std::cout << "Curriculum: episode length " << curriculum->getEpisodeLength(i)
+                      << " -> " << curriculum->getEpisodeLength(i + 1) << ", "
+                      << cs.fixedSteps - cs.budgetSteps << " steps of budget saved ("
+                      << 100.0 * (cs.fixedSteps - cs.budgetSteps) / std::max<uint64_t>(cs.fixedSteps, 1)
+                      << "% of fixed-length runs), " << cs.simulatedSteps
+                      << " steps simulated" << std::endl;
+        }
+
         auto car = bestDNA.getSubject();
+
+        if(pruning)
+        {
+            std::cout << "Best DNA sparsity: "
+                      << 100.0 * genomeSparsity(car->getNeuralNetwork().getShape(), car->getGenome())
+                      << "% of the connections pruned" << std::endl;
+        }
+
+        if(status)
+        {
+            status->publish(i, getEpisodeCount(), bestDNA.getFitness(), car->getGenome());
+        }
+
         NeuroController const & nc = car->getNeuroController();
         SelfDrivingCar::NeuralNetwork const & nn = nc.getNeuralNetwork();
 
@@ -86,6 +279,96 @@ void carEvolution(
 
         std::cout << "Saving to \"" << filename << "\"" << std::endl;
         NeuroEvolution::saveToFile(nn, filename);
+
+        if(pareto) dumpParetoFront("pareto_front.csv", dnas);
+    };
+
+    static auto const racingHook = [](std::size_t, RacingReport const & report)
+    {
+        std::cout << "Racing: " << report.frozen << " frozen, "
+                  << 100.0 * report.budgetSaved << "% of the budget saved"
+                  << std::endl;
+
+        if(report.audited)
+        {
+            std::cout << "Racing audit: rank correlation "
+                      << report.rankCorrelation << ", mean rank displacement "
+                      << report.meanRankDisplacement << std::endl;
+        }
+    };
+
+    static auto const surrogateHook = [](std::size_t, SurrogateReport const & report)
+    {
+        if(!report.active)
+        {
+            std::cout << "Surrogate: warming up, " << report.samples << " samples" << std::endl;
+            return;
+        }
+
+        std::cout << "Surrogate: " << report.screened << " screened ("
+                  << report.audited << " audited), "
+                  << 100.0 * report.budgetSaved << "% of the budget saved, rank correlation "
+                  << report.rankCorrelation << ", audit misses "
+                  << 100.0 * report.auditMissRate << "%" << std::endl;
+    };
+
+    static auto const multiFidelityHook = [](std::size_t, MultiFidelityReport const & report)
+    {
+        if(!report.coarse)
+        {
+            std::cout << "Multi-fidelity: full fidelity (fallback)" << std::endl;
+            return;
+        }
+
+        std::cout << "Multi-fidelity: " << report.contenders << " contenders ("
+                  << report.audited << " audited) at full fidelity, rank correlation "
+                  << report.rankCorrelation << std::endl;
+
+        if(report.fallback)
+        {
+            std::cout << "Multi-fidelity: tiers disagree, falling back to full fidelity" << std::endl;
+        }
+    };
+
+    static auto const noveltyHook = [](std::size_t, NoveltyReport const & report)
+    {
+        std::cout << "Novelty: mean " << report.meanNovelty << ", max " << report.maxNovelty
+                  << ", archive " << report.archiveSize << " (+" << report.archived << ")"
+                  << std::endl;
+    };
+
+    static auto const multiObjectiveHook = [](std::size_t, MultiObjectiveReport const & report)
+    {
+        std::cout << "Pareto: " << report.fronts << " fronts of " << report.objectives
+                  << " objectives, front size " << report.paretoSize << std::endl;
+    };
+
+    auto const stopHook = [&stats](std::size_t i, StopReason reason)
+    {
+        std::string const text = std::string("Stopped after generation ") + std::to_string(i)
+            + ": " + stopReasonName(reason);
+        std::cout << text << std::endl;
+        stats.note(text);
+    };
+
+    static auto const populationHook = [](std::size_t, PopulationReport const & report)
+    {
+        std::cout << "Population: " << report.size << " -> " << report.nextSize
+                  << " individuals (threads " << 100.0 * report.utilization << "% busy, "
+                  << report.evaluationsPerSecond << " evaluations/s)" << std::endl;
+    };
+
+    static auto const workersHook = [](std::size_t, WorkerPoolReport const & report)
+    {
+        std::cout << "Workers: " << report.jobs << " episodes in " << report.batches
+                  << " batches, " << report.restarts << " restarts ("
+                  << report.timeouts << " timed out), " << report.retries << " retries, " << report.failures << " failed" << std::endl;
+    };
+
+    static auto const pipelineHook = [](std::size_t, PipelineReport const & report)
+    {
+        std::cout << "Pipeline: " << report.speculative << " children bred early from "
+                  << report.ranked << " evaluated, tail " << report.tailSeconds << " s" << std::endl;
     };
 
     EvolutionParams<SelfDrivingCarDNA> params;
@@ -94,6 +377,27 @@ void carEvolution(
     params.preGenHook   = preGenHook;
     params.postGenHook  = saveToFileHook;
     params.dnaParams    = dnaParams;
+    params.racing       = racing;
+    params.racingHook   = racingHook;
+    params.surrogate     = surrogate;
+    params.surrogateHook = surrogateHook;
+    params.multiFidelity     = multiFidelity;
+    params.multiFidelityHook = multiFidelityHook;
+    params.novelty       = novelty;
+    params.noveltyHook   = noveltyHook;
+    params.multiObjective     = multiObjective;
+    params.multiObjectiveHook = multiObjectiveHook;
+    params.warmStart     = warmStart;
+    params.workers       = workers;
+    params.workersHook   = workersHook;
+    params.history       = history;
+    params.stop          = stop;
+    params.stopHook      = stopHook;
+    params.populationControl = populationControl;
+    params.populationHook    = populationHook;
+    params.placement     = placement;
+    params.pipeline      = pipeline;
+    params.pipelineHook  = pipelineHook;
 
     static auto const p = [](b2Vec2 const & v)
     {
@@ -101,18 +405,107 @@ void carEvolution(
     };
 
     std::cout << "### NeuroCar Evolution ###" << std::endl;
+    std::cout << "  Engine:                ";
+    if(es.enabled)
+    {
+        std::cout << "evolution strategies (sigma " << es.sigma
+                  << ", learning rate " << es.learningRate << ")" << std::endl;
+    }
+    else std::cout << "genetic algorithm" << std::endl;
     std::cout << "  Number of individuals: " << nindividuals                      << std::endl;
     std::cout << "  Number of generations: " << ngenerations                      << std::endl;
+    std::cout << "  Stop criteria:         ";
+    if(stop.deadline > 0.0) std::cout << "deadline " << stop.deadline << " s, ";
+    if(stop.targetFitness < std::numeric_limits<double>::infinity())
+    {
+        std::cout << "target fitness " << stop.targetFitness << ", ";
+    }
+    if(stop.plateau > 0) std::cout << "plateau of " << stop.plateau << " generations, ";
+    std::cout << ngenerations << " generations" << std::endl;
+    std::cout << "  Population size:       ";
+    if(populationControl.enabled)
+    {
+        std::cout << "adaptive, from " << nindividuals << " (x" << populationControl.factor
+                  << " steps)" << std::endl;
+    }
+    else std::cout << "fixed" << std::endl;
     std::cout << "  Mutation rate:         " << mutationRate                      << std::endl;
     std::cout << "  Elitism:               " << elitism                           << std::endl;
     std::cout << "  World seed:            " << worldSeed                         << std::endl;
     std::cout << "  World change interval: " << dnaParams.worldSeedChangeInterval << std::endl;
+    std::cout << "  Episode length:        " << dnaParams.episodeLength           << std::endl;
+    std::cout << "  Control period:        " << dnaParams.controlPeriod << " steps ("
+              << double(dnaParams.worldSimulationRate) / dnaParams.controlPeriod
+              << " decisions per simulated second)" << std::endl;
+    std::cout << "  Curriculum:            " << (curriculum ? "on" : "off")       << std::endl;
+    std::cout << "  Prune rate:            " << dnaParams.pruneRate               << std::endl;
+    std::cout << "  Inference:             " << (dnaParams.sparseInference ? "sparse" : "dense") << std::endl;
+    std::cout << "  Racing:                " << (racing.enabled ? "on" : "off")   << std::endl;
+    std::cout << "  Surrogate:             ";
+    if(surrogate.enabled)
+    {
+        std::cout << "screen below quantile " << surrogate.screenQuantile
+                  << ", audit " << surrogate.auditFraction
+                  << ", budget " << surrogate.screenBudget << std::endl;
+    }
+    else std::cout << "off" << std::endl;
+    std::cout << "  Warm start:            ";
+    if(!warmStart.seeds.empty())
+    {
+        std::cout << warmStart.seeds.size() << " seed networks, "
+                  << warmStart.mutatedFraction << " of the others mutated copies (rate "
+                  << warmStart.mutationRate << ")" << std::endl;
+    }
+    else std::cout << "off" << std::endl;
+    std::cout << "  Multi-fidelity:        ";
+    if(multiFidelity.enabled)
+    {
+        std::cout << "coarse " << dnaParams.coarseSimulationRate << " steps/s, best "
+                  << multiFidelity.contenderFraction << " at full fidelity, fallback below "
+                  << multiFidelity.minAgreement << " rank correlation" << std::endl;
+    }
+    else std::cout << "off" << std::endl;
+    std::cout << "  Novelty search:        ";
+    if(novelty.enabled)
+    {
+        std::cout << "weight " << novelty.weight << ", "
+                  << dnaParams.behaviorSamples << " sampled positions" << std::endl;
+    }
+    else std::cout << "off" << std::endl;
+    std::cout << "  Multi-objective:       " << (multiObjective.enabled ?
+        "fitness, survival, steadiness, straightness" : "off") << std::endl;
+    std::cout << "  Evaluation:            ";
+    if(workers.enabled)
+    {
+        std::cout << "worker processes ("
+                  << (workers.nworkers > 0 ? std::to_string(workers.nworkers) : "one per thread")
+                  << "), batches of " << workers.batchSize << std::endl;
+    }
+    else std::cout << "threads" << std::endl;
+    std::cout << "  Thread placement:      ";
+    if(placement.enabled)
+    {
+        std::cout << "pinned, " << numaTopology().nodes.size() << " NUMA shard"
+                  << (numaTopology().nodes.size() > 1 ? "s" : "") << std::endl;
+    }
+    else std::cout << "off" << std::endl;
+    std::cout << "  Pipeline:              ";
+    if(pipeline.enabled)
+    {
+        std::cout << "breed up to " << pipeline.speculativeFraction << " of the children once "
+                  << pipeline.minRanked << " of the generation is evaluated" << std::endl;
+    }
+    else std::cout << "off" << std::endl;
+    std::cout << "  Recorded individuals:  " << nrecorded                         << std::endl;
+    std::cout << "  Status segment:        " << (statusName.empty() ? "-" : statusName) << std::endl;
+    std::cout << "  History file:          " << (history ? historyName : "-") << std::endl;
     std::cout << "  Starting point:        " << p(carDef.initPos)                 << std::endl;
     std::cout << "  Destination:           " << p(destination)                    << std::endl;
     std::cout << "  Output filename:       " << filename                          << std::endl;
     std::cout << std::endl;
 
-    evolve<SelfDrivingCarDNA>(cars, ngenerations, params);
+    if(es.enabled) evolveES<SelfDrivingCarDNA>(cars, ngenerations, params, es);
+    else evolve<SelfDrivingCarDNA>(cars, ngenerations, params);
 }
 
 void replayBest(
@@ -120,7 +513,8 @@ void replayBest(
     DNAParams<SelfDrivingCarDNA> const & dnaParams,
     b2Vec2 const & destination,
     int32_t worldSeed,
-    std::string const & filename
+    std::string const & filename,
+    std::string const & qfilename
 )
 {
     NeuroEvolution::NeuralNetwork nn;
@@ -141,10 +535,542 @@ void replayBest(
     sdCar->setDestination(destination);
     sdCar->setWorldSeed(worldSeed);
 
+    // Drive with the quantized network, the float one only serves as reference
+    NeuroController & nc = sdCar->getNeuroController();
+    if(!qfilename.empty())
+    {
+        auto qnn = std::make_shared<QuantizedNetwork>();
+        if(!loadFromFile(qfilename, *qnn))
+        {
+            std::cout << "Failed to reload quantized nn from file \""
+                      << qfilename << "\"" << std::endl;
+            return;
+        }
+
+        nc.setQuantizedNetwork(qnn);
+        nc.setInference(NeuroController::Inference::Quantized);
+        nc.setCompareFlags(true);
+    }
+
     SelfDrivingCarDNA dna(sdCar);
     dna.init(dnaParams);
     auto fitness = dna.computeFitness();
     std::cout << "Fitness = " << fitness << std::endl;
+
+    if(!qfilename.empty())
+    {
+        std::cout << "Flag disagreements = " << nc.getFlagDisagreements()
+                  << " / " << nc.getComparedSteps() << " steps" << std::endl;
+    }
+}
+
+void quantizeBest(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    int32_t worldSeed,
+    uint32_t ncalibrationSeeds,
+    std::string const & filename,
+    std::string const & qfilename
+)
+{
+    NeuroEvolution::NeuralNetwork nn;
+
+    if(!loadFromFile(filename, nn))
+    {
+        std::cout << "Failed to reload nn from file \""
+                  << filename << "\"" << std::endl;
+        return;
+    }
+
+    std::cout << "### NeuroCar Quantization ###" << std::endl;
+    std::cout << "  Calibration seeds:     " << ncalibrationSeeds << std::endl;
+
+    // Record the sensor inputs seen while driving with the float network
+    std::vector<NeuroEvolution::Weight> inputs;
+    for(auto i = 0u; i < ncalibrationSeeds; ++i)
+    {
+        auto sdCar = createIndividual<SelfDrivingCar>();
+        sdCar->setNeuroController(NeuroController(nn));
+        sdCar->setCar(std::make_shared<Car>(carDef));
+        sdCar->setDestination(destination);
+        sdCar->setWorldSeed(worldSeed + i);
+        sdCar->getNeuroController().setInputLog(&inputs);
+
+        SelfDrivingCarDNA dna(sdCar);
+        dna.init(dnaParams);
+        dna.computeFitness();
+    }
+
+    QuantizedNetwork const qnn = QuantizedNetwork::quantize(nn, inputs);
+
+    // Compare the decisions of both networks on the recorded inputs
+    std::size_t const ninputs = nn.getShape()[0];
+    std::size_t const nsamples = inputs.size() / ninputs;
+    std::size_t disagreements = 0;
+    for(auto s = 0u; s < nsamples; ++s)
+    {
+        auto const first = inputs.begin() + s * ninputs;
+        std::vector<NeuroEvolution::Weight> const sample(first, first + ninputs);
+        auto const outputs = nn.compute(sample);
+
+        uint32_t floatBits = 0;
+        for(auto j = 0u; j < outputs.size(); ++j)
+        {
+            if(outputs[j] > 0.5) floatBits |= 1u << j;
+        }
+
+        if(floatBits != qnn.computeFlags(sample.data())) ++disagreements;
+    }
+
+    std::cout << "  Calibration steps:     " << nsamples << std::endl;
+    std::cout << "  Flag disagreements:    " << disagreements << " ("
+              << (nsamples > 0 ? 100.0 * disagreements / nsamples : 0.0)
+              << "%)" << std::endl;
+    std::cout << "  Quantized size:        " << qnn.byteSize() << " bytes" << std::endl;
+
+    if(!saveToFile(qnn, qfilename))
+    {
+        std::cout << "Failed to save quantized nn to file \""
+                  << qfilename << "\"" << std::endl;
+        return;
+    }
+
+    std::cout << "Saving to \"" << qfilename << "\"" << std::endl;
+}
+
+void validation(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    ValidationParams const & params
+)
+{
+    std::cout << "### NeuroCar Validation ###" << std::endl;
+    std::cout << "  Networks:              " << params.networkFiles.size() << std::endl;
+    std::cout << "  Seeds:                 [" << params.firstSeed << ", "
+              << params.firstSeed + int64_t(params.nseeds) << "[" << std::endl;
+    std::cout << "  Success fitness:       " << params.successFitness << std::endl;
+    std::cout << "  Control periods:       ";
+    if(params.controlPeriods.empty()) std::cout << dnaParams.controlPeriod;
+    for(auto i = 0u; i < params.controlPeriods.size(); ++i)
+    {
+        std::cout << (i > 0 ? ", " : "") << params.controlPeriods[i];
+    }
+    std::cout << std::endl;
+    std::cout << std::endl;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    auto const results = validateNetworks(carDef, dnaParams, destination, params);
+
+    double const elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    std::fstream csv("validation.csv", std::ios::out | std::ios::trunc);
+    csv << "Network, Control period, Quantized, Sparse, Episodes, Success rate, Mean, Stddev, Min, "
+        << "P10, Median, P90, Max, Time (s)" << std::endl;
+
+    std::size_t episodes = 0;
+    for(auto const & r : results)
+    {
+        if(!r.loaded)
+        {
+            std::cout << "Failed to load \"" << r.filename << "\"" << std::endl;
+            continue;
+        }
+
+        double const successRate = r.episodes > 0 ?
+            static_cast<double>(r.successes) / r.episodes : 0.0;
+
+        std::cout << r.filename << " (control period " << r.controlPeriod
+                  << ", " << (r.quantized ? "quantized" : r.sparse ? "sparse" : "dense")
+                  << ")" << std::endl
+                  << "  success " << 100.0 * successRate << "%"
+                  << ", fitness " << r.mean << " +/- " << r.stddev
+                  << " [min " << r.min << ", p10 " << r.p10
+                  << ", median " << r.median << ", p90 " << r.p90
+                  << ", max " << r.max << "]"
+                  << ", " << 1000.0 * r.seconds / std::max<std::size_t>(r.episodes, 1)
+                  << " ms/episode" << std::endl;
+
+        csv << r.filename << ", " << r.controlPeriod << ", " << r.quantized << ", " << r.sparse << ", " << r.episodes << ", " << successRate << ", "
+            << r.mean << ", " << r.stddev << ", " << r.min << ", " << r.p10 << ", "
+            << r.median << ", " << r.p90 << ", " << r.max << ", " << r.seconds
+            << std::endl;
+
+        episodes += r.episodes;
+    }
+
+    std::cout << std::endl << episodes << " episodes in " << elapsed << " s ("
+              << episodes / std::max(elapsed, 1e-9) << " episodes/s)" << std::endl;
+}
+
+void sweep(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    SweepParams params
+)
+{
+    std::cout << "### NeuroCar Sweep ###" << std::endl;
+    std::cout << "  Experiments:           " << params.experiments.size() << std::endl;
+    std::cout << "  Threads:               " << params.nthreads << std::endl;
+    std::cout << "  Policy:                "
+              << (params.policy == SweepPolicy::Priority ? "priority" : "fair share") << std::endl;
+    std::cout << "  Output directory:      " << params.outputDirectory << std::endl;
+    std::cout << std::endl;
+
+    params.generationHook = [](
+        ExperimentConfig const & config, std::size_t i, double bestFitness, uint32_t nthreads
+    )
+    {
+        std::cout << "[" << config.name << "] Generation " << i << ": best fitness "
+                  << bestFitness << " (" << nthreads << " thread"
+                  << (nthreads > 1 ? "s" : "") << ")" << std::endl;
+    };
+
+    auto const start = std::chrono::steady_clock::now();
+
+    auto const results = runSweep(carDef, dnaParams, destination, params);
+
+    double const elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    std::fstream csv(params.outputDirectory + "/sweep.csv", std::ios::out | std::ios::trunc);
+    csv << "Experiment, Mutation rate, Elitism, Individuals, Generations, "
+        << "World change interval, Priority, Best fitness, Evaluations, Time (s)" << std::endl;
+
+    std::cout << std::endl;
+    std::size_t evaluations = 0;
+    for(auto e = 0u; e < results.size(); ++e)
+    {
+        ExperimentConfig const & c = params.experiments[e];
+        ExperimentResult const & r = results[e];
+
+        std::cout << r.name << ": best fitness " << r.bestFitness << " after "
+                  << r.generations << " generations, " << r.seconds << " s" << std::endl;
+
+        csv << r.name << ", " << c.mutationRate << ", " << c.elitism << ", "
+            << c.nindividuals << ", " << r.generations << ", " << c.worldSeedChangeInterval
+            << ", " << c.priority << ", " << r.bestFitness << ", " << r.evaluations
+            << ", " << r.seconds << std::endl;
+
+        evaluations += r.evaluations;
+    }
+
+    std::cout << std::endl << evaluations << " evaluations in " << elapsed << " s ("
+              << evaluations / std::max(elapsed, 1e-9) << " evaluations/s)" << std::endl;
+}
+
+// Same experiments as independent processes on the same threads, then as one
+// sweep. The processes run first: a process cannot fork safely once its
+// OpenMP threads exist.
+void sweepBenchmark(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    SweepParams const & params
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::cout << "### NeuroCar Sweep Benchmark ###" << std::endl;
+    std::cout << "  Experiments:           " << params.experiments.size() << std::endl;
+    std::cout << "  Threads:               " << params.nthreads << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Mode, Evaluations, Time (s), Evaluations/s, Speedup, Best fitness"
+              << std::endl;
+
+    double reference = -1.0;
+    for(int mode = 0; mode < 2; ++mode)
+    {
+        Clock::time_point const start = Clock::now();
+
+        std::vector<ExperimentResult> const results = mode == 0 ?
+            runSweepProcesses(carDef, dnaParams, destination, params) :
+            runSweep(carDef, dnaParams, destination, params);
+
+        double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::size_t evaluations = 0;
+        double best = 0.0;
+        for(auto const & r : results)
+        {
+            evaluations += r.evaluations;
+            best = std::max(best, r.bestFitness);
+        }
+
+        double const throughput = evaluations / std::max(seconds, 1e-9);
+        if(reference < 0.0) reference = throughput;
+
+        std::cout << (mode == 0 ? "processes" : "sweep") << ", " << evaluations << ", "
+                  << seconds << ", " << throughput << ", "
+                  << throughput / std::max(reference, 1e-9) << ", " << best << std::endl;
+    }
+}
+
+// Wall time of the genetic algorithm and of the evolution strategies to reach
+// the target fitness, both from the same random networks and worlds
+void engineBenchmark(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    int32_t worldSeed,
+    double mutationRate,
+    uint32_t elitism,
+    std::size_t nindividuals,
+    std::size_t ngenerations,
+    ESParams const & es,
+    double target
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::cout << "### NeuroCar Engine Benchmark ###" << std::endl;
+    std::cout << "  Number of individuals: " << nindividuals << std::endl;
+    std::cout << "  Number of generations: " << ngenerations << std::endl;
+    std::cout << "  Target fitness:        " << target       << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Engine, Generations to target, Episodes to target, Time to target (s), "
+              << "Best fitness, Total time (s)" << std::endl;
+
+    for(int engine = 0; engine < 2; ++engine)
+    {
+        Population<SelfDrivingCar> cars;
+        for(auto i = 0u; i < nindividuals; ++i)
+        {
+            auto sdCar = createIndividual<SelfDrivingCar>();
+            sdCar->setCar(std::make_shared<Car>(carDef));
+            sdCar->setDestination(destination);
+            sdCar->setWorldSeed(worldSeed);
+            cars.push_back(sdCar);
+        }
+
+        Clock::time_point const start = Clock::now();
+        uint64_t const startEpisodes = getEpisodeCount();
+
+        // First generation reaching the target (ngenerations: never)
+        std::size_t reached = ngenerations;
+        double reachedTime = 0.0;
+        uint64_t reachedEpisodes = 0;
+        double best = 0.0;
+
+        EvolutionParams<SelfDrivingCarDNA> params;
+        params.mutationRate = mutationRate;
+        params.elitism      = elitism;
+        params.dnaParams    = dnaParams;
+        params.postGenHook  = [&](std::size_t i, DNAs<SelfDrivingCarDNA> const & dnas)
+        {
+            for(auto const & dna : dnas) best = std::max(best, dna.getFitness());
+
+            if(reached == ngenerations && best >= target)
+            {
+                reached = i;
+                reachedTime = std::chrono::duration<double>(Clock::now() - start).count();
+                reachedEpisodes = getEpisodeCount() - startEpisodes;
+            }
+        };
+
+        if(engine == 0) evolve<SelfDrivingCarDNA>(cars, ngenerations, params);
+        else evolveES<SelfDrivingCarDNA>(cars, ngenerations, params, es);
+
+        double const total = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::cout << (engine == 0 ? "GA" : "ES") << ", ";
+        if(reached < ngenerations)
+        {
+            std::cout << reached + 1 << ", " << reachedEpisodes << ", " << reachedTime;
+        }
+        else std::cout << "-, -, -";
+        std::cout << ", " << best << ", " << total << std::endl;
+    }
+}
+
+// Same evolution with the evaluations in the threads, then in the workers
+void workersBenchmark(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    int32_t worldSeed,
+    double mutationRate,
+    uint32_t elitism,
+    std::size_t nindividuals,
+    std::size_t ngenerations,
+    WorkerPoolParams workers
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::cout << "### NeuroCar Workers Benchmark ###" << std::endl;
+    std::cout << "  Number of individuals: " << nindividuals << std::endl;
+    std::cout << "  Number of generations: " << ngenerations << std::endl;
+    std::cout << "  Batch size:            " << workers.batchSize << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Evaluation, Episodes, Time (s), Episodes/s, Restarts, Failures, Best fitness"
+              << std::endl;
+
+    for(int mode = 0; mode < 2; ++mode)
+    {
+        Population<SelfDrivingCar> cars;
+        for(auto i = 0u; i < nindividuals; ++i)
+        {
+            auto sdCar = createIndividual<SelfDrivingCar>();
+            sdCar->setCar(std::make_shared<Car>(carDef));
+            sdCar->setDestination(destination);
+            sdCar->setWorldSeed(worldSeed);
+            cars.push_back(sdCar);
+        }
+
+        std::size_t restarts = 0;
+        std::size_t failures = 0;
+
+        workers.enabled = mode == 1;
+
+        EvolutionParams<SelfDrivingCarDNA> params;
+        params.mutationRate = mutationRate;
+        params.elitism      = elitism;
+        params.dnaParams    = dnaParams;
+        params.workers      = workers;
+        params.workersHook  = [&](std::size_t, WorkerPoolReport const & report)
+        {
+            restarts += report.restarts;
+            failures += report.failures;
+        };
+
+        Clock::time_point const start = Clock::now();
+        uint64_t const startEpisodes = getEpisodeCount();
+
+        DNAs<SelfDrivingCarDNA> const dnas = evolve<SelfDrivingCarDNA>(cars, ngenerations, params);
+
+        double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        uint64_t const episodes = getEpisodeCount() - startEpisodes;
+
+        std::cout << (mode == 0 ? "threads" : "workers") << ", " << episodes << ", "
+                  << seconds << ", " << episodes / std::max(seconds, 1e-9) << ", "
+                  << restarts << ", " << failures << ", " << dnas.back().getFitness() << std::endl;
+    }
+}
+
+// Episode throughput of the same evolution on 1, 2, 4... threads, with the
+// threads free then pinned with per-node shards
+void scalingBenchmark(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    int32_t worldSeed,
+    double mutationRate,
+    uint32_t elitism,
+    std::size_t nindividuals,
+    std::size_t ngenerations,
+    std::size_t maxThreads
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t const nnodes = numaTopology().nodes.size();
+
+    std::cout << "### NeuroCar Scaling Benchmark ###" << std::endl;
+    std::cout << "  Number of individuals: " << nindividuals << std::endl;
+    std::cout << "  Number of generations: " << ngenerations << std::endl;
+    std::cout << "  NUMA nodes:            " << nnodes       << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "Threads, Placement, Episodes, Time (s), Episodes/s, Speedup, Best fitness"
+              << std::endl;
+
+    // Reference: a single free thread
+    double reference = -1.0;
+
+    std::vector<std::size_t> counts;
+    for(std::size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+    counts.push_back(maxThreads);
+
+    for(auto nthreads : counts)
+    {
+        #ifdef _OPENMP
+        omp_set_num_threads(static_cast<int>(nthreads));
+        #endif
+
+        for(int mode = 0; mode < 2; ++mode)
+        {
+            ThreadPlacementParams placement;
+            placement.enabled = mode == 1;
+            if(placement.enabled) pinThreads();
+            else unpinThreads();
+
+            Population<SelfDrivingCar> cars(nindividuals);
+
+            #pragma omp parallel for schedule(static) if(placement.enabled)
+            for(auto i = 0u; i < nindividuals; ++i)
+            {
+                auto sdCar = createIndividual<SelfDrivingCar>();
+                sdCar->setCar(std::make_shared<Car>(carDef));
+                sdCar->setDestination(destination);
+                sdCar->setWorldSeed(worldSeed);
+                cars[i] = sdCar;
+            }
+
+            EvolutionParams<SelfDrivingCarDNA> params;
+            params.mutationRate = mutationRate;
+            params.elitism      = elitism;
+            params.dnaParams    = dnaParams;
+            params.placement    = placement;
+
+            Clock::time_point const start = Clock::now();
+            uint64_t const startEpisodes = getEpisodeCount();
+
+            DNAs<SelfDrivingCarDNA> const dnas = evolve<SelfDrivingCarDNA>(cars, ngenerations, params);
+
+            double const seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            uint64_t const episodes = getEpisodeCount() - startEpisodes;
+            double const throughput = episodes / std::max(seconds, 1e-9);
+            if(reference < 0.0) reference = throughput;
+
+            std::cout << nthreads << ", " << (placement.enabled ? "numa" : "free") << ", "
+                      << episodes << ", " << seconds << ", " << throughput << ", "
+                      << throughput / std::max(reference, 1e-9) << ", "
+                      << dnas.back().getFitness() << std::endl;
+        }
+    }
+
+    unpinThreads();
+}
+
+// "--max-threads" and "-t" options
+int32_t setNumThreads(int argc, char ** argv)
+{
+    int32_t nthreads = 1;
+
+    // "--max-threads" option: use maximum number of threads?
+    if(cmdOptionExists(argc, argv, "--max-threads"))
+    {
+        #ifdef _OPENMP
+        nthreads = omp_get_max_threads();
+        #endif
+    }
+
+    // "-t" option: number of threads to use
+    int nt = 0;
+    if(getCmdOption(argc, argv, "-t", nt)) nthreads = nt;
+
+    #ifdef _OPENMP
+    omp_set_num_threads(nthreads);
+    #endif
+
+    std::cout << "Running " << nthreads << " thread"
+              << (nthreads > 1 ? "s" : "") << std::endl;
+
+    std::cout << "Kernels: " << isaName(activeIsa());
+    if(isaOverridden()) std::cout << " (NEURO_CAR_ISA, CPU supports " << isaName(detectIsa()) << ")";
+    std::cout << std::endl;
+
+    return nthreads;
 }
 
 }
@@ -159,7 +1085,37 @@ void selfDrivingCarMain(int argc, char ** argv)
         std::cout << usage << exe
                   << " [-h] [-r] [--max-threads] [-t T] [-m M] [-e E]" << std::endl
                   << std::string(usage.size() + exe.size(), ' ')
-                  << " [-i I] [-g G] [-s S] [-c C] [-f F]"
+                  << " [-i I] [-g G] [-s S] [-c C] [-l L] [-k K] [-f F]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--prune P] [--sparse] [--compare-sparse]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--curriculum C] [--curriculum-start F] [--curriculum-ramp G]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--racing] [--racing-audit A] [--quantize] [-q Q] [--calibration-seeds N]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--surrogate] [--surrogate-quantile Q] [--surrogate-audit A] [--surrogate-budget B]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--multi-fidelity] [--fidelity-contenders F] [--fidelity-agreement A] [--coarse-rate R]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--novelty] [--novelty-weight W] [--novelty-samples N] [--multi-objective]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--warm-start F[,F...]] [--warm-mutated P] [--warm-mutation M]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--es] [--es-sigma S] [--es-rate R] [--engine-benchmark] [--target T]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--workers [N]] [--worker-batch B] [--worker-timeout S] [--workers-benchmark]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--deadline S] [--plateau G] [--adaptive-population] [--min-population N] [--max-population N]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--numa] [--scaling-benchmark] [--pipeline]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--record N] [--trace-file T] [--history H] [--status N] [--world-cache D]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--sweep W] [--sweep-policy P] [--sweep-dir D] [--sweep-benchmark]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--string-benchmark]" << std::endl
+                  << std::string(usage.size() + exe.size(), ' ')
+                  << " [--validate] [--nseeds N] [--success S]"
                   << std::endl << std::endl;
 
         std::cout << "Neural network evolution of self driving car with genetic algorithm"
@@ -177,8 +1133,91 @@ void selfDrivingCarMain(int argc, char ** argv)
         std::cout << "  -g G            <G> Number of generations to train"       << std::endl;
         std::cout << "  -s S            <S> World seed"                           << std::endl;
         std::cout << "  -c C            <C> World seed change interval"           << std::endl;
+        std::cout << "  -l L            <L> Episode length in physics steps (0: unlimited)" << std::endl;
+        std::cout << "  -k K            <K> Physics steps between two decisions of the network "
+                  << "(comma-separated list in validation mode)" << std::endl;
+        std::cout << "  --prune P       <P> Probability for a mutation to zero each connection" << std::endl;
+        std::cout << "  --sparse        Drive with the non-zero connections only"  << std::endl;
+        std::cout << "  --compare-sparse Validate each network with dense and sparse inference" << std::endl;
+        std::cout << "  --curriculum C  <C> Grow the episode length up to <L>: linear, step or adaptive" << std::endl;
+        std::cout << "  --curriculum-start F <F> Length of the first episodes, fraction of <L>" << std::endl;
+        std::cout << "  --curriculum-ramp G  <G> Generations to reach <L> (linear and step)"  << std::endl;
+        std::cout << "  --racing        Cull hopeless individuals early (requires -l)"      << std::endl;
+        std::cout << "  --racing-audit A <A> Compare racing with full evaluation every A generations" << std::endl;
+        std::cout << "  --surrogate     Screen the children a fitness model predicts poor (requires -l)" << std::endl;
+        std::cout << "  --surrogate-quantile Q <Q> Fraction of the children screened (default 0.5)" << std::endl;
+        std::cout << "  --surrogate-audit A    <A> Fraction of the screened children fully evaluated anyway" << std::endl;
+        std::cout << "  --surrogate-budget B   <B> Episode fraction of a screening run (default 0.1)" << std::endl;
+        std::cout << "  --multi-fidelity Evaluate everybody with coarse physics, then the best "
+                  << "and the elites again with full physics" << std::endl;
+        std::cout << "  --fidelity-contenders F <F> Fraction of the generation evaluated again "
+                  << "(default 0.2)" << std::endl;
+        std::cout << "  --fidelity-agreement A  <A> Rank correlation of the tiers below which "
+                  << "the evaluation falls back to full physics (default 0.6)" << std::endl;
+        std::cout << "  --coarse-rate R <R> Physics steps per simulated second of the coarse "
+                  << "tier (default 5)" << std::endl;
+        std::cout << "  --novelty       Select on the novelty of the trajectories too" << std::endl;
+        std::cout << "  --novelty-weight W  <W> Weight of the novelty against the fitness (default 0.5, 1: pure novelty)" << std::endl;
+        std::cout << "  --novelty-samples N <N> Positions sampled along the episode besides the final one (requires -l)" << std::endl;
+        std::cout << "  --multi-objective Select on the Pareto fronts of fitness, survival, steadiness "
+                  << "and straightness (front written to pareto_front.csv, requires -l)" << std::endl;
+        std::cout << "  --warm-start F  <F> Start from the saved networks of the comma-separated files" << std::endl;
+        std::cout << "  --warm-mutated P <P> Fraction of the other individuals made of mutated copies "
+                  << "of the seeds, the rest being random (default 0.5)" << std::endl;
+        std::cout << "  --warm-mutation M <M> Mutation rate of the copies (default 0.05)" << std::endl;
+        std::cout << "  --es            Evolve with evolution strategies instead of the genetic algorithm" << std::endl;
+        std::cout << "  --es-sigma S    <S> Standard deviation of the ES perturbations (default 0.05)" << std::endl;
+        std::cout << "  --es-rate R     <R> ES learning rate (default 0.02)" << std::endl;
+        std::cout << "  --engine-benchmark Compare the time of both engines to reach the fitness <T>" << std::endl;
+        std::cout << "  --target T      <T> Stop once the best fitness reaches T "
+                  << "(--engine-benchmark: fitness to reach, default 0.9)" << std::endl;
+        std::cout << "  --deadline S    <S> Wall time budget in seconds: no generation starts "
+                  << "if it would end past it" << std::endl;
+        std::cout << "  --plateau G     <G> Stop after G generations without a better best fitness" << std::endl;
+        std::cout << "  --adaptive-population Grow the population while threads are idle, "
+                  << "shrink it when the fitness stalls" << std::endl;
+        std::cout << "  --min-population N <N> Smallest adaptive population (default <I>/4)" << std::endl;
+        std::cout << "  --max-population N <N> Largest adaptive population (default 4 <I>)" << std::endl;
+        std::cout << "  --workers N     Evaluate in N worker processes, restarted if they crash "
+                  << "(default: one per thread)" << std::endl;
+        std::cout << "  --worker-batch B <B> Episodes per message to a worker (default 4)" << std::endl;
+        std::cout << "  --worker-timeout S <S> Seconds an episode may take before its worker "
+                  << "is replaced (default 300, 0: no limit)" << std::endl;
+        std::cout << "  --workers-benchmark Compare the episode throughput of the threads and of the workers" << std::endl;
+        std::cout << "  --numa          Pin the threads and keep the evaluation and breeding of "
+                  << "each NUMA node's share of the population on that node" << std::endl;
+        std::cout << "  --scaling-benchmark Episode throughput from 1 to the maximum number of "
+                  << "threads, with and without --numa" << std::endl;
+        std::cout << "  --pipeline      Breed part of the next generation while the last "
+                  << "episodes run, save the generation while the rest is bred" << std::endl;
+        std::cout << "  --record N      <N> Record the episodes of the N best individuals of each generation "
+                  << "(at most the elitism)" << std::endl;
+        std::cout << "  --trace-file T  <T> Trajectory file of --record"          << std::endl;
+        std::cout << "  --history H     <H> Log the genomes, fitnesses and parents of every generation "
+                  << "to <H> (index in <H>.idx)" << std::endl;
+        std::cout << "  --status N      <N> Publish the run status in the shared memory segment N "
+                  << "(e.g. /neuro_car)" << std::endl;
         std::cout << "  -f F            <F> Neural network file "
                   << "('to load' in replay mode, 'to save to' in evolution mode)" << std::endl;
+        std::cout << "  --quantize      Quantize the neural network <F> to int8"  << std::endl;
+        std::cout << "  -q Q            <Q> Quantized neural network file "
+                  << "('to save to' in quantize mode, 'to drive with' in replay mode)" << std::endl;
+        std::cout << "  --calibration-seeds N <N> Number of worlds used to calibrate the quantization" << std::endl;
+        std::cout << "  --world-cache D <D> Directory of the valid world seeds shared between runs" << std::endl;
+        std::cout << "  --sweep W       Run the experiments of the sweep file <W> concurrently" << std::endl;
+        std::cout << "  --sweep-policy P <P> Sharing of the threads: fair (default) or priority" << std::endl;
+        std::cout << "  --sweep-dir D   <D> Directory of the sweep stats and networks" << std::endl;
+        std::cout << "  --sweep-benchmark Compare the throughput of the sweep <W> with "
+                  << "one process per experiment" << std::endl;
+        std::cout << "  --string-benchmark Time the evolution engine alone on populations "
+                  << "of 1000 to <I> strings, for <G> generations" << std::endl;
+        std::cout << "  --validate      Score the comma-separated networks <F> on the seeds [S, S+N[" << std::endl;
+        std::cout << "  --nseeds N      <N> Number of validation worlds"          << std::endl;
+        std::cout << "  --success S     <S> Fitness of a successful validation episode" << std::endl;
+
+        std::cout << std::endl << "Environment:" << std::endl;
+        std::cout << "  NEURO_CAR_ISA   Kernel variant to use instead of the best one "
+                  << "of the CPU: generic, avx2 or avx512" << std::endl;
         return;
     }
 
@@ -253,6 +1292,231 @@ void selfDrivingCarMain(int argc, char ** argv)
     int32_t ch = 0;
     if(getCmdOption(argc, argv, "-c", ch)) dnaParams.worldSeedChangeInterval = ch;
 
+    // "-l" option: Episode length
+    uint32_t len = 0;
+    if(getCmdOption(argc, argv, "-l", len)) dnaParams.episodeLength = len;
+
+    // "-k" option: control period(s)
+    std::vector<uint32_t> controlPeriods;
+    char * k = getCmdOption(argc, argv, "-k");
+    if(k)
+    {
+        std::stringstream periods(k);
+        std::string period;
+        while(std::getline(periods, period, ','))
+        {
+            if(!period.empty()) controlPeriods.push_back(std::max(1, std::stoi(period)));
+        }
+        if(!controlPeriods.empty()) dnaParams.controlPeriod = controlPeriods.front();
+    }
+
+    // "--prune" option: connection pruning rate
+    double pr = 0.0;
+    if(getCmdOption(argc, argv, "--prune", pr)) dnaParams.pruneRate = pr;
+
+    // "--sparse" option: sparse inference
+    dnaParams.sparseInference = cmdOptionExists(argc, argv, "--sparse");
+
+    // "--curriculum" option: episode-length schedule
+    char * cu = getCmdOption(argc, argv, "--curriculum");
+    if(cu)
+    {
+        CurriculumParams curriculum;
+        std::string const type = cu;
+        if(type == "step") curriculum.type = CurriculumParams::Type::Step;
+        else if(type == "adaptive") curriculum.type = CurriculumParams::Type::Adaptive;
+
+        // "--curriculum-start" option: first episode length fraction
+        double cs = 0.0;
+        if(getCmdOption(argc, argv, "--curriculum-start", cs)) curriculum.startFraction = cs;
+
+        // "--curriculum-ramp" option: generations to reach the full length
+        std::size_t cr = 0;
+        if(getCmdOption(argc, argv, "--curriculum-ramp", cr)) curriculum.rampGenerations = cr;
+
+        if(dnaParams.episodeLength == 0)
+        {
+            std::cout << "Warning: curriculum without episode length (-l), "
+                      << "every episode runs until the world stops it" << std::endl;
+        }
+        else
+        {
+            dnaParams.curriculum = std::make_shared<EpisodeCurriculum>(
+                curriculum, dnaParams.episodeLength, dnaParams.worldSeedChangeInterval
+            );
+        }
+    }
+
+    // "--racing" option: successive-halving evaluation
+    RacingParams racing;
+    racing.enabled = cmdOptionExists(argc, argv, "--racing");
+
+    // "--racing-audit" option: racing audit interval
+    std::size_t audit = 0;
+    if(getCmdOption(argc, argv, "--racing-audit", audit)) racing.auditInterval = audit;
+
+    // Without an episode length the partial evaluations are full ones: racing
+    // would only repeat them
+    if(racing.enabled && dnaParams.episodeLength == 0)
+    {
+        std::cout << "Warning: racing needs an episode length (-l), --racing ignored" << std::endl;
+        racing.enabled = false;
+    }
+
+    // "--surrogate" option: screening with a fitness model
+    SurrogateParams surrogate;
+    surrogate.enabled = cmdOptionExists(argc, argv, "--surrogate");
+
+    // "--surrogate-quantile", "--surrogate-audit" and "--surrogate-budget" options
+    double sq = 0.0;
+    if(getCmdOption(argc, argv, "--surrogate-quantile", sq)) surrogate.screenQuantile = sq;
+    double sa = 0.0;
+    if(getCmdOption(argc, argv, "--surrogate-audit", sa)) surrogate.auditFraction = sa;
+    double sb = 0.0;
+    if(getCmdOption(argc, argv, "--surrogate-budget", sb)) surrogate.screenBudget = sb;
+
+    if(surrogate.enabled && racing.enabled)
+    {
+        std::cout << "Warning: racing replaces the surrogate screening" << std::endl;
+    }
+    else if(surrogate.enabled && dnaParams.episodeLength == 0)
+    {
+        std::cout << "Warning: surrogate without episode length (-l), "
+                  << "screened individuals get a full evaluation" << std::endl;
+    }
+
+    // "--multi-fidelity" option: coarse physics first, full for the contenders
+    MultiFidelityParams multiFidelity;
+    multiFidelity.enabled = cmdOptionExists(argc, argv, "--multi-fidelity");
+
+    // "--fidelity-contenders", "--fidelity-agreement" and "--coarse-rate" options
+    double fc = 0.0;
+    if(getCmdOption(argc, argv, "--fidelity-contenders", fc)) multiFidelity.contenderFraction = fc;
+    double fa = 0.0;
+    if(getCmdOption(argc, argv, "--fidelity-agreement", fa)) multiFidelity.minAgreement = fa;
+    uint32_t cr = 0;
+    if(getCmdOption(argc, argv, "--coarse-rate", cr)) dnaParams.coarseSimulationRate = cr;
+
+    if(multiFidelity.enabled && (racing.enabled || surrogate.enabled))
+    {
+        std::cout << "Warning: racing and the surrogate replace multi-fidelity evaluation" << std::endl;
+    }
+
+    // "--novelty" option: novelty search
+    NoveltyParams novelty;
+    novelty.enabled = cmdOptionExists(argc, argv, "--novelty");
+
+    // "--novelty-weight" option: weight of the novelty in the selection
+    double nw = 0.0;
+    if(getCmdOption(argc, argv, "--novelty-weight", nw)) novelty.weight = nw;
+
+    // "--novelty-samples" option: positions of the behavior descriptor
+    uint32_t nsamples = 0;
+    if(getCmdOption(argc, argv, "--novelty-samples", nsamples)) dnaParams.behaviorSamples = nsamples;
+
+    if(novelty.enabled && dnaParams.behaviorSamples > 0 && dnaParams.episodeLength == 0)
+    {
+        std::cout << "Warning: novelty search without episode length (-l), "
+                  << "the behaviors are the final positions" << std::endl;
+    }
+
+    // "--multi-objective" option: NSGA-II selection
+    MultiObjectiveParams multiObjective;
+    multiObjective.enabled = cmdOptionExists(argc, argv, "--multi-objective");
+
+    // The survival objective is a fraction of the episode length
+    if(multiObjective.enabled && dnaParams.episodeLength == 0)
+    {
+        std::cout << "Warning: multi-objective selection needs an episode length (-l), "
+                  << "--multi-objective ignored" << std::endl;
+        multiObjective.enabled = false;
+    }
+    else if(multiObjective.enabled && novelty.enabled)
+    {
+        std::cout << "Warning: multi-objective selection replaces the novelty scores" << std::endl;
+    }
+
+    // "--es" option: evolution strategies engine
+    ESParams es;
+    es.enabled = cmdOptionExists(argc, argv, "--es");
+
+    // "--es-sigma" and "--es-rate" options: perturbations and step size
+    double esSigma = 0.0;
+    if(getCmdOption(argc, argv, "--es-sigma", esSigma)) es.sigma = esSigma;
+    double esRate = 0.0;
+    if(getCmdOption(argc, argv, "--es-rate", esRate)) es.learningRate = esRate;
+
+    // "--workers" option: evaluation in worker processes
+    WorkerPoolParams workers;
+    std::size_t nworkers = 0;
+    workers.enabled = cmdOptionExists(argc, argv, "--workers");
+    if(getCmdOption(argc, argv, "--workers", nworkers)) workers.nworkers = nworkers;
+
+    // "--worker-batch" option: episodes per message to a worker
+    std::size_t wb = 0;
+    if(getCmdOption(argc, argv, "--worker-batch", wb)) workers.batchSize = wb;
+
+    // "--worker-timeout" option: seconds before a worker stuck in a job is replaced
+    double wt = 0.0;
+    if(getCmdOption(argc, argv, "--worker-timeout", wt)) workers.jobTimeout = wt;
+
+    // "--deadline", "--target" and "--plateau" options: stop criteria
+    StopParams stop;
+    double deadline = 0.0;
+    if(getCmdOption(argc, argv, "--deadline", deadline)) stop.deadline = deadline;
+    double targetFitness = 0.0;
+    if(getCmdOption(argc, argv, "--target", targetFitness)) stop.targetFitness = targetFitness;
+    std::size_t plateau = 0;
+    if(getCmdOption(argc, argv, "--plateau", plateau)) stop.plateau = plateau;
+
+    // "--adaptive-population", "--min-population" and "--max-population"
+    // options: population size controller
+    PopulationControlParams populationControl;
+    populationControl.enabled = cmdOptionExists(argc, argv, "--adaptive-population");
+    std::size_t minPopulation = 0;
+    if(getCmdOption(argc, argv, "--min-population", minPopulation)) populationControl.minSize = minPopulation;
+    std::size_t maxPopulation = 0;
+    if(getCmdOption(argc, argv, "--max-population", maxPopulation)) populationControl.maxSize = maxPopulation;
+
+    // "--numa" option: pinned threads and per-node shards of the population
+    ThreadPlacementParams placement;
+    placement.enabled = cmdOptionExists(argc, argv, "--numa");
+
+    // The curriculum and the recorder are updated by the evaluations
+    if(workers.enabled && (dnaParams.curriculum || cmdOptionExists(argc, argv, "--record")))
+    {
+        std::cout << "Warning: the curriculum and the recorded episodes need the evaluations "
+                  << "in the process, --workers ignored" << std::endl;
+        workers.enabled = false;
+    }
+
+    // "--pipeline" option: overlap of the generation boundary
+    PipelineParams pipeline;
+    pipeline.enabled = cmdOptionExists(argc, argv, "--pipeline");
+
+    // The other evaluation modes are not pipelined
+    if(pipeline.enabled && (racing.enabled || surrogate.enabled || multiFidelity.enabled ||
+        novelty.enabled || multiObjective.enabled || workers.enabled || populationControl.enabled))
+    {
+        std::cout << "Warning: --pipeline only applies to the plain evaluation, "
+                  << "generations are not pipelined" << std::endl;
+    }
+
+    // "--world-cache" option: directory of the valid seeds shared between runs
+    char * wc = getCmdOption(argc, argv, "--world-cache");
+    if(wc)
+    {
+        std::size_t nseeds = 0;
+        if(openWorldCache(wc, nseeds))
+        {
+            std::cout << "World cache: " << nseeds << " valid seeds in \"" << wc << "\"" << std::endl;
+        }
+        else
+        {
+            std::cout << "Failed to open world cache in \"" << wc << "\"" << std::endl;
+        }
+    }
+
 
     // "-r" or "--replay" option: replay best DNA
     if(cmdOptionExists(argc, argv, "-r", "--replay"))
@@ -264,35 +1528,206 @@ void selfDrivingCarMain(int argc, char ** argv)
         omp_set_num_threads(1);
         #endif
 
-        replayBest(carDef, dnaParams, destination, worldSeed, filename);
+        // "-q" option: drive with a quantized network
+        std::string qfilename;
+        char * q = getCmdOption(argc, argv, "-q");
+        if(q) qfilename = q;
+
+        replayBest(carDef, dnaParams, destination, worldSeed, filename, qfilename);
     }
-    else // Car evolution
+    else if(cmdOptionExists(argc, argv, "--quantize"))
     {
-        int32_t nthreads = 1;
+        char * f = getCmdOption(argc, argv, "-f");
+        if(f) filename = f;
 
-        // "--max-threads" option: use maximum number of threads?
-        if(cmdOptionExists(argc, argv, "--max-threads"))
-        {
-            #ifdef _OPENMP
-            nthreads = omp_get_max_threads();
-            #endif
-        }
+        std::string qfilename = filename + ".q8";
+        char * q = getCmdOption(argc, argv, "-q");
+        if(q) qfilename = q;
 
-        // "-t" option: number of threads to use
-        int nt = 0;
-        if(getCmdOption(argc, argv, "-t", nt)) nthreads = nt;
+        // "--calibration-seeds" option: number of calibration worlds
+        uint32_t ncalibrationSeeds = 16;
+        uint32_t ncs = 0;
+        if(getCmdOption(argc, argv, "--calibration-seeds", ncs)) ncalibrationSeeds = ncs;
 
         #ifdef _OPENMP
-        omp_set_num_threads(nthreads);
+        omp_set_num_threads(1);
         #endif
 
-        std::cout << "Running " << nthreads << " thread"
-                  << (nthreads > 1 ? "s" : "") << std::endl;
+        quantizeBest(
+            carDef, dnaParams, destination, worldSeed,
+            ncalibrationSeeds, filename, qfilename
+        );
+    }
+    else if(cmdOptionExists(argc, argv, "--validate"))
+    {
+        setNumThreads(argc, argv);
+
+        ValidationParams params;
+        params.firstSeed = worldSeed;
+
+        // "-f" option: comma-separated list of networks to validate
+        char * f = getCmdOption(argc, argv, "-f");
+        std::stringstream files(f ? f : filename.c_str());
+        std::string file;
+        while(std::getline(files, file, ','))
+        {
+            if(!file.empty()) params.networkFiles.push_back(file);
+        }
+
+        // "--nseeds" option: number of validation worlds
+        uint32_t ns = 0;
+        if(getCmdOption(argc, argv, "--nseeds", ns)) params.nseeds = ns;
+
+        // "--success" option: fitness of a successful episode
+        double sf = 0.0;
+        if(getCmdOption(argc, argv, "--success", sf)) params.successFitness = sf;
+
+        params.controlPeriods = controlPeriods;
+        params.compareSparse = cmdOptionExists(argc, argv, "--compare-sparse");
+
+        validation(carDef, dnaParams, destination, params);
+    }
+    else if(char * sw = getCmdOption(argc, argv, "--sweep"))
+    {
+        SweepParams params;
+        params.nthreads = uint32_t(std::max(1, setNumThreads(argc, argv)));
+        params.racing = racing;
+        params.surrogate = surrogate;
+        params.multiFidelity = multiFidelity;
+        params.novelty = novelty;
+        params.multiObjective = multiObjective;
+        params.stop = stop;
+
+        // "--sweep-policy" option: sharing of the threads
+        char * sp = getCmdOption(argc, argv, "--sweep-policy");
+        if(sp && std::string(sp) == "priority") params.policy = SweepPolicy::Priority;
+
+        // "--sweep-dir" option: directory of the output files
+        char * sd = getCmdOption(argc, argv, "--sweep-dir");
+        if(sd) params.outputDirectory = sd;
+
+        // Values of the keys missing from the sweep file
+        ExperimentConfig defaults;
+        defaults.mutationRate = mutationRate;
+        defaults.elitism = elitism;
+        defaults.nindividuals = nindividuals;
+        defaults.ngenerations = ngenerations;
+        defaults.worldSeedChangeInterval = dnaParams.worldSeedChangeInterval;
+        defaults.worldSeed = worldSeed;
+
+        std::string error;
+        if(!loadSweepFile(sw, defaults, params.experiments, error))
+        {
+            std::cout << "Failed to read sweep file: " << error << std::endl;
+            return;
+        }
+
+        if(cmdOptionExists(argc, argv, "--sweep-benchmark"))
+        {
+            sweepBenchmark(carDef, dnaParams, destination, params);
+        }
+        else sweep(carDef, dnaParams, destination, params);
+    }
+    else if(cmdOptionExists(argc, argv, "--engine-benchmark"))
+    {
+        setNumThreads(argc, argv);
+
+        // "--target" option: fitness to reach
+        double target = 0.9;
+        getCmdOption(argc, argv, "--target", target);
+
+        engineBenchmark(
+            carDef, dnaParams, destination, worldSeed, mutationRate, elitism,
+            nindividuals, ngenerations, es, target
+        );
+    }
+    else if(cmdOptionExists(argc, argv, "--workers-benchmark"))
+    {
+        setNumThreads(argc, argv);
+
+        workersBenchmark(
+            carDef, dnaParams, destination, worldSeed, mutationRate, elitism,
+            nindividuals, ngenerations, workers
+        );
+    }
+    else if(cmdOptionExists(argc, argv, "--scaling-benchmark"))
+    {
+        // Up to the threads of -t or --max-threads
+        int32_t const maxThreads = setNumThreads(argc, argv);
+
+        scalingBenchmark(
+            carDef, dnaParams, destination, worldSeed, mutationRate, elitism,
+            nindividuals, ngenerations, static_cast<std::size_t>(std::max(maxThreads, 1))
+        );
+    }
+    else if(cmdOptionExists(argc, argv, "--string-benchmark"))
+    {
+        setNumThreads(argc, argv);
+
+        // Engine overhead: populations up to -i individuals, -g generations
+        std::size_t maxPopulation = 1000000;
+        if(getCmdOption(argc, argv, "-i", nindiv)) maxPopulation = nindiv;
+
+        stringEvolution(maxPopulation, getCmdOption(argc, argv, "-g", ngen) ? ngen : 20);
+    }
+    else // Car evolution
+    {
+        setNumThreads(argc, argv);
 
         // Output file for the best DNA
         char * f = getCmdOption(argc, argv, "-f");
         if(f) filename = f;
 
+        // "--record" option: number of recorded individuals per generation
+        std::size_t nrecorded = 0;
+        getCmdOption(argc, argv, "--record", nrecorded);
+
+        // Only the elites are evaluated again in the next generation
+        std::size_t const nelites = es.enabled ? 1 : elitism;
+        if(nrecorded > nelites)
+        {
+            std::cout << "Warning: only the " << nelites << " elite" << (nelites != 1 ? "s" : "")
+                      << " can be recorded, --record " << nrecorded << " reduced" << std::endl;
+            nrecorded = nelites;
+        }
+
+        // "--trace-file" option: trajectory file
+        std::string traceFilename = "trajectories.bin";
+        char * t = getCmdOption(argc, argv, "--trace-file");
+        if(t) traceFilename = t;
+
+        // "--status" option: shared memory status segment
+        std::string statusName;
+        char * st = getCmdOption(argc, argv, "--status");
+        if(st) statusName = st;
+
+        // "--history" option: population history log
+        std::string historyName;
+        char * hi = getCmdOption(argc, argv, "--history");
+        if(hi) historyName = hi;
+
+        // "--warm-start" option: seed networks of the initial population
+        SeedParams warmStart;
+        char * ws = getCmdOption(argc, argv, "--warm-start");
+        if(ws && !loadSeeds(ws, carDef, destination, worldSeed, warmStart)) return;
+
+        // "--warm-mutated" and "--warm-mutation" options: the other individuals
+        double wm = 0.0;
+        if(getCmdOption(argc, argv, "--warm-mutated", wm)) warmStart.mutatedFraction = wm;
+        double wr = 0.0;
+        if(getCmdOption(argc, argv, "--warm-mutation", wr)) warmStart.mutationRate = wr;
+
+        if(nrecorded > 0)
+        {
+            dnaParams.recorder = std::make_shared<TrajectoryRecorder>(traceFilename);
+            if(!dnaParams.recorder->isOpen())
+            {
+                std::cout << "Failed to open trajectory file \""
+                          << traceFilename << "\"" << std::endl;
+                return;
+            }
+        }
+
         carEvolution(
             carDef,
             dnaParams,
@@ -302,6 +1737,21 @@ void selfDrivingCarMain(int argc, char ** argv)
             elitism,
             nindividuals,
             ngenerations,
+            racing,
+            surrogate,
+            multiFidelity,
+            novelty,
+            multiObjective,
+            warmStart,
+            es,
+            workers,
+            stop,
+            populationControl,
+            placement,
+            pipeline,
+            nrecorded,
+            statusName,
+            historyName,
             filename
         );
     }
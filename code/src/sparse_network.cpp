@@ -0,0 +1,267 @@
+#include <sparse_network.hpp>
+#include <cpu_dispatch.hpp>
+#include <functions.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+#if NEURO_CAR_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace NeuroCar {
+
+namespace {
+
+// Rows of a slice, one per lane of an AVX-512 register of doubles
+uint32_t const SliceRows = 8;
+
+// Sums of the biases and weighted inputs of the slices [0, nslices[. Each
+// row adds its connections in the same order as the CSR loop of compute,
+// and the padding adds nothing, so the sums are bit-identical to it.
+void sliceSumsGeneric(
+    uint32_t const * sliceStart, int32_t const * columns, float const * values,
+    float const * biases, uint32_t nslices, double const * inputs, double * sums
+)
+{
+    for(auto s = 0u; s < nslices; ++s)
+    {
+        for(auto l = 0u; l < SliceRows; ++l)
+        {
+            double sum = biases[s * SliceRows + l];
+            for(auto k = sliceStart[s]; k < sliceStart[s+1]; ++k)
+            {
+                float const w = values[k * SliceRows + l];
+                if(std::fpclassify(w) != FP_ZERO) sum += w * inputs[columns[k * SliceRows + l]];
+            }
+            sums[s * SliceRows + l] = sum;
+        }
+    }
+}
+
+#if NEURO_CAR_DISPATCH
+
+// Two halves of a slice per step
+NEURO_CAR_TARGET_AVX2
+void sliceSumsAvx2(
+    uint32_t const * sliceStart, int32_t const * columns, float const * values,
+    float const * biases, uint32_t nslices, double const * inputs, double * sums
+)
+{
+    for(auto s = 0u; s < nslices; ++s)
+    {
+        __m256d sumLow = _mm256_cvtps_pd(_mm_loadu_ps(biases + s * SliceRows));
+        __m256d sumHigh = _mm256_cvtps_pd(_mm_loadu_ps(biases + s * SliceRows + 4));
+
+        for(auto k = sliceStart[s]; k < sliceStart[s+1]; ++k)
+        {
+            __m256 const w = _mm256_loadu_ps(values + k * SliceRows);
+            __m256i const c = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(columns + k * SliceRows));
+
+            // The padding is the only zero weight: its lanes gather nothing
+            __m256i const active = _mm256_castps_si256(_mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_NEQ_OQ));
+
+            __m256d const xLow = _mm256_mask_i32gather_pd(
+                _mm256_setzero_pd(), inputs, _mm256_castsi256_si128(c),
+                _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm256_castsi256_si128(active))), 8
+            );
+            __m256d const xHigh = _mm256_mask_i32gather_pd(
+                _mm256_setzero_pd(), inputs, _mm256_extracti128_si256(c, 1),
+                _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm256_extracti128_si256(active, 1))), 8
+            );
+
+            sumLow = _mm256_add_pd(sumLow, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(w)), xLow));
+            sumHigh = _mm256_add_pd(sumHigh, _mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(w, 1)), xHigh));
+        }
+
+        _mm256_storeu_pd(sums + s * SliceRows, sumLow);
+        _mm256_storeu_pd(sums + s * SliceRows + 4, sumHigh);
+    }
+}
+
+// The rounding forms keep the product and the sum apart: a fused
+// multiply-add would round differently from the CSR loop
+NEURO_CAR_TARGET_AVX512
+void sliceSumsAvx512(
+    uint32_t const * sliceStart, int32_t const * columns, float const * values,
+    float const * biases, uint32_t nslices, double const * inputs, double * sums
+)
+{
+    int const rounding = _MM_FROUND_CUR_DIRECTION;
+
+    for(auto s = 0u; s < nslices; ++s)
+    {
+        __m512d sum = _mm512_cvtps_pd(_mm256_loadu_ps(biases + s * SliceRows));
+
+        for(auto k = sliceStart[s]; k < sliceStart[s+1]; ++k)
+        {
+            __m512d const w = _mm512_cvtps_pd(_mm256_loadu_ps(values + k * SliceRows));
+            __mmask8 const active = _mm512_cmp_pd_mask(w, _mm512_setzero_pd(), _CMP_NEQ_OQ);
+
+            __m512d const x = _mm512_mask_i32gather_pd(
+                _mm512_setzero_pd(), active,
+                _mm256_loadu_si256(reinterpret_cast<__m256i const *>(columns + k * SliceRows)),
+                inputs, 8
+            );
+            sum = _mm512_add_round_pd(sum, _mm512_mul_round_pd(w, x, rounding), rounding);
+        }
+
+        _mm512_storeu_pd(sums + s * SliceRows, sum);
+    }
+}
+
+#endif
+
+void sliceSums(
+    uint32_t const * sliceStart, int32_t const * columns, float const * values,
+    float const * biases, uint32_t nslices, double const * inputs, double * sums
+)
+{
+    static auto const kernel = NEURO_CAR_SELECT_KERNEL(sliceSums);
+    kernel(sliceStart, columns, values, biases, nslices, inputs, sums);
+}
+
+// Other activation types are never sliced
+template <typename T>
+void sliceSums(
+    uint32_t const *, int32_t const *, float const *,
+    float const *, uint32_t, T const *, T *
+)
+{
+
+}
+
+}
+
+SparseNetwork::SparseNetwork():
+    m_shape(),
+    m_layers(),
+    m_connections(0),
+    m_activations(),
+    m_next()
+{
+
+}
+
+void SparseNetwork::compact(Shape const & shape, Genome const & genome)
+{
+    assert(genome.size() == genomeSize(shape));
+
+    // The slices only pay off with the wide kernels
+    bool const sliced = std::is_same<Weight, double>::value && activeIsa() != Isa::Generic;
+
+    m_shape = shape;
+    m_layers.resize(shape.size() > 0 ? shape.size() - 1 : 0);
+    m_connections = 0;
+
+    std::size_t row = 0;
+    for(auto l = 0u; l < m_layers.size(); ++l)
+    {
+        Layer & layer = m_layers[l];
+        layer.inputs = static_cast<uint32_t>(shape[l]);
+        layer.outputs = static_cast<uint32_t>(shape[l+1]);
+        layer.rowStart.resize(layer.outputs + 1);
+        layer.columns.clear();
+        layer.values.clear();
+        layer.biases.resize(layer.outputs);
+
+        for(auto j = 0u; j < layer.outputs; ++j)
+        {
+            float const * w = &genome[row + j * (layer.inputs + 1)];
+
+            layer.rowStart[j] = static_cast<uint32_t>(layer.columns.size());
+            for(auto i = 0u; i < layer.inputs; ++i)
+            {
+                // Pruned connections are exact zeros
+                if(std::fpclassify(w[i]) != FP_ZERO)
+                {
+                    layer.columns.push_back(static_cast<uint16_t>(i));
+                    layer.values.push_back(w[i]);
+                }
+            }
+            layer.biases[j] = w[layer.inputs];
+        }
+        layer.rowStart[layer.outputs] = static_cast<uint32_t>(layer.columns.size());
+
+        layer.sliceStart.assign(1, 0);
+        layer.sliceColumns.clear();
+        layer.sliceValues.clear();
+
+        uint32_t const nslices = sliced ? layer.outputs / SliceRows : 0;
+        for(auto s = 0u; s < nslices; ++s)
+        {
+            uint32_t const * start = &layer.rowStart[s * SliceRows];
+
+            uint32_t length = 0;
+            for(auto r = 0u; r < SliceRows; ++r) length = std::max(length, start[r+1] - start[r]);
+
+            for(auto k = 0u; k < length; ++k)
+            {
+                for(auto r = 0u; r < SliceRows; ++r)
+                {
+                    bool const inRow = start[r] + k < start[r+1];
+                    layer.sliceColumns.push_back(inRow ? layer.columns[start[r] + k] : 0);
+                    layer.sliceValues.push_back(inRow ? layer.values[start[r] + k] : 0.0f);
+                }
+            }
+            layer.sliceStart.push_back(layer.sliceStart.back() + length);
+        }
+
+        m_connections += std::size_t(layer.inputs) * layer.outputs;
+        row += std::size_t(layer.inputs + 1) * layer.outputs;
+    }
+}
+
+void SparseNetwork::compute(Weight const * inputs, Weight * outputs) const
+{
+    assert(!m_layers.empty());
+
+    m_activations.assign(inputs, inputs + m_shape.front());
+
+    for(auto const & layer : m_layers)
+    {
+        m_next.resize(layer.outputs);
+
+        uint32_t const nslices = static_cast<uint32_t>(layer.sliceStart.size() - 1);
+        sliceSums(
+            layer.sliceStart.data(), layer.sliceColumns.data(), layer.sliceValues.data(),
+            layer.biases.data(), nslices, m_activations.data(), m_next.data()
+        );
+
+        for(auto j = nslices * SliceRows; j < layer.outputs; ++j)
+        {
+            Weight sum = layer.biases[j];
+            for(auto k = layer.rowStart[j]; k < layer.rowStart[j+1]; ++k)
+            {
+                sum += layer.values[k] * m_activations[layer.columns[k]];
+            }
+            m_next[j] = sum;
+        }
+
+        for(auto & x : m_next) x = NeuroEvolution::sigmoid(x);
+        std::swap(m_activations, m_next);
+    }
+
+    std::copy(m_activations.begin(), m_activations.end(), outputs);
+}
+
+SparseNetwork::Shape const & SparseNetwork::getShape() const
+{
+    return m_shape;
+}
+
+std::size_t SparseNetwork::getConnectionCount() const
+{
+    return m_connections;
+}
+
+std::size_t SparseNetwork::getActiveConnectionCount() const
+{
+    std::size_t active = 0;
+    for(auto const & layer : m_layers) active += layer.values.size();
+    return active;
+}
+
+}
@@ -0,0 +1,83 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <cmd_options.hpp>
+#include <run_status.hpp>
+
+// Print the status published by a running evolution (--status option)
+int main(int argc, char ** argv)
+{
+    using namespace NeuroCar;
+
+    if(cmdOptionExists(argc, argv, "-h", "--help"))
+    {
+        std::cout << "Usage: " << argv[0] << " [options]"                        << std::endl;
+        std::cout << "Options:"                                                   << std::endl;
+        std::cout << "  -h, --help      Print this help"                          << std::endl;
+        std::cout << "  -n N            <N> Status segment name (default: /neuro_car)" << std::endl;
+        std::cout << "  -w W            <W> Refresh every W milliseconds"         << std::endl;
+        std::cout << "  --genome        Print the genome of the best individual"  << std::endl;
+        return 0;
+    }
+
+    std::string name = "/neuro_car";
+    char * n = getCmdOption(argc, argv, "-n");
+    if(n) name = n;
+
+    uint32_t period = 0;
+    getCmdOption(argc, argv, "-w", period);
+
+    bool const printGenome = cmdOptionExists(argc, argv, "--genome");
+
+    RunStatusReader reader(name);
+    if(!reader.isOpen())
+    {
+        std::cout << "No status segment \"" << name << "\"" << std::endl;
+        return 1;
+    }
+
+    RunStatus status;
+    do
+    {
+        if(!reader.read(status))
+        {
+            std::cout << "Nothing published yet" << std::endl;
+        }
+        else
+        {
+            uint64_t const now = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()
+                ).count()
+            );
+
+            std::cout << "Generation " << status.generation
+                      << ", " << status.evaluations << " evaluations ("
+                      << status.evaluationsPerSecond << " eval/s), best fitness ";
+            if(status.bestGenome.empty()) std::cout << "-";
+            else std::cout << status.bestFitness;
+            std::cout << ", updated " << (now - status.updateTime) / 1000.0
+                      << " s ago" << std::endl;
+
+            if(printGenome)
+            {
+                for(auto i = 0u; i < status.bestGenome.size(); ++i)
+                {
+                    std::cout << (i > 0 ? " " : "") << status.bestGenome[i];
+                }
+                std::cout << std::endl;
+            }
+        }
+
+        if(period > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(period));
+        }
+    }
+    while(period > 0);
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include <surrogate.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+SurrogateModel::SurrogateModel():
+    m_capacity(0),
+    m_neighbours(1),
+    m_dimension(0),
+    m_count(0),
+    m_next(0),
+    m_features(),
+    m_fitness()
+{
+
+}
+
+void SurrogateModel::configure(std::size_t capacity, std::size_t neighbours)
+{
+    m_capacity = capacity;
+    m_neighbours = std::max<std::size_t>(neighbours, 1);
+    m_dimension = 0;
+    m_count = 0;
+    m_next = 0;
+    m_features.clear();
+    m_fitness.assign(capacity, 0.0);
+}
+
+void SurrogateModel::add(float const * features, std::size_t size, double fitness)
+{
+    if(m_capacity == 0 || size == 0) return;
+
+    if(m_dimension == 0)
+    {
+        m_dimension = size;
+        m_features.assign(m_capacity * m_dimension, 0.0f);
+    }
+    if(size != m_dimension) return;
+
+    std::copy(features, features + size, m_features.begin() + m_next * m_dimension);
+    m_fitness[m_next] = fitness;
+
+    m_next = (m_next + 1) % m_capacity;
+    m_count = std::min(m_count + 1, m_capacity);
+}
+
+bool SurrogateModel::accepts(std::size_t size) const
+{
+    return size > 0 && size == m_dimension;
+}
+
+double SurrogateModel::predict(float const * features, std::size_t size) const
+{
+    assert(this->accepts(size) && m_count > 0);
+
+    // Nearest samples as (squared distance, sample), kept sorted
+    std::size_t const k = std::min(m_neighbours, m_count);
+    std::vector<std::pair<float, std::size_t>> nearest;
+    nearest.reserve(k + 1);
+
+    for(std::size_t s = 0; s < m_count; ++s)
+    {
+        float const * row = &m_features[s * m_dimension];
+        float d = 0.0f;
+        for(auto i = 0u; i < size; ++i)
+        {
+            float const diff = row[i] - features[i];
+            d += diff * diff;
+        }
+
+        if(nearest.size() == k && !(d < nearest.back().first)) continue;
+
+        auto const it = std::upper_bound(nearest.begin(), nearest.end(), std::make_pair(d, s));
+        nearest.insert(it, std::make_pair(d, s));
+        if(nearest.size() > k) nearest.pop_back();
+    }
+
+    double weightSum = 0.0;
+    double fitnessSum = 0.0;
+    for(auto const & n : nearest)
+    {
+        double const w = 1.0 / (static_cast<double>(n.first) + 1e-6);
+        weightSum += w;
+        fitnessSum += w * m_fitness[n.second];
+    }
+    return fitnessSum / weightSum;
+}
+
+std::size_t SurrogateModel::getSampleCount() const
+{
+    return m_count;
+}
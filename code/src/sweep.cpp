@@ -0,0 +1,478 @@
+#include <sweep.hpp>
+
+#include <serialization.hpp>
+#include <stats.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__unix__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace NeuroCar {
+
+namespace {
+
+template <typename T>
+bool parseValue(std::string const & text, T & value)
+{
+    std::stringstream ss(text);
+    return (ss >> value) && ss.eof();
+}
+
+bool setField(ExperimentConfig & config, std::string const & key, std::string const & value)
+{
+    if(key == "name")        { config.name = value; return true; }
+    if(key == "mutation")    return parseValue(value, config.mutationRate);
+    if(key == "elitism")     return parseValue(value, config.elitism);
+    if(key == "population")  return parseValue(value, config.nindividuals);
+    if(key == "generations") return parseValue(value, config.ngenerations);
+    if(key == "interval")    return parseValue(value, config.worldSeedChangeInterval);
+    if(key == "seed")        return parseValue(value, config.worldSeed);
+    if(key == "priority")    return parseValue(value, config.priority);
+    return false;
+}
+
+using Field = std::pair<std::string, std::vector<std::string>>;
+
+bool parseLine(std::string const & line, std::vector<Field> & fields)
+{
+    std::stringstream tokens(line);
+    std::string token;
+    while(tokens >> token)
+    {
+        std::size_t const eq = token.find('=');
+        if(eq == 0 || eq == std::string::npos || eq + 1 == token.size()) return false;
+
+        Field field(token.substr(0, eq), { });
+        std::stringstream values(token.substr(eq + 1));
+        std::string value;
+        while(std::getline(values, value, ','))
+        {
+            if(value.empty()) return false;
+            field.second.push_back(value);
+        }
+        fields.push_back(field);
+    }
+    return true;
+}
+
+// Every combination of the values of a grid line
+bool expandGrid(
+    std::vector<Field> const & fields, ExperimentConfig const & defaults,
+    std::string const & defaultName, std::vector<ExperimentConfig> & experiments,
+    std::string & error
+)
+{
+    std::vector<std::size_t> index(fields.size(), 0);
+    while(true)
+    {
+        ExperimentConfig config = defaults;
+        config.name = defaultName;
+
+        std::string suffix;
+        for(auto f = 0u; f < fields.size(); ++f)
+        {
+            std::string const & key = fields[f].first;
+            std::string const & value = fields[f].second[index[f]];
+            if(!setField(config, key, value))
+            {
+                error = "invalid field \"" + key + "=" + value + "\"";
+                return false;
+            }
+            if(fields[f].second.size() > 1) suffix += "-" + key + value;
+        }
+        config.name += suffix;
+        experiments.push_back(config);
+
+        // Next combination, the last field varying fastest
+        std::size_t f = fields.size();
+        while(f > 0 && ++index[f - 1] == fields[f - 1].second.size())
+        {
+            index[--f] = 0;
+        }
+        if(f == 0) return true;
+    }
+}
+
+}
+
+bool loadSweepFile(
+    std::string const & filename,
+    ExperimentConfig const & defaults,
+    std::vector<ExperimentConfig> & experiments,
+    std::string & error
+)
+{
+    std::ifstream file(filename);
+    if(!file)
+    {
+        error = "cannot open \"" + filename + "\"";
+        return false;
+    }
+
+    std::string line;
+    for(std::size_t l = 1; std::getline(file, line); ++l)
+    {
+        std::size_t const start = line.find_first_not_of(" \t\r");
+        if(start == std::string::npos || line[start] == '#') continue;
+
+        std::vector<Field> fields;
+        std::string lineError;
+        if(!parseLine(line, fields) ||
+           !expandGrid(fields, defaults, "exp" + std::to_string(l), experiments, lineError))
+        {
+            error = "line " + std::to_string(l) + ": " +
+                (lineError.empty() ? "expected key=value[,value...] fields" : lineError);
+            return false;
+        }
+    }
+
+    // Output files are named after the experiments
+    std::vector<std::string> names;
+    for(auto const & experiment : experiments) names.push_back(experiment.name);
+    std::sort(names.begin(), names.end());
+    auto const duplicate = std::adjacent_find(names.begin(), names.end());
+    if(duplicate != names.end())
+    {
+        error = "duplicate experiment name \"" + *duplicate + "\"";
+        return false;
+    }
+
+    return true;
+}
+
+SweepScheduler::SweepScheduler(
+    uint32_t nthreads, SweepPolicy policy, std::vector<double> const & priorities
+):
+    m_mutex(),
+    m_nthreads(std::max(1u, nthreads)),
+    m_weights(priorities.size(), 1.0),
+    m_pending(priorities.size()),
+    m_running(),
+    m_shares(priorities.size(), 0)
+{
+    for(auto e = 0u; e < priorities.size(); ++e)
+    {
+        m_pending[e] = priorities.size() - 1 - e;
+    }
+
+    if(policy == SweepPolicy::Priority)
+    {
+        for(auto e = 0u; e < priorities.size(); ++e)
+        {
+            m_weights[e] = std::max(priorities[e], 1e-6);
+        }
+
+        // Lowest priorities first, so that the highest are at the back
+        std::stable_sort(m_pending.begin(), m_pending.end(),
+            [this](std::size_t lhs, std::size_t rhs)
+            {
+                return m_weights[lhs] < m_weights[rhs];
+            }
+        );
+    }
+}
+
+bool SweepScheduler::next(std::size_t & experiment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_pending.empty()) return false;
+
+    experiment = m_pending.back();
+    m_pending.pop_back();
+    m_running.push_back(experiment);
+    this->rebalance();
+    return true;
+}
+
+uint32_t SweepScheduler::threads(std::size_t experiment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::max(1u, m_shares[experiment]);
+}
+
+void SweepScheduler::finish(std::size_t experiment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_running.erase(std::find(m_running.begin(), m_running.end(), experiment));
+    m_shares[experiment] = 0;
+    this->rebalance();
+}
+
+std::size_t SweepScheduler::getMaxConcurrency() const
+{
+    return std::min<std::size_t>(m_nthreads, m_shares.size());
+}
+
+void SweepScheduler::rebalance()
+{
+    if(m_running.empty()) return;
+
+    // One thread each, the others by weight (largest remainders first)
+    uint32_t const extra = m_nthreads - std::min<uint32_t>(m_nthreads, m_running.size());
+
+    double total = 0.0;
+    for(auto e : m_running) total += m_weights[e];
+
+    uint32_t given = 0;
+    std::vector<std::pair<double, std::size_t>> remainders;
+    for(auto e : m_running)
+    {
+        double const exact = extra * m_weights[e] / total;
+        uint32_t const floor = static_cast<uint32_t>(exact);
+        m_shares[e] = 1 + floor;
+        given += floor;
+        remainders.emplace_back(exact - floor, e);
+    }
+
+    std::sort(remainders.begin(), remainders.end(),
+        [](std::pair<double, std::size_t> const & lhs, std::pair<double, std::size_t> const & rhs)
+        {
+            return lhs.first > rhs.first || (!(lhs.first < rhs.first) && lhs.second < rhs.second);
+        }
+    );
+    for(auto r = 0u; given < extra && r < remainders.size(); ++r, ++given)
+    {
+        ++m_shares[remainders[r].second];
+    }
+}
+
+std::vector<ExperimentResult> runSweep(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    SweepParams const & params
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t const nexperiments = params.experiments.size();
+
+    std::vector<double> priorities;
+    for(auto const & experiment : params.experiments) priorities.push_back(experiment.priority);
+
+    SweepScheduler scheduler(params.nthreads, params.policy, priorities);
+    std::vector<ExperimentResult> results(nexperiments);
+    std::mutex hookMutex;
+
+    auto const run = [&](std::size_t e)
+    {
+        ExperimentConfig const & config = params.experiments[e];
+        ExperimentResult & result = results[e];
+        result.name = config.name;
+
+        // Per-run state is never shared between experiments
+        DNAParams<SelfDrivingCarDNA> experimentParams = dnaParams;
+        experimentParams.worldSeedChangeInterval = config.worldSeedChangeInterval;
+        experimentParams.recorder = nullptr;
+        if(dnaParams.curriculum)
+        {
+            experimentParams.curriculum = std::make_shared<EpisodeCurriculum>(
+                dnaParams.curriculum->getParams(), dnaParams.episodeLength,
+                config.worldSeedChangeInterval
+            );
+        }
+
+        Population<SelfDrivingCar> cars;
+        for(auto i = 0u; i < config.nindividuals; ++i)
+        {
+            auto sdCar = createIndividual<SelfDrivingCar>();
+            sdCar->setCar(std::make_shared<Car>(carDef));
+            sdCar->setDestination(destination);
+            sdCar->setWorldSeed(config.worldSeed);
+            cars.push_back(sdCar);
+        }
+
+        std::string const prefix = params.outputDirectory + "/" + config.name;
+        Stats stats(prefix + ".csv", 10);
+
+        // This thread is the master of the OpenMP teams of the experiment
+        uint32_t nthreads = scheduler.threads(e);
+        #ifdef _OPENMP
+        omp_set_num_threads(int(nthreads));
+        #endif
+
+        EvolutionParams<SelfDrivingCarDNA> evolutionParams;
+        evolutionParams.mutationRate = config.mutationRate;
+        evolutionParams.elitism      = config.elitism;
+        evolutionParams.dnaParams    = experimentParams;
+        evolutionParams.racing       = params.racing;
+        evolutionParams.surrogate    = params.surrogate;
+        evolutionParams.multiFidelity = params.multiFidelity;
+        evolutionParams.novelty      = params.novelty;
+        evolutionParams.multiObjective = params.multiObjective;
+        evolutionParams.stop         = params.stop;
+
+        // Apply the current share of the threads
+        evolutionParams.preGenHook = [&scheduler, &nthreads, e](
+            std::size_t, DNAs<SelfDrivingCarDNA> const &
+        )
+        {
+            nthreads = scheduler.threads(e);
+            #ifdef _OPENMP
+            omp_set_num_threads(int(nthreads));
+            #endif
+        };
+
+        std::shared_ptr<EpisodeCurriculum> const curriculum = experimentParams.curriculum;
+        evolutionParams.postGenHook = [&](std::size_t i, DNAs<SelfDrivingCarDNA> const & dnas)
+        {
+            if(dnas.empty()) return;
+
+            stats(i, dnas);
+
+            double best = dnas.front().getFitness();
+            for(auto const & dna : dnas) best = std::max(best, dna.getFitness());
+
+            if(curriculum) curriculum->update(i, best);
+
+            result.bestFitness = best;
+            result.generations = i + 1;
+            result.evaluations += dnas.size();
+
+            if(params.generationHook)
+            {
+                std::lock_guard<std::mutex> lock(hookMutex);
+                params.generationHook(config, i, best, nthreads);
+            }
+        };
+
+        Clock::time_point const start = Clock::now();
+        DNAs<SelfDrivingCarDNA> const last = evolve<SelfDrivingCarDNA>(
+            cars, config.ngenerations, evolutionParams
+        );
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if(!last.empty())
+        {
+            NeuroEvolution::saveToFile(
+                last.back().getSubject()->getNeuralNetwork(), prefix + ".txt"
+            );
+        }
+    };
+
+    // One worker per concurrent experiment, each running experiments until
+    // none is left
+    std::vector<std::thread> workers;
+    for(auto w = 0u; w < scheduler.getMaxConcurrency(); ++w)
+    {
+        workers.emplace_back([&scheduler, &run]()
+        {
+            std::size_t e = 0;
+            while(scheduler.next(e))
+            {
+                run(e);
+                scheduler.finish(e);
+            }
+        });
+    }
+
+    for(auto & worker : workers) worker.join();
+
+    return results;
+}
+
+std::vector<ExperimentResult> runSweepProcesses(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    SweepParams const & params
+)
+{
+    std::size_t const nexperiments = params.experiments.size();
+    std::vector<ExperimentResult> results(nexperiments);
+    for(auto e = 0u; e < nexperiments; ++e) results[e].name = params.experiments[e].name;
+
+    #if defined(__unix__)
+    // Result of a child, in one pipe write
+    struct Report
+    {
+        double bestFitness;
+        std::size_t generations;
+        std::size_t evaluations;
+        double seconds;
+    };
+
+    struct Child
+    {
+        std::size_t experiment;
+        pid_t pid;
+        int pipe;
+    };
+
+    std::vector<Child> children;
+    for(auto e = 0u; e < nexperiments; ++e)
+    {
+        int fds[2];
+        if(::pipe(fds) != 0) continue;
+
+        pid_t const pid = ::fork();
+        if(pid < 0)
+        {
+            ::close(fds[0]);
+            ::close(fds[1]);
+            continue;
+        }
+
+        if(pid == 0)
+        {
+            // A sweep of this experiment alone on all the threads, as in a
+            // process of its own
+            ::close(fds[0]);
+            for(auto const & child : children) ::close(child.pipe);
+
+            SweepParams single = params;
+            single.experiments.assign(1, params.experiments[e]);
+            single.generationHook = nullptr;
+
+            ExperimentResult const result = runSweep(carDef, dnaParams, destination, single).front();
+            Report const report = {
+                result.bestFitness, result.generations, result.evaluations, result.seconds
+            };
+            bool const sent = ::write(fds[1], &report, sizeof(report)) == ::ssize_t(sizeof(report));
+            ::_exit(sent ? 0 : 1);
+        }
+
+        ::close(fds[1]);
+        children.push_back(Child{ e, pid, fds[0] });
+    }
+
+    // A failed child leaves its result empty
+    for(auto const & child : children)
+    {
+        Report report;
+        if(::read(child.pipe, &report, sizeof(report)) == ::ssize_t(sizeof(report)))
+        {
+            ExperimentResult & result = results[child.experiment];
+            result.bestFitness = report.bestFitness;
+            result.generations = report.generations;
+            result.evaluations = report.evaluations;
+            result.seconds = report.seconds;
+        }
+
+        ::close(child.pipe);
+        ::waitpid(child.pid, nullptr, 0);
+    }
+    #else
+    (void) carDef;
+    (void) dnaParams;
+    (void) destination;
+    #endif
+
+    return results;
+}
+
+}
@@ -0,0 +1,220 @@
+#include <thread_placement.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace {
+
+// CPU list of the kernel, e.g. "0-7,16-23"
+std::vector<int> parseCpuList(std::string const & list)
+{
+    std::vector<int> cpus;
+    std::istringstream stream(list);
+    std::string range;
+    while(std::getline(stream, range, ','))
+    {
+        int first = 0;
+        int last = 0;
+        char dash = 0;
+        std::istringstream bounds(range);
+        if(!(bounds >> first)) continue;
+        if(!(bounds >> dash >> last) || dash != '-') last = first;
+
+        for(int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::string readLine(std::string const & filename)
+{
+    std::ifstream file(filename);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// CPUs the process may run on
+std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+
+    #if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(::sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+        }
+    }
+    #endif
+
+    if(cpus.empty())
+    {
+        int const ncpus = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for(int cpu = 0; cpu < ncpus; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+NumaTopology detectTopology()
+{
+    std::vector<int> const allowed = allowedCpus();
+
+    NumaTopology topology;
+
+    #if defined(__linux__)
+    std::string const root = "/sys/devices/system/node/";
+    for(int node : parseCpuList(readLine(root + "online")))
+    {
+        std::vector<int> cpus;
+        for(int cpu : parseCpuList(readLine(root + "node" + std::to_string(node) + "/cpulist")))
+        {
+            if(std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) cpus.push_back(cpu);
+        }
+
+        // Nodes without CPUs (memory only, or outside of the affinity) run no thread
+        if(!cpus.empty()) topology.nodes.push_back(cpus);
+    }
+    #endif
+
+    if(topology.nodes.empty()) topology.nodes.push_back(allowed);
+    return topology;
+}
+
+#if defined(__linux__)
+
+// Run the calling thread on the given CPUs only
+bool setAffinity(std::vector<int> const & cpus)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus)
+    {
+        if(cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) > 0 && ::sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+#endif
+
+}
+
+NumaTopology const & numaTopology()
+{
+    static NumaTopology const topology = detectTopology();
+    return topology;
+}
+
+std::size_t threadNode(std::size_t thread, std::size_t nthreads, std::size_t nnodes)
+{
+    if(nthreads == 0 || nnodes == 0) return 0;
+    return std::min(thread * nnodes / nthreads, nnodes - 1);
+}
+
+bool pinThreads()
+{
+    #if defined(__linux__)
+    // Detected before any thread is pinned
+    NumaTopology const & topology = numaTopology();
+    std::size_t const nnodes = topology.nodes.size();
+
+    bool pinned = true;
+
+    #pragma omp parallel reduction(&&: pinned)
+    {
+        #ifdef _OPENMP
+        std::size_t const thread = omp_get_thread_num();
+        std::size_t const nthreads = omp_get_num_threads();
+        #else
+        std::size_t const thread = 0;
+        std::size_t const nthreads = 1;
+        #endif
+
+        std::size_t const node = threadNode(thread, nthreads, nnodes);
+        std::size_t const first = (node * nthreads + nnodes - 1) / nnodes;
+        std::vector<int> const & cpus = topology.nodes[node];
+        pinned = setAffinity({ cpus[(thread - first) % cpus.size()] });
+    }
+
+    return pinned;
+    #else
+    return false;
+    #endif
+}
+
+bool unpinThreads()
+{
+    // Detected before the threads change their affinity
+    numaTopology();
+
+    bool unpinned = true;
+
+    #pragma omp parallel reduction(&&: unpinned)
+    unpinned = unpinCurrentThread();
+
+    return unpinned;
+}
+
+bool unpinCurrentThread()
+{
+    #if defined(__linux__)
+    std::vector<int> cpus;
+    for(auto const & node : numaTopology().nodes)
+    {
+        cpus.insert(cpus.end(), node.begin(), node.end());
+    }
+
+    return setAffinity(cpus);
+    #else
+    return false;
+    #endif
+}
+
+ShardedSchedule::ShardedSchedule(std::size_t n, std::size_t nshards, std::size_t chunk):
+    m_nshards(std::max<std::size_t>(nshards, 1)),
+    m_chunk(std::max<std::size_t>(chunk, 1)),
+    m_shards(new Shard[m_nshards])
+{
+    for(auto s = 0u; s < m_nshards; ++s)
+    {
+        m_shards[s].next.store(n * s / m_nshards, std::memory_order_relaxed);
+        m_shards[s].end = n * (s + 1) / m_nshards;
+    }
+}
+
+std::size_t ShardedSchedule::getShardCount() const
+{
+    return m_nshards;
+}
+
+bool ShardedSchedule::next(std::size_t shard, std::size_t & begin, std::size_t & end)
+{
+    for(auto k = 0u; k < m_nshards; ++k)
+    {
+        Shard & s = m_shards[(shard + k) % m_nshards];
+
+        // Drained shards are skipped without touching their line exclusively
+        if(s.next.load(std::memory_order_relaxed) >= s.end) continue;
+
+        std::size_t const first = s.next.fetch_add(m_chunk, std::memory_order_relaxed);
+        if(first >= s.end) continue;
+
+        begin = first;
+        end = std::min(first + m_chunk, s.end);
+        return true;
+    }
+    return false;
+}
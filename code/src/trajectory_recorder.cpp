@@ -0,0 +1,294 @@
+#include <trajectory_recorder.hpp>
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NeuroCar {
+
+namespace {
+
+char const MAGIC[4] = { 'N', 'C', 'T', 'R' };
+uint32_t const VERSION = 1;
+
+static_assert(sizeof(TrajectoryHeader) == 28, "Trace blocks assume a packed header");
+
+// Fixed-point scales of the recorded values
+float const POSITION_SCALE = 256.0f;
+float const ANGLE_SCALE    = 4096.0f;
+float const INPUT_SCALE    = 256.0f;
+float const OUTPUT_SCALE   = 255.0f;
+
+inline int32_t toFixed(double value, float scale)
+{
+    return static_cast<int32_t>(std::lround(value * scale));
+}
+
+inline uint32_t zigzag(int32_t v)
+{
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v)
+{
+    return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+}
+
+inline void putVarint(std::vector<uint8_t> & out, uint32_t v)
+{
+    while(v >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline bool getVarint(uint8_t const * & p, uint8_t const * end, uint32_t & v)
+{
+    v = 0;
+    for(auto shift = 0u; shift < 35 && p < end; shift += 7)
+    {
+        uint8_t const byte = *p++;
+        v |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool decodeBlocks(uint8_t const * data, std::size_t size, TrajectoryCallback const & callback)
+{
+    uint8_t const * p = data;
+    uint8_t const * const end = data + size;
+
+    if(size < sizeof(MAGIC) + sizeof(uint32_t)) return false;
+    if(std::memcmp(p, MAGIC, sizeof(MAGIC)) != 0) return false;
+    p += sizeof(MAGIC);
+
+    uint32_t version = 0;
+    std::memcpy(&version, p, sizeof(version));
+    if(version != VERSION) return false;
+    p += sizeof(version);
+
+    std::vector<TrajectoryFrame> frames;
+    std::vector<int32_t> previous;
+
+    while(p + sizeof(TrajectoryHeader) <= end)
+    {
+        TrajectoryHeader header;
+        std::memcpy(&header, p, sizeof(header));
+        p += sizeof(header);
+
+        uint8_t const * block = p;
+        uint8_t const * const blockEnd = p + header.payloadSize;
+        if(blockEnd > end) return false;
+
+        std::size_t const channels = 3 + header.ninputs + header.noutputs + 1;
+        previous.assign(channels, 0);
+        frames.resize(header.nframes);
+
+        for(auto & frame : frames)
+        {
+            for(auto c = 0u; c < channels; ++c)
+            {
+                uint32_t v = 0;
+                if(!getVarint(block, blockEnd, v)) return false;
+                previous[c] += unzigzag(v);
+            }
+
+            frame.x = previous[0] / POSITION_SCALE;
+            frame.y = previous[1] / POSITION_SCALE;
+            frame.angle = previous[2] / ANGLE_SCALE;
+            frame.inputs.resize(header.ninputs);
+            for(auto i = 0u; i < header.ninputs; ++i)
+            {
+                frame.inputs[i] = previous[3 + i] / INPUT_SCALE;
+            }
+            frame.outputs.resize(header.noutputs);
+            for(auto i = 0u; i < header.noutputs; ++i)
+            {
+                frame.outputs[i] = previous[3 + header.ninputs + i] / OUTPUT_SCALE;
+            }
+            frame.flags = static_cast<uint32_t>(previous[channels - 1]);
+        }
+
+        callback(header, frames);
+        p = blockEnd;
+    }
+
+    return true;
+}
+
+}
+
+struct TrajectoryRecorder::Buffer
+{
+    TrajectoryRecorder const * owner = nullptr;
+    bool active = false;
+    TrajectoryHeader header;
+    std::size_t channels = 0;
+    std::vector<int32_t> values; // Fixed-point frames, one row per frame
+    std::vector<uint8_t> payload;
+};
+
+TrajectoryRecorder::TrajectoryRecorder(std::string const & filename, std::size_t bufferFrames):
+    m_mutex(),
+    m_file(filename, std::ios::out | std::ios::binary | std::ios::trunc),
+    m_bufferFrames(bufferFrames)
+{
+    m_file.write(MAGIC, sizeof(MAGIC));
+    m_file.write(reinterpret_cast<char const *>(&VERSION), sizeof(VERSION));
+}
+
+bool TrajectoryRecorder::isOpen() const
+{
+    return static_cast<bool>(m_file);
+}
+
+TrajectoryRecorder::Buffer & TrajectoryRecorder::localBuffer()
+{
+    thread_local Buffer buffer;
+    if(buffer.owner != this)
+    {
+        buffer = Buffer();
+        buffer.owner = this;
+    }
+    return buffer;
+}
+
+void TrajectoryRecorder::beginEpisode(uint32_t generation, uint32_t rank, uint32_t worldSeed)
+{
+    Buffer & buffer = this->localBuffer();
+    buffer.active = true;
+    buffer.header = TrajectoryHeader();
+    buffer.header.generation = generation;
+    buffer.header.rank = rank;
+    buffer.header.worldSeed = worldSeed;
+    buffer.channels = 0;
+    buffer.values.clear();
+}
+
+void TrajectoryRecorder::record(
+    b2Vec2 const & pos, float angle,
+    Weight const * inputs, std::size_t ninputs,
+    Weight const * outputs, std::size_t noutputs,
+    uint32_t flags
+)
+{
+    Buffer & buffer = this->localBuffer();
+    if(!buffer.active) return;
+
+    if(buffer.channels == 0)
+    {
+        buffer.header.ninputs = static_cast<uint16_t>(ninputs);
+        buffer.header.noutputs = static_cast<uint16_t>(noutputs);
+        buffer.channels = 3 + ninputs + noutputs + 1;
+
+        // Allocated once per thread, then reused by every episode
+        buffer.values.reserve(m_bufferFrames * buffer.channels);
+    }
+
+    if(buffer.header.nframes == m_bufferFrames)
+    {
+        this->flush(buffer);
+        ++buffer.header.part;
+    }
+
+    buffer.values.push_back(toFixed(pos.x, POSITION_SCALE));
+    buffer.values.push_back(toFixed(pos.y, POSITION_SCALE));
+    buffer.values.push_back(toFixed(angle, ANGLE_SCALE));
+    for(auto i = 0u; i < ninputs; ++i)
+    {
+        buffer.values.push_back(toFixed(inputs[i], INPUT_SCALE));
+    }
+    for(auto i = 0u; i < noutputs; ++i)
+    {
+        buffer.values.push_back(outputs ? toFixed(outputs[i], OUTPUT_SCALE) : 0);
+    }
+    buffer.values.push_back(static_cast<int32_t>(flags));
+
+    ++buffer.header.nframes;
+}
+
+void TrajectoryRecorder::endEpisode()
+{
+    Buffer & buffer = this->localBuffer();
+    if(!buffer.active) return;
+
+    this->flush(buffer);
+    buffer.active = false;
+}
+
+void TrajectoryRecorder::flush(Buffer & buffer)
+{
+    if(buffer.header.nframes == 0) return;
+
+    // Delta-encode each channel from the previous frame of the block
+    std::size_t const channels = buffer.channels;
+    buffer.payload.clear();
+    for(auto f = 0u; f < buffer.header.nframes; ++f)
+    {
+        int32_t const * row = &buffer.values[f * channels];
+        for(auto c = 0u; c < channels; ++c)
+        {
+            int32_t const previous = f > 0 ? row[c - channels] : 0;
+            putVarint(buffer.payload, zigzag(row[c] - previous));
+        }
+    }
+
+    buffer.header.payloadSize = static_cast<uint32_t>(buffer.payload.size());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_file.write(reinterpret_cast<char const *>(&buffer.header), sizeof(buffer.header));
+        m_file.write(
+            reinterpret_cast<char const *>(buffer.payload.data()),
+            static_cast<std::streamsize>(buffer.payload.size())
+        );
+        m_file.flush();
+    }
+
+    buffer.header.nframes = 0;
+    buffer.values.clear();
+}
+
+bool readTrajectories(std::string const & filename, TrajectoryCallback const & callback)
+{
+    #if defined(__unix__)
+    int const fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(::fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    std::size_t const size = static_cast<std::size_t>(st.st_size);
+    void * data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED) return false;
+
+    bool const ok = decodeBlocks(static_cast<uint8_t const *>(data), size, callback);
+    ::munmap(data, size);
+    return ok;
+    #else
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if(!file) return false;
+    std::vector<char> data(
+        (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+    );
+    return decodeBlocks(
+        reinterpret_cast<uint8_t const *>(data.data()), data.size(), callback
+    );
+    #endif
+}
+
+}
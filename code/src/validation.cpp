@@ -0,0 +1,192 @@
+#include <validation.hpp>
+#include <quantized_network.hpp>
+#include <world_factory.hpp>
+
+#include <serialization.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+namespace NeuroCar {
+
+namespace {
+
+bool isQuantizedFile(std::string const & filename)
+{
+    std::string const ext = ".q8";
+    return filename.size() >= ext.size() &&
+        filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool loadController(std::string const & filename, NeuroController & nc)
+{
+    if(isQuantizedFile(filename))
+    {
+        auto qnn = std::make_shared<QuantizedNetwork>();
+        if(!loadFromFile(filename, *qnn)) return false;
+
+        nc.setQuantizedNetwork(qnn);
+        nc.setInference(NeuroController::Inference::Quantized);
+        return true;
+    }
+
+    NeuroEvolution::NeuralNetwork nn;
+    if(!loadFromFile(filename, nn)) return false;
+
+    nc = NeuroController(nn);
+    return true;
+}
+
+// Nearest-rank percentile of sorted values
+double percentile(std::vector<double> const & sorted, double p)
+{
+    std::size_t const n = sorted.size();
+    std::size_t const index = static_cast<std::size_t>(std::round(p * (n - 1)));
+    return sorted[std::min(index, n - 1)];
+}
+
+}
+
+std::vector<ValidationResult> validateNetworks(
+    CarDef const & carDef,
+    DNAParams<SelfDrivingCarDNA> const & dnaParams,
+    b2Vec2 const & destination,
+    ValidationParams const & params
+)
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<uint32_t> periods = params.controlPeriods;
+    if(periods.empty()) periods.push_back(dnaParams.controlPeriod);
+
+    std::size_t const nfiles = params.networkFiles.size();
+    std::size_t const nseeds = params.nseeds;
+
+    std::vector<NeuroController> controllers(nfiles);
+    std::vector<bool> loaded(nfiles);
+    for(auto f = 0u; f < nfiles; ++f)
+    {
+        loaded[f] = loadController(params.networkFiles[f], controllers[f]);
+    }
+
+    // One variant per (network, control period, inference). A quantized
+    // network always runs quantized: it has no sparse variant to compare.
+    std::vector<ValidationResult> results;
+    std::vector<std::size_t> files;
+    for(auto f = 0u; f < nfiles; ++f)
+    {
+        bool const quantized = isQuantizedFile(params.networkFiles[f]);
+        std::size_t const ninferences = params.compareSparse && !quantized ? 2 : 1;
+
+        for(auto period : periods)
+        {
+            for(auto i = 0u; i < ninferences; ++i)
+            {
+                ValidationResult result;
+                result.filename = params.networkFiles[f];
+                result.loaded = loaded[f];
+                result.controlPeriod = period;
+                result.quantized = quantized;
+                result.sparse = !quantized &&
+                    (params.compareSparse ? i == 1 : dnaParams.sparseInference);
+                results.push_back(result);
+                files.push_back(f);
+            }
+        }
+    }
+
+    std::size_t const nnetworks = results.size();
+    std::vector<DNAParams<SelfDrivingCarDNA>> variantParams(nnetworks, dnaParams);
+    for(auto n = 0u; n < nnetworks; ++n)
+    {
+        variantParams[n].controlPeriod = results[n].controlPeriod;
+        variantParams[n].sparseInference = results[n].sparse;
+    }
+
+    auto const createCar = [&carDef](int32_t seed)
+    {
+        auto sdCar = createIndividual<SelfDrivingCar>();
+        sdCar->setCar(std::make_shared<Car>(carDef));
+        sdCar->setWorldSeed(seed);
+        return sdCar;
+    };
+
+    // Search the valid world of each seed once for all the networks
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(auto s = 0u; s < nseeds; ++s)
+    {
+        SelfDrivingCarDNA dna(createCar(params.firstSeed + s));
+        dna.init(dnaParams);
+        findValidSeed(dnaParams, dna.getSubject()->getCar(), dna.getWorldSeed(0));
+    }
+
+    std::size_t const npairs = nnetworks * nseeds;
+    std::vector<double> fitness(npairs, 0.0);
+    std::vector<double> seconds(npairs, 0.0);
+
+    // Seed-major order: the networks sharing a world run close in time
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(auto p = 0u; p < npairs; ++p)
+    {
+        std::size_t const s = p / nnetworks;
+        std::size_t const n = p % nnetworks;
+
+        if(!results[n].loaded) continue;
+
+        auto const start = Clock::now();
+
+        // The destination is held by the controller: set it once loaded
+        auto sdCar = createCar(params.firstSeed + s);
+        sdCar->setNeuroController(controllers[files[n]]);
+        sdCar->setDestination(destination);
+
+        SelfDrivingCarDNA dna(sdCar);
+        dna.init(variantParams[n]);
+        fitness[n * nseeds + s] = dna.computeFitness();
+
+        seconds[n * nseeds + s] = std::chrono::duration<double>(
+            Clock::now() - start
+        ).count();
+    }
+
+    for(auto n = 0u; n < nnetworks; ++n)
+    {
+        ValidationResult & result = results[n];
+        if(!result.loaded || nseeds == 0) continue;
+
+        std::vector<double> f(
+            fitness.begin() + n * nseeds, fitness.begin() + (n + 1) * nseeds
+        );
+        std::sort(f.begin(), f.end());
+
+        double sum = 0.0;
+        double sumSquares = 0.0;
+        for(auto x : f)
+        {
+            sum += x;
+            sumSquares += x * x;
+            if(x >= params.successFitness) ++result.successes;
+        }
+
+        double const count = static_cast<double>(nseeds);
+        result.episodes = nseeds;
+        result.mean = sum / count;
+        result.stddev = std::sqrt(std::max(0.0, sumSquares / count - result.mean * result.mean));
+        result.min = f.front();
+        result.p10 = percentile(f, 0.1);
+        result.median = percentile(f, 0.5);
+        result.p90 = percentile(f, 0.9);
+        result.max = f.back();
+
+        for(auto s = 0u; s < nseeds; ++s)
+        {
+            result.seconds += seconds[n * nseeds + s];
+        }
+    }
+
+    return results;
+}
+
+}
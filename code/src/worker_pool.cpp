@@ -0,0 +1,462 @@
+#include <worker_pool.hpp>
+#include <thread_placement.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__unix__)
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Messages of the parent: a batch, uint32 njobs then (uint32 job, uint32 size,
+// request) per job. Messages of the workers: a result, uint32 job, uint32
+// status (1: success), uint32 size, then the result.
+
+namespace {
+
+std::size_t const ResultHeader = 3 * sizeof(uint32_t);
+
+void append(std::vector<char> & buffer, uint32_t value)
+{
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+uint32_t load(char const * bytes)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+#if defined(__unix__)
+
+bool readAll(int socket, char * data, std::size_t size)
+{
+    while(size > 0)
+    {
+        ssize_t const n = ::read(socket, data, size);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool writeAll(int socket, char const * data, std::size_t size)
+{
+    while(size > 0)
+    {
+        ssize_t const n = ::write(socket, data, size);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+#endif
+
+}
+
+WorkerPool::WorkerPool(WorkerPoolParams const & params, Handler handler):
+    m_params(params),
+    m_handler(std::move(handler)),
+    m_workers()
+{
+    std::size_t nworkers = m_params.nworkers;
+    if(nworkers == 0)
+    {
+        #ifdef _OPENMP
+        nworkers = static_cast<std::size_t>(omp_get_max_threads());
+        #else
+        nworkers = std::max(1u, std::thread::hardware_concurrency());
+        #endif
+    }
+
+    m_params.batchSize = std::max<std::size_t>(m_params.batchSize, 1);
+    m_params.batchesInFlight = std::max<std::size_t>(m_params.batchesInFlight, 1);
+    m_params.maxAttempts = std::max<std::size_t>(m_params.maxAttempts, 1);
+
+    m_workers.resize(nworkers);
+    for(auto & worker : m_workers) this->spawn(worker);
+}
+
+WorkerPool::~WorkerPool()
+{
+    // The workers exit at the end of their input
+    for(auto & worker : m_workers) this->stop(worker, false);
+}
+
+bool WorkerPool::isOpen() const
+{
+    return std::any_of(m_workers.begin(), m_workers.end(), [](Worker const & worker)
+    {
+        return worker.socket >= 0;
+    });
+}
+
+std::size_t WorkerPool::size() const
+{
+    return m_workers.size();
+}
+
+bool WorkerPool::spawn(Worker & worker)
+{
+    #if defined(__unix__)
+    int sockets[2];
+    if(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) return false;
+
+    pid_t const pid = ::fork();
+    if(pid < 0)
+    {
+        ::close(sockets[0]);
+        ::close(sockets[1]);
+        return false;
+    }
+
+    if(pid == 0)
+    {
+        // Worker: only keep its own end, and run on any CPU, not on the one
+        // of the thread it was forked from
+        ::close(sockets[0]);
+        unpinCurrentThread();
+        for(auto const & other : m_workers)
+        {
+            if(other.socket >= 0) ::close(other.socket);
+        }
+
+        this->serve(sockets[1]);
+        ::_exit(0);
+    }
+
+    ::close(sockets[1]);
+    ::fcntl(sockets[0], F_SETFL, ::fcntl(sockets[0], F_GETFL) | O_NONBLOCK);
+
+    worker.pid = pid;
+    worker.socket = sockets[0];
+    return true;
+    #else
+    (void) worker;
+    return false;
+    #endif
+}
+
+void WorkerPool::stop(Worker & worker, bool kill)
+{
+    #if defined(__unix__)
+    if(worker.socket >= 0) ::close(worker.socket);
+    if(worker.pid > 0)
+    {
+        if(kill) ::kill(worker.pid, SIGKILL);
+        ::waitpid(worker.pid, nullptr, 0);
+    }
+    #else
+    (void) kill;
+    #endif
+
+    worker.pid = -1;
+    worker.socket = -1;
+    worker.jobs.clear();
+    worker.output.clear();
+    worker.written = 0;
+    worker.input.clear();
+}
+
+void WorkerPool::serve(int socket) const
+{
+    #if defined(__unix__)
+    std::vector<char> request;
+    std::vector<char> result;
+    std::vector<char> message;
+
+    char header[2 * sizeof(uint32_t)];
+    while(readAll(socket, header, sizeof(uint32_t)))
+    {
+        uint32_t const njobs = load(header);
+        for(auto j = 0u; j < njobs; ++j)
+        {
+            if(!readAll(socket, header, sizeof(header))) return;
+
+            uint32_t const job = load(header);
+            request.resize(load(header + sizeof(uint32_t)));
+            if(!readAll(socket, request.data(), request.size())) return;
+
+            bool success = false;
+            result.clear();
+            try
+            {
+                success = m_handler(request.data(), request.size(), result);
+            }
+            catch(...)
+            {
+                success = false;
+            }
+            if(!success) result.clear();
+
+            message.clear();
+            append(message, job);
+            append(message, success ? 1u : 0u);
+            append(message, static_cast<uint32_t>(result.size()));
+            message.insert(message.end(), result.begin(), result.end());
+            if(!writeAll(socket, message.data(), message.size())) return;
+        }
+    }
+    #else
+    (void) socket;
+    #endif
+}
+
+WorkerPoolReport WorkerPool::run(
+    std::vector<char> const & data,
+    std::vector<std::size_t> const & offsets,
+    ResultCallback const & onResult
+)
+{
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point const start = Clock::now();
+
+    std::size_t const njobs = offsets.empty() ? 0 : offsets.size() - 1;
+
+    WorkerPoolReport report;
+    report.jobs = njobs;
+
+    std::deque<uint32_t> pending;
+    for(auto j = 0u; j < njobs; ++j) pending.push_back(j);
+
+    std::vector<uint32_t> attempts(njobs, 0);
+    std::size_t done = 0;
+
+    auto const fail = [&](uint32_t job)
+    {
+        ++report.failures;
+        ++done;
+        onResult(job, nullptr, 0);
+    };
+
+    #if defined(__unix__)
+    std::size_t const capacity = m_params.batchSize * m_params.batchesInFlight;
+    bool const timeout = m_params.jobTimeout > 0.0;
+    auto const jobTimeout = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(m_params.jobTimeout)
+    );
+    std::vector<pollfd> fds;
+    std::vector<Worker *> polled;
+
+    while(done < njobs)
+    {
+        // Keep capacity jobs in flight on each worker
+        for(auto & worker : m_workers)
+        {
+            while(worker.socket >= 0 && !pending.empty() && worker.jobs.size() < capacity)
+            {
+                std::size_t const count = std::min(
+                    {m_params.batchSize, pending.size(), capacity - worker.jobs.size()}
+                );
+
+                // An idle worker starts the first job of the batch right away
+                if(worker.jobs.empty()) worker.started = Clock::now();
+
+                append(worker.output, static_cast<uint32_t>(count));
+                for(auto c = 0u; c < count; ++c)
+                {
+                    uint32_t const job = pending.front();
+                    pending.pop_front();
+                    ++attempts[job];
+                    worker.jobs.push_back(job);
+
+                    append(worker.output, job);
+                    append(worker.output, static_cast<uint32_t>(offsets[job + 1] - offsets[job]));
+                    worker.output.insert(
+                        worker.output.end(), data.begin() + offsets[job], data.begin() + offsets[job + 1]
+                    );
+                }
+                ++report.batches;
+            }
+        }
+
+        fds.clear();
+        polled.clear();
+        Clock::time_point deadline = Clock::time_point::max();
+        for(auto & worker : m_workers)
+        {
+            if(worker.socket < 0) continue;
+
+            if(timeout && !worker.jobs.empty())
+            {
+                deadline = std::min(deadline, worker.started + jobTimeout);
+            }
+
+            pollfd fd;
+            fd.fd = worker.socket;
+            fd.events = POLLIN;
+            if(worker.written < worker.output.size()) fd.events |= POLLOUT;
+            fd.revents = 0;
+            fds.push_back(fd);
+            polled.push_back(&worker);
+        }
+
+        // Without any worker left, nothing can be evaluated anymore
+        if(fds.empty())
+        {
+            while(!pending.empty())
+            {
+                fail(pending.front());
+                pending.pop_front();
+            }
+            break;
+        }
+
+        // Wake up at the first job deadline at the latest
+        int wait = -1;
+        if(deadline != Clock::time_point::max())
+        {
+            long long const left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - Clock::now()
+            ).count() + 1;
+            wait = static_cast<int>(std::max(0LL, std::min(left, 60000LL)));
+        }
+
+        if(::poll(fds.data(), fds.size(), wait) < 0)
+        {
+            if(errno == EINTR) continue;
+            break;
+        }
+
+        for(auto p = 0u; p < fds.size(); ++p)
+        {
+            Worker & worker = *polled[p];
+            short const events = fds[p].revents;
+            bool dead = false;
+
+            if(events & POLLOUT)
+            {
+                while(worker.written < worker.output.size())
+                {
+                    ssize_t const n = ::send(
+                        worker.socket, worker.output.data() + worker.written,
+                        worker.output.size() - worker.written, MSG_NOSIGNAL
+                    );
+                    if(n > 0) worker.written += static_cast<std::size_t>(n);
+                    else if(n < 0 && errno == EAGAIN) break;
+                    else if(n < 0 && errno == EINTR) continue;
+                    else
+                    {
+                        dead = true;
+                        break;
+                    }
+                }
+
+                if(worker.written == worker.output.size())
+                {
+                    worker.output.clear();
+                    worker.written = 0;
+                }
+            }
+
+            if(!dead && (events & (POLLIN | POLLHUP | POLLERR)))
+            {
+                char buffer[1 << 16];
+                for(;;)
+                {
+                    ssize_t const n = ::recv(worker.socket, buffer, sizeof(buffer), 0);
+                    if(n > 0) worker.input.insert(worker.input.end(), buffer, buffer + n);
+                    else if(n < 0 && errno == EAGAIN) break;
+                    else if(n < 0 && errno == EINTR) continue;
+                    else
+                    {
+                        dead = true;
+                        break;
+                    }
+                }
+
+                // Complete results, in the order of completion
+                std::size_t consumed = 0;
+                while(worker.input.size() - consumed >= ResultHeader)
+                {
+                    char const * header = worker.input.data() + consumed;
+                    uint32_t const job = load(header);
+                    uint32_t const status = load(header + sizeof(uint32_t));
+                    std::size_t const size = load(header + 2 * sizeof(uint32_t));
+                    if(worker.input.size() - consumed < ResultHeader + size) break;
+
+                    auto const it = std::find(worker.jobs.begin(), worker.jobs.end(), job);
+                    if(it != worker.jobs.end())
+                    {
+                        // The worker goes on with the next job
+                        worker.jobs.erase(it);
+                        worker.started = Clock::now();
+                        if(status == 1)
+                        {
+                            ++done;
+                            onResult(job, header + ResultHeader, size);
+                        }
+                        else fail(job);
+                    }
+
+                    consumed += ResultHeader + size;
+                }
+                worker.input.erase(worker.input.begin(), worker.input.begin() + consumed);
+            }
+
+            // Hung: stuck in a job for too long
+            if(!dead && timeout && !worker.jobs.empty() &&
+                Clock::now() - worker.started > jobTimeout)
+            {
+                dead = true;
+                ++report.timeouts;
+            }
+
+            if(dead)
+            {
+                // Replace the worker, its unfinished jobs go to the others.
+                // Jobs are run in order: only the first one had started.
+                std::vector<uint32_t> jobs;
+                jobs.swap(worker.jobs);
+                this->stop(worker, true);
+                ++report.restarts;
+
+                for(auto k = 0u; k < jobs.size(); ++k)
+                {
+                    uint32_t const job = jobs[k];
+                    if(k > 0) --attempts[job];
+
+                    if(attempts[job] < m_params.maxAttempts)
+                    {
+                        pending.push_back(job);
+                        ++report.retries;
+                    }
+                    else fail(job);
+                }
+
+                this->spawn(worker);
+            }
+        }
+    }
+    #else
+    while(!pending.empty())
+    {
+        fail(pending.front());
+        pending.pop_front();
+    }
+    #endif
+
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return report;
+}
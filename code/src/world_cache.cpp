@@ -0,0 +1,214 @@
+#include <world_cache.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace NeuroCar {
+
+namespace {
+
+char const MAGIC[4] = { 'N', 'C', 'W', 'C' };
+uint32_t const VERSION = 1;
+
+struct FileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+struct Record
+{
+    uint32_t seed;
+    uint32_t width;
+    uint32_t height;
+    uint32_t nbObstacles;
+    float spawnX;
+    float spawnY;
+    uint32_t validSeed;
+    uint32_t checksum; // Of the fields above: skips damaged records
+};
+
+static_assert(sizeof(Record) == 32, "A record is 8 words");
+
+// FNV-1a of the record fields
+uint32_t checksum(Record const & record)
+{
+    unsigned char const * bytes = reinterpret_cast<unsigned char const *>(&record);
+    uint32_t h = 2166136261u;
+    for(auto i = 0u; i < offsetof(Record, checksum); ++i)
+    {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+    return h;
+}
+
+FileHeader makeHeader()
+{
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.recordSize = sizeof(Record);
+    header.reserved = 0;
+    return header;
+}
+
+#if defined(__unix__)
+// Publish a file holding only the header. Built aside then linked, so that no
+// process ever sees the file without its header.
+void createFile(std::string const & filename)
+{
+    std::string const tmp = filename + "." + std::to_string(::getpid()) + ".tmp";
+
+    int const fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return;
+
+    FileHeader const header = makeHeader();
+    bool const written = ::write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header));
+    ::close(fd);
+
+    // Fails with EEXIST when another process was faster: use its file
+    if(written) ::link(tmp.c_str(), filename.c_str());
+    ::unlink(tmp.c_str());
+}
+#endif
+
+}
+
+WorldCache::WorldCache():
+    m_filename(),
+    m_fd(-1),
+    m_loaded(0)
+{
+
+}
+
+WorldCache::~WorldCache()
+{
+    #if defined(__unix__)
+    if(m_fd >= 0) ::close(m_fd);
+    #endif
+}
+
+bool WorldCache::open(std::string const & directory)
+{
+    #if defined(__unix__)
+    if(::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) return false;
+
+    m_filename = directory + "/worlds.ncwc";
+
+    int fd = ::open(m_filename.c_str(), O_RDWR | O_APPEND);
+    if(fd < 0 && errno == ENOENT)
+    {
+        createFile(m_filename);
+        fd = ::open(m_filename.c_str(), O_RDWR | O_APPEND);
+    }
+    if(fd < 0) return false;
+
+    FileHeader header;
+    FileHeader const expected = makeHeader();
+    if(::pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+       std::memcmp(header.magic, expected.magic, sizeof(MAGIC)) != 0 ||
+       header.version != expected.version ||
+       header.recordSize != expected.recordSize)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_loaded = sizeof(FileHeader);
+    return true;
+    #else
+    static_cast<void>(directory);
+    return false;
+    #endif
+}
+
+bool WorldCache::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+std::string const & WorldCache::getFilename() const
+{
+    return m_filename;
+}
+
+std::size_t WorldCache::load(Callback const & callback)
+{
+    #if defined(__unix__)
+    if(m_fd < 0) return 0;
+
+    struct stat st;
+    if(::fstat(m_fd, &st) != 0) return 0;
+
+    // Whole records only: the last one may still be being written
+    std::size_t const size = static_cast<std::size_t>(st.st_size);
+    if(size < m_loaded + sizeof(Record)) return 0;
+    std::size_t const end = m_loaded + (size - m_loaded) / sizeof(Record) * sizeof(Record);
+
+    void * data = ::mmap(nullptr, end, PROT_READ, MAP_SHARED, m_fd, 0);
+    if(data == MAP_FAILED) return 0;
+
+    std::size_t nrecords = 0;
+    Record const * record = reinterpret_cast<Record const *>(
+        static_cast<char const *>(data) + m_loaded
+    );
+    Record const * last = reinterpret_cast<Record const *>(
+        static_cast<char const *>(data) + end
+    );
+    for(; record < last; ++record)
+    {
+        if(record->checksum != checksum(*record)) continue;
+
+        WorldKey const key = {
+            record->seed, record->width, record->height, record->nbObstacles,
+            record->spawnX, record->spawnY
+        };
+        callback(key, record->validSeed);
+        ++nrecords;
+    }
+
+    ::munmap(data, end);
+    m_loaded = end;
+    return nrecords;
+    #else
+    static_cast<void>(callback);
+    return 0;
+    #endif
+}
+
+bool WorldCache::append(WorldKey const & key, uint32_t validSeed)
+{
+    #if defined(__unix__)
+    if(m_fd < 0) return false;
+
+    Record record;
+    record.seed = key.seed;
+    record.width = key.width;
+    record.height = key.height;
+    record.nbObstacles = key.nbObstacles;
+    record.spawnX = key.spawnX;
+    record.spawnY = key.spawnY;
+    record.validSeed = validSeed;
+    record.checksum = checksum(record);
+
+    // A single write: O_APPEND makes it atomic with respect to other writers
+    return ::write(m_fd, &record, sizeof(record)) == static_cast<ssize_t>(sizeof(record));
+    #else
+    static_cast<void>(key);
+    static_cast<void>(validSeed);
+    return false;
+    #endif
+}
+
+}
@@ -0,0 +1,154 @@
+#include <world_factory.hpp>
+#include <renderer.hpp>
+
+#include <map>
+#include <mutex>
+
+namespace NeuroCar {
+
+namespace {
+
+PoolCounter worldCounter;
+
+std::mutex validSeedsMutex;
+std::map<WorldKey, uint32_t> validSeeds;
+std::unique_ptr<WorldCache> worldCache;
+
+void insertSeed(WorldKey const & key, uint32_t seed)
+{
+    validSeeds.emplace(key, seed);
+}
+
+WorldKey makeKey(WorldParams const & params, Car const & car, uint32_t seed)
+{
+    b2Vec2 const spawn = car.getInitPos();
+    WorldKey const key = {
+        seed, params.worldWidth, params.worldHeight, params.worldNbObstacles,
+        spawn.x, spawn.y
+    };
+    return key;
+}
+
+bool findCachedSeed(WorldKey const & key, uint32_t & seed)
+{
+    std::lock_guard<std::mutex> lock(validSeedsMutex);
+    auto it = validSeeds.find(key);
+
+    // Other runs may have found it since the last look
+    if(it == validSeeds.end() && worldCache && worldCache->load(insertSeed) > 0)
+    {
+        it = validSeeds.find(key);
+    }
+
+    if(it == validSeeds.end()) return false;
+    seed = it->second;
+    return true;
+}
+
+void cacheSeed(WorldKey const & key, uint32_t seed)
+{
+    std::lock_guard<std::mutex> lock(validSeedsMutex);
+    bool const inserted = validSeeds.emplace(key, seed).second;
+    if(inserted && worldCache) worldCache->append(key, seed);
+}
+
+}
+
+std::unique_ptr<World> createWorld(
+    WorldParams const & params, uint32_t seed, Renderer * renderer
+)
+{
+    uint32_t const w = params.worldWidth;
+    uint32_t const h = params.worldHeight;
+
+    worldCounter.allocated();
+
+    #if CAR_PHYSICS_GRAPHIC_MODE_SFML
+    std::unique_ptr<World> world(
+        new World(
+            params.velocityIterations, params.positionIterations, renderer,
+            params.worldSimulationRate, 2
+        )
+    );
+    #else
+    static_cast<void>(renderer);
+    std::unique_ptr<World> world(new World(
+        params.velocityIterations, params.positionIterations, params.worldSimulationRate
+    ));
+    #endif
+
+    world->addBorders(w, h);
+    world->randomize(w, h, params.worldNbObstacles, seed);
+
+    return world;
+}
+
+uint32_t findValidSeed(
+    WorldParams const & params, std::shared_ptr<Car> const & car, uint32_t seed
+)
+{
+    WorldKey const key = makeKey(params, *car, seed);
+
+    uint32_t validSeed = seed;
+    if(findCachedSeed(key, validSeed))
+    {
+        worldCounter.reused();
+        return validSeed;
+    }
+
+    // Generate worlds until one is valid
+    while(createWorld(params, validSeed)->willCollide(car))
+    {
+        ++validSeed;
+    }
+
+    cacheSeed(key, validSeed);
+
+    return validSeed;
+}
+
+std::unique_ptr<World> createValidWorld(
+    WorldParams const & params, std::shared_ptr<Car> const & car, uint32_t seed,
+    Renderer * renderer
+)
+{
+    WorldKey const key = makeKey(params, *car, seed);
+
+    uint32_t validSeed = seed;
+    if(findCachedSeed(key, validSeed))
+    {
+        worldCounter.reused();
+        return createWorld(params, validSeed, renderer);
+    }
+
+    std::unique_ptr<World> world = createWorld(params, validSeed, renderer);
+
+    // Generate worlds until one is valid
+    while(world->willCollide(car))
+    {
+        world = createWorld(params, ++validSeed, renderer);
+    }
+
+    cacheSeed(key, validSeed);
+
+    return world;
+}
+
+bool openWorldCache(std::string const & directory, std::size_t & nseeds)
+{
+    std::unique_ptr<WorldCache> cache(new WorldCache());
+    if(!cache->open(directory)) return false;
+
+    std::lock_guard<std::mutex> lock(validSeedsMutex);
+    cache->load(insertSeed);
+    nseeds = validSeeds.size();
+    worldCache = std::move(cache);
+    return true;
+}
+
+PoolCounts getWorldCounts()
+{
+    return worldCounter.counts();
+}
+
+}
@@ -0,0 +1,185 @@
+#include "test_utils.hpp"
+
+#include <dna.hpp>
+#include <evolution.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Genes
+{
+    std::vector<float> values;
+};
+
+std::mt19937 & localEngine()
+{
+    static thread_local std::mt19937 engine(std::random_device{}());
+    return engine;
+}
+
+// Fitness known in closed form. The partial and coarse evaluations are on
+// other scales, so an individual that missed its full evaluation shows.
+class TestDNA : public DNA<Genes, TestDNA>
+{
+    public:
+        TestDNA(Subject subject = nullptr): DNA(subject) { }
+
+        virtual void init(Params const &) override { }
+
+        virtual void randomize(std::size_t seed) override
+        {
+            std::mt19937 engine(static_cast<uint32_t>(seed));
+            std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+            m_subject->values.resize(32);
+            for(auto & x : m_subject->values) x = uniform(engine);
+        }
+
+        virtual Fitness computeFitness(std::size_t = 0) override
+        {
+            return m_fitness = fullFitness();
+        }
+
+        virtual Fitness computePartialFitness(std::size_t, double budget) override
+        {
+            return m_fitness = 0.5 * budget * fullFitness();
+        }
+
+        virtual Fitness computeCoarseFitness(std::size_t) override
+        {
+            return m_fitness = 1.0 + fullFitness();
+        }
+
+        virtual void reset() override { }
+
+        virtual Subject crossover(TestDNA const & partner) const override
+        {
+            auto child = std::make_shared<Genes>(*m_subject);
+            std::bernoulli_distribution coin(0.5);
+            for(auto i = 0u; i < child->values.size(); ++i)
+            {
+                if(coin(localEngine())) child->values[i] = partner.getSubject()->values[i];
+            }
+            return child;
+        }
+
+        virtual void mutate(MutationRate mutationRate) override
+        {
+            std::bernoulli_distribution mutated(mutationRate);
+            std::uniform_real_distribution<float> delta(-0.2f, 0.2f);
+            for(auto & x : m_subject->values)
+            {
+                if(mutated(localEngine())) x += delta(localEngine());
+            }
+        }
+
+        virtual float const * getFeatures(std::size_t & size) const override
+        {
+            size = m_subject->values.size();
+            return m_subject->values.data();
+        }
+
+        virtual bool setFeatures(float const * features, std::size_t size) override
+        {
+            if(size != m_subject->values.size()) return false;
+            m_subject->values.assign(features, features + size);
+            return true;
+        }
+
+        double fullFitness() const
+        {
+            double sum = 0.0;
+            for(auto x : m_subject->values) sum += (x - 0.5) * (x - 0.5);
+            return 1.0 / (1.0 + sum);
+        }
+};
+
+uint32_t const Elitism = 4;
+
+Population<Genes> population(std::size_t n)
+{
+    Population<Genes> genes;
+    for(auto i = 0u; i < n; ++i) genes.push_back(std::make_shared<Genes>());
+    return genes;
+}
+
+EvolutionParams<TestDNA> baseParams()
+{
+    EvolutionParams<TestDNA> params;
+    params.mutationRate = 0.05;
+    params.elitism = Elitism;
+    return params;
+}
+
+// The elites carried over, at the front of every generation but the first,
+// must hold their full fitness. Returns the last generation.
+DNAs<TestDNA> checkCarriedElites(EvolutionParams<TestDNA> params, std::size_t & checked)
+{
+    checked = 0;
+    params.postGenHook = [&checked](std::size_t ngen, DNAs<TestDNA> const & dnas)
+    {
+        if(ngen == 0) return;
+        for(auto e = 0u; e < Elitism && e < dnas.size(); ++e)
+        {
+            CHECK(same(dnas[e].getFitness(), dnas[e].fullFitness()));
+            ++checked;
+        }
+    };
+    return evolve<TestDNA>(population(60), 30, params);
+}
+
+void testRacingKeepsElites()
+{
+    EvolutionParams<TestDNA> params = baseParams();
+    params.racing.enabled = true;
+    params.racing.cullFraction = 0.9;
+
+    std::size_t checked = 0;
+    checkCarriedElites(params, checked);
+    CHECK(checked > 0);
+}
+
+void testScreeningSkipsElites()
+{
+    EvolutionParams<TestDNA> params = baseParams();
+    params.surrogate.enabled = true;
+    params.surrogate.screenQuantile = 0.95;
+    params.surrogate.auditFraction = 0.0;
+    params.surrogate.minSamples = 16;
+
+    std::size_t checked = 0;
+    DNAs<TestDNA> const last = checkCarriedElites(params, checked);
+    CHECK(checked > 0);
+
+    // The last generation is never screened
+    for(auto const & dna : last) CHECK(same(dna.getFitness(), dna.fullFitness()));
+}
+
+void testRefiningKeepsElites()
+{
+    EvolutionParams<TestDNA> params = baseParams();
+    params.multiFidelity.enabled = true;
+    params.multiFidelity.contenderFraction = 0.05;
+    params.multiFidelity.auditFraction = 0.0;
+    params.multiFidelity.minAgreement = -1.0;
+
+    std::size_t checked = 0;
+    DNAs<TestDNA> const last = checkCarriedElites(params, checked);
+    CHECK(checked > 0);
+
+    // The last generation is never coarsely evaluated
+    for(auto const & dna : last) CHECK(same(dna.getFitness(), dna.fullFitness()));
+}
+
+}
+
+int main()
+{
+    testRacingKeepsElites();
+    testScreeningSkipsElites();
+    testRefiningKeepsElites();
+
+    return testResult();
+}
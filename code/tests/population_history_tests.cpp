@@ -0,0 +1,89 @@
+#include "test_utils.hpp"
+
+#include <population_history.hpp>
+
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+float gene(std::size_t generation, std::size_t i, std::size_t k)
+{
+    return static_cast<float>(generation * 1000 + i * 10 + k);
+}
+
+// Generations written through the background writer read back in place
+void testRoundTrip(std::string const & filename)
+{
+    std::size_t const ngenerations = 5;
+    std::size_t const n = 7;
+    std::size_t const genomeSize = 3;
+
+    {
+        PopulationHistory history(filename);
+        CHECK(history.isOpen());
+
+        for(auto g = 0u; g < ngenerations; ++g)
+        {
+            CHECK(history.begin(g, n, genomeSize));
+            for(auto i = 0u; i < n; ++i)
+            {
+                std::vector<float> genome;
+                for(auto k = 0u; k < genomeSize; ++k) genome.push_back(gene(g, i, k));
+
+                // A short genome is padded with zeros
+                std::size_t const size = i == 0 ? genomeSize - 1 : genomeSize;
+                uint32_t const parent = g == 0 ? HistoryNoParent : uint32_t(n - 1 - i);
+                history.setRecord(i, 0.5 * i + g, parent, HistoryNoParent, genome.data(), size);
+            }
+            history.commit();
+        }
+
+        // Another genome size is refused
+        CHECK(!history.begin(ngenerations, n, genomeSize + 1));
+    }
+
+    PopulationHistoryReader reader(filename);
+    CHECK(reader.isOpen());
+    CHECK(reader.getGenomeSize() == genomeSize);
+    CHECK(reader.getGenerationCount() == ngenerations);
+
+    for(auto g = 0u; g < reader.getGenerationCount(); ++g)
+    {
+        CHECK(reader.getGeneration(g).generation == g);
+        CHECK(reader.getGeneration(g).count == n);
+
+        for(auto i = 0u; i < n; ++i)
+        {
+            HistoryRecord const & record = reader.getRecord(g, i);
+            CHECK(same(record.fitness, 0.5 * i + g));
+            CHECK(record.parents[0] == (g == 0 ? HistoryNoParent : uint32_t(n - 1 - i)));
+            CHECK(record.parents[1] == HistoryNoParent);
+
+            float const * genome = reader.getGenome(record);
+            for(auto k = 0u; k < genomeSize; ++k)
+            {
+                bool const padded = i == 0 && k == genomeSize - 1;
+                CHECK(same(genome[k], padded ? 0.0f : gene(g, i, k)));
+            }
+        }
+    }
+}
+
+}
+
+int main()
+{
+    std::string const directory = temporaryDirectory();
+    CHECK(!directory.empty());
+    if(directory.empty()) return testResult();
+
+    std::string const filename = directory + "/history.bin";
+    testRoundTrip(filename);
+
+    std::remove(filename.c_str());
+    std::remove((filename + ".idx").c_str());
+    ::rmdir(directory.c_str());
+
+    return testResult();
+}
@@ -0,0 +1,48 @@
+#ifndef NEURO_CAR_TEST_UTILS_HPP
+#define NEURO_CAR_TEST_UTILS_HPP
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <unistd.h>
+
+// Failed checks of the test, reported by testResult
+inline int & testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++testFailures(); \
+        } \
+    } while(false)
+
+// Exact equality, without tripping -Wfloat-equal
+inline bool same(double lhs, double rhs)
+{
+    return !(lhs < rhs) && !(rhs < lhs);
+}
+
+// Exit code of the test
+inline int testResult()
+{
+    if(testFailures() > 0) std::cout << testFailures() << " check(s) failed" << std::endl;
+    return testFailures() > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// New empty directory under $TMPDIR or /tmp
+inline std::string temporaryDirectory()
+{
+    char const * tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp ? tmp : "/tmp") + "/neuro_car_test_XXXXXX";
+    return ::mkdtemp(&pattern[0]) ? pattern : std::string();
+}
+
+#endif //NEURO_CAR_TEST_UTILS_HPP
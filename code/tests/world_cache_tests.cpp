@@ -0,0 +1,76 @@
+#include "test_utils.hpp"
+
+#include <world_cache.hpp>
+
+#include <cstdio>
+#include <map>
+
+using namespace NeuroCar;
+
+namespace {
+
+WorldKey key(uint32_t seed)
+{
+    return WorldKey{ seed, 1000, 500, 30, 25.0f, 250.0f };
+}
+
+// Records appended by a cache are read by another one on the same directory,
+// each record once
+void testRoundTrip(std::string const & directory)
+{
+    WorldCache writer;
+    CHECK(writer.open(directory));
+    CHECK(writer.isOpen());
+
+    WorldCache reader;
+    CHECK(reader.open(directory));
+    CHECK(reader.getFilename() == writer.getFilename());
+
+    std::map<WorldKey, uint32_t> seen;
+    auto const collect = [&seen](WorldKey const & k, uint32_t validSeed)
+    {
+        seen[k] = validSeed;
+    };
+
+    CHECK(reader.load(collect) == 0);
+
+    for(uint32_t s = 0; s < 10; ++s) CHECK(writer.append(key(s), s + 100));
+
+    CHECK(reader.load(collect) == 10);
+    CHECK(seen.size() == 10);
+    for(uint32_t s = 0; s < 10; ++s) CHECK(seen[key(s)] == s + 100);
+
+    // Only the new records on the next load
+    CHECK(writer.append(key(42), 7));
+    CHECK(reader.load(collect) == 1);
+    CHECK(seen[key(42)] == 7);
+
+    // The layout is part of the key
+    WorldKey other = key(42);
+    other.nbObstacles = 31;
+    CHECK(seen.count(other) == 0);
+
+    // A new cache reads everything again
+    WorldCache late;
+    CHECK(late.open(directory));
+    std::map<WorldKey, uint32_t> all;
+    CHECK(late.load([&all](WorldKey const & k, uint32_t validSeed) { all[k] = validSeed; }) == 11);
+    CHECK(all.size() == seen.size());
+    for(auto const & record : seen) CHECK(all[record.first] == record.second);
+}
+
+}
+
+int main()
+{
+    std::string const directory = temporaryDirectory();
+    CHECK(!directory.empty());
+    if(directory.empty()) return testResult();
+
+    testRoundTrip(directory);
+
+    std::remove((directory + "/worlds.ncwc").c_str());
+    ::rmdir(directory.c_str());
+
+    return testResult();
+}